@@ -1,28 +1,86 @@
 // #define VK_NO_PROTOTYPES
 // #define VOLK_IMPLEMENTATION
 // #include "volk.h"
-#define STB_IMAGE_IMPLEMENTATION
-#include <stb_image.h>
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #define GLM_ENABLE_EXPERIMENTAL
 
+#include <cstring>
+
 #include "Common.h"
 #include "Scene0.h"
+#include "VuAssetCache.h"
+#include "VuJobSystem.h"
 
 #include "VKSC_Utils.h"
 
 
 int main(int argc, char* argv[]) {
 
+    Vu::VuCpuProfiler::setThreadName("main");
     PrintAvailableInstanceExtensions();
     Vu::Scene0 scen{};
+    Vu::VuJobSystemCreateInfo jobInfo{};
+    Vu::VuAssetCacheCreateInfo cacheInfo{};
+    bool                       useAssetCache = true;
+
+    //--headless renders offscreen, unthrottled unless --vsync-interval-ms <ms> is given
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--headless") == 0) {
+            scen.backendInfo.headless = true;
+        } else if (std::strcmp(argv[i], "--vsync-interval-ms") == 0 && i + 1 < argc) {
+            scen.backendInfo.pacing               = Vu::VuFramePacing::SimulatedVsync;
+            scen.backendInfo.vsyncIntervalSeconds = std::atof(argv[++i]) / 1000.0;
+        } else if (std::strcmp(argv[i], "--dump") == 0 && i + 1 < argc) {
+            //--dump png|raw writes frames to --dump-dir (captures) every --dump-interval frames
+            scen.enableReadback = true;
+            ++i;
+            scen.readbackInfo.dumpFormat = std::strcmp(argv[i], "raw") == 0 ? Vu::VuFrameDumpFormat::Raw : Vu::VuFrameDumpFormat::Png;
+        } else if (std::strcmp(argv[i], "--dump-interval") == 0 && i + 1 < argc) {
+            scen.readbackInfo.interval = static_cast<Vu::uint32>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--dump-dir") == 0 && i + 1 < argc) {
+            scen.readbackInfo.dumpDirectory = argv[++i];
+        } else if (std::strcmp(argv[i], "--gpu-profile") == 0 && i + 1 < argc) {
+            //prints the gpu scope timings every n frames
+            scen.backendInfo.gpuProfiler.dumpInterval = static_cast<Vu::uint32>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--pipeline-stats") == 0 && i + 1 < argc) {
+            //per draw group vertex/fragment counts and overdraw, printed every n frames
+            scen.backendInfo.pipelineStatistics.enabled      = true;
+            scen.backendInfo.pipelineStatistics.dumpInterval = static_cast<Vu::uint32>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--cpu-trace") == 0 && i + 1 < argc) {
+            //--cpu-trace trace.json [--cpu-trace-frames n] records cpu zones and writes them after n frames
+            Vu::VuCpuProfiler::setEnabled(true);
+            scen.cpuTracePath = argv[++i];
+        } else if (std::strcmp(argv[i], "--cpu-trace-frames") == 0 && i + 1 < argc) {
+            scen.cpuTraceFrame = static_cast<Vu::uint64>(std::atoll(argv[++i]));
+        } else if (std::strcmp(argv[i], "--job-workers") == 0 && i + 1 < argc) {
+            //worker threads besides the main thread, all hardware threads but one by default
+            jobInfo.workerCount = static_cast<Vu::uint32>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--single-thread") == 0) {
+            //every job runs inline on the main thread in submission order
+            jobInfo.singleThreaded = true;
+        } else if (std::strcmp(argv[i], "--asset-cache") == 0 && i + 1 < argc) {
+            //processed meshes and textures are kept here between runs
+            cacheInfo.directory = argv[++i];
+        } else if (std::strcmp(argv[i], "--asset-cache-max-mb") == 0 && i + 1 < argc) {
+            //least recently used entries are evicted above this size, unlimited by default
+            cacheInfo.maxBytes = static_cast<Vu::uint64>(std::atoll(argv[++i])) * 1024U * 1024U;
+        } else if (std::strcmp(argv[i], "--no-asset-cache") == 0) {
+            useAssetCache = false;
+        }
+    }
 
+    Vu::VuJobSystem::init(jobInfo);
+    if (useAssetCache) {
+        Vu::VuAssetCache::init(cacheInfo);
+    }
     try {
         scen.Run();
     } catch (const std::exception& e) {
         std::puts(e.what());
         system("pause");
     }
+    Vu::VuAssetCache::uninit();
+    Vu::VuJobSystem::uninit();
     return EXIT_SUCCESS;
 }
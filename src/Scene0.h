@@ -9,38 +9,47 @@
 #include "VuMesh.h"
 #include "Transform.h"
 #include "VuAssetLoader.h"
+#include "VuDeviceSetup.h"
+#include "VuGltfImporter.h"
+#include "VuJobSystem.h"
 #include "VuResourceManager.h"
 #include "VuRenderer.h"
 #include "VuShader.h"
+#include "VuTextureStreamer.h"
+#include "VuScene.h"
 
 
 namespace Vu {
 
     struct Scene0 {
     private:
-        VuRenderer vuRenderer{};
+        VuRenderer        vuRenderer{};
+        VuTextureStreamer textureStreamer{};
 
         std::filesystem::path jetPath      = "assets/gltf/jet/jet.gltf";
         std::filesystem::path mountainPath = "assets/gltf/mountain/mountain.gltf";
 
         VuShader pbrShader{};
 
-        Transform jetTransform      = {{0, 200, 0}, glm::quat(glm::vec3{0, 0, 0}), {1, 1, 1}};
-        Transform camTransform      = {{0, 208, -15.0F}, glm::quat(glm::vec3{-0.1F, 3.1415F, 0}), {1, 1, 1}};
-        Transform mountainTransform = {{0, 0, 125}, glm::quat(glm::vec3{0, 0, 0}), {100, 100, 100}};
+        VuScene   scene{};
+        VuEntity  jet{};
+        VuEntity  mountain{};
+        Transform camTransform = {{0, 208, -15.0F}, glm::quat(glm::vec3{-0.1F, 3.1415F, 0}), {1, 1, 1}};
 
         Camera cam{};
 
-        std::chrono::time_point<std::chrono::steady_clock> prevTime{};
-
     private:
-        void renderMesh(VuMesh& mesh, VuMaterial& material, Transform trs) {
+        void renderMesh(const MeshRenderer& renderer, uint32 transform) {
+            VuMesh&     mesh     = *renderer.mesh;
+            VuMaterial& material = renderer.shader->materials[renderer.materialIndex];
 
             auto matIndex = material.index;
-            ctx::vuRenderer->bindMaterial(material);
+            requestTextureDetail(mesh, material, scene.getTransformSystem().getWorldMatrix(transform));
+            ctx::vuRenderer->bindShader(*renderer.shader);
 
             GPU_PushConstant pc{
-                trs.ToTRS(),
+                scene.getTransformSystem().getBufferIndex(ctx::vuRenderer->currentFrame),
+                transform,
                 matIndex,
                 {
                     mesh.vertexBuffer.index,
@@ -51,10 +60,29 @@ namespace Vu {
 
             ctx::vuRenderer->pushConstants(pc);
             ctx::vuRenderer->bindMesh(mesh);
-            ctx::vuRenderer->drawIndexed(mesh.indexBuffer.get()->lenght);
+            //SV_VertexID includes vertexOffset, so vertex pulling sees the absolute vertex index
+            for (const VuSubMesh& subMesh: mesh.getSubMeshRange(renderer.firstSubMesh, renderer.subMeshCount)) {
+                ctx::vuRenderer->drawIndexed(subMesh.indexCount, subMesh.firstIndex, subMesh.vertexOffset);
+            }
         }
 
 
+        //feeds the texture streamer with how large the mesh covers the screen this frame
+        void requestTextureDetail(const VuMesh& mesh, VuMaterial& material, const float4x4& world) {
+            const float  maxScale    = std::max({glm::length(float3(world[0])), glm::length(float3(world[1])), glm::length(float3(world[2]))});
+            const float3 worldCenter = float3(world * float4(mesh.boundsCenter, 1.0F));
+            const float  screenSize  = VuTextureStreamer::projectedDiameter(
+                worldCenter,
+                mesh.boundsRadius * maxScale,
+                camTransform.Position,
+                glm::radians(cam.fov),
+                static_cast<float>(ctx::vuRenderer->swapChain.swapChainExtent.height));
+
+            const GPU_PBR_MaterialData* matData = material.getPbrMaterialData();
+            textureStreamer.requestScreenSize(matData->baseColorTexture, screenSize);
+            textureStreamer.requestScreenSize(matData->normalTexture, screenSize);
+        }
+
         void updateFrameConstant() {
             ctx::frameConst.view = glm::inverse(camTransform.ToTRS());
             ctx::frameConst.proj = glm::perspective(
@@ -72,171 +100,48 @@ namespace Vu {
         }
 
     public:
-        void Run() {
-            std::vector<char> pipelineCacheBinary = readFile("assets\\shaders\\pipeline_cache.bin");
-            auto              device        = VuDevice{};
-            ctx::vuDevice                   = &device;
-
-            VkPipelineCacheCreateInfo pipelineCacheCreateInfo{
-                .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
-                .pNext = nullptr,
-                .flags = VK_PIPELINE_CACHE_CREATE_READ_ONLY_BIT | VK_PIPELINE_CACHE_CREATE_USE_APPLICATION_STORAGE_BIT,
-                .initialDataSize = pipelineCacheBinary.size(),
-                .pInitialData = pipelineCacheBinary.data()
-            };
-
-            VkPipelinePoolSize poolSize{
-                .sType = VK_STRUCTURE_TYPE_PIPELINE_POOL_SIZE,
-                .pNext = nullptr,
-                .poolEntrySize = 8U * 1024U * 1024U,
-                .poolEntryCount = 8U
-            };
-
-            VkDeviceObjectReservationCreateInfo scReservationCreateInfo{
-                .sType = VK_STRUCTURE_TYPE_DEVICE_OBJECT_RESERVATION_CREATE_INFO,
-                .pNext = nullptr,
-                .pipelineCacheCreateInfoCount = 1U,
-                .pPipelineCacheCreateInfos = &pipelineCacheCreateInfo,
-                .pipelinePoolSizeCount = 1U,
-                .pPipelinePoolSizes = &poolSize,
-                .semaphoreRequestCount = 32U,
-                .commandBufferRequestCount = 32U,
-                .fenceRequestCount = 32U,
-                .deviceMemoryRequestCount = 4096U,
-                .bufferRequestCount = 4096U,
-                .imageRequestCount = 4096U,
-                .eventRequestCount = 32U,
-                .queryPoolRequestCount = 32U,
-                .bufferViewRequestCount = 4096U,
-                .imageViewRequestCount = 4096U,
-                .layeredImageViewRequestCount = 32U,
-                .pipelineCacheRequestCount = 32U,
-                .pipelineLayoutRequestCount = 32U,
-                .renderPassRequestCount = 32U,
-                .graphicsPipelineRequestCount = 32U,
-                .computePipelineRequestCount = 32U,
-                .descriptorSetLayoutRequestCount = 32U,
-                .samplerRequestCount = 32U,
-                .descriptorPoolRequestCount = 32U,
-                .descriptorSetRequestCount = 32U,
-                .framebufferRequestCount = 32U,
-                .commandPoolRequestCount = 32U,
-                .samplerYcbcrConversionRequestCount = 0U,
-                .surfaceRequestCount = 32U,
-                .swapchainRequestCount = 32U,
-                .displayModeRequestCount = 32U,
-                .subpassDescriptionRequestCount = 32U,
-                .attachmentDescriptionRequestCount = 32U,
-                .descriptorSetLayoutBindingRequestCount = 32U,
-                .descriptorSetLayoutBindingLimit = 32U,
-                .maxImageViewMipLevels = 8U,
-                .maxImageViewArrayLayers = 8U,
-                .maxLayeredImageViewMipLevels = 8U,
-                .maxOcclusionQueriesPerPool = 32U,
-                .maxPipelineStatisticsQueriesPerPool = 32U,
-                .maxTimestampQueriesPerPool = 32U,
-                .maxImmutableSamplersPerDescriptorSetLayout = 32U,
-            };
-
-            VkPhysicalDeviceVulkanSC10Features sc10Features{
-                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_SC_1_0_FEATURES,
-                .pNext = &scReservationCreateInfo,
-                .shaderAtomicInstructions = VK_FALSE
-            };
-
-            VkPhysicalDeviceSynchronization2Features synchronization2Features{
-                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES,
-                .pNext = &sc10Features,
-                .synchronization2 = VK_TRUE
-            };
-
-            VkPhysicalDeviceVulkan12Features vkPhysicalDeviceVulkan12Features{
-                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
-                .pNext = &synchronization2Features,
-                .samplerMirrorClampToEdge = VK_FALSE,
-                .drawIndirectCount = VK_FALSE,
-                .storageBuffer8BitAccess = VK_FALSE,
-                .uniformAndStorageBuffer8BitAccess = VK_FALSE,
-                .storagePushConstant8 = VK_FALSE,
-                .shaderBufferInt64Atomics = VK_FALSE,
-                .shaderSharedInt64Atomics = VK_FALSE,
-                .shaderFloat16 = VK_FALSE,
-                .shaderInt8 = VK_FALSE,
-                .descriptorIndexing = VK_TRUE,
-                .shaderInputAttachmentArrayDynamicIndexing = VK_TRUE,
-                .shaderUniformTexelBufferArrayDynamicIndexing = VK_TRUE,
-                .shaderStorageTexelBufferArrayDynamicIndexing = VK_TRUE,
-                .shaderUniformBufferArrayNonUniformIndexing = VK_TRUE,
-                .shaderSampledImageArrayNonUniformIndexing = VK_TRUE,
-                .shaderStorageBufferArrayNonUniformIndexing = VK_TRUE,
-                .shaderStorageImageArrayNonUniformIndexing = VK_TRUE,
-                .shaderInputAttachmentArrayNonUniformIndexing = VK_TRUE,
-                .shaderUniformTexelBufferArrayNonUniformIndexing = VK_TRUE,
-                .shaderStorageTexelBufferArrayNonUniformIndexing = VK_TRUE,
-                .descriptorBindingUniformBufferUpdateAfterBind = VK_TRUE,
-                .descriptorBindingSampledImageUpdateAfterBind = VK_TRUE,
-                .descriptorBindingStorageImageUpdateAfterBind = VK_TRUE,
-                .descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE,
-                .descriptorBindingUniformTexelBufferUpdateAfterBind = VK_TRUE,
-                .descriptorBindingStorageTexelBufferUpdateAfterBind = VK_TRUE,
-                .descriptorBindingUpdateUnusedWhilePending = VK_TRUE,
-                .descriptorBindingPartiallyBound = VK_TRUE,
-                .descriptorBindingVariableDescriptorCount = VK_FALSE,
-                .runtimeDescriptorArray = VK_TRUE,
-                .samplerFilterMinmax = VK_FALSE,
-                .scalarBlockLayout = VK_TRUE,
-                .imagelessFramebuffer = VK_FALSE,
-                .uniformBufferStandardLayout = VK_FALSE,
-                .shaderSubgroupExtendedTypes = VK_FALSE,
-                .separateDepthStencilLayouts = VK_FALSE,
-                .hostQueryReset = VK_FALSE,
-                .timelineSemaphore = VK_FALSE,
-                .bufferDeviceAddress = VK_TRUE,
-                .bufferDeviceAddressCaptureReplay = VK_FALSE,
-                .bufferDeviceAddressMultiDevice = VK_FALSE,
-                .vulkanMemoryModel = VK_FALSE,
-                .vulkanMemoryModelDeviceScope = VK_FALSE,
-                .vulkanMemoryModelAvailabilityVisibilityChains = VK_FALSE,
-                .shaderOutputViewportIndex = VK_FALSE,
-                .shaderOutputLayer = VK_FALSE,
-                .subgroupBroadcastDynamicId = VK_FALSE,
-            };
-
-
-            VkPhysicalDeviceFeatures2 deviceFeatures2{
-                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
-                .pNext = &vkPhysicalDeviceVulkan12Features,
-                .features = {
-                    .samplerAnisotropy = VK_TRUE,
-                    .shaderInt64 = VK_TRUE
-                },
-            };
+        //set before Run(), e.g. headless for machines without a display
+        VuRenderBackendInfo backendInfo{};
+        //copies finished frames back to the host when enabled, see VuFrameReadback
+        bool                      enableReadback = false;
+        VuFrameReadbackCreateInfo readbackInfo{};
+        //the cpu zones of the first cpuTraceFrame frames are written here as chrome trace json, empty never writes
+        std::filesystem::path cpuTracePath;
+        uint64                cpuTraceFrame = 600;
 
+        void Run() {
+            VuDeviceSetup deviceSetup{};
+            deviceSetup.init(backendInfo);
+            auto device   = VuDevice{};
+            ctx::vuDevice = &device;
 
-            vuRenderer.init(pipelineCacheBinary,deviceFeatures2,pipelineCacheCreateInfo);
+            vuRenderer.init(deviceSetup.pipelineCacheBinary.bytes(), deviceSetup.deviceFeatures2, deviceSetup.pipelineCacheCreateInfo, backendInfo);
             ctx::vuRenderer = &vuRenderer;
+            if (enableReadback) {
+                vuRenderer.enableFrameReadback(readbackInfo);
+            }
 
-            VuMesh jetMesh{};
-            VuAssetLoader::LoadGltf(jetPath, jetMesh);
-
-            VuHandle<VuTexture> jetBaseColorTexture;
-            jetBaseColorTexture.createHandle()->init({"assets/gltf/jet/textures/texture_baseColor.png"});
-            VuResourceManager::writeSampledImageToGlobalPool(jetBaseColorTexture.index, jetBaseColorTexture.get()->imageView);
+            //textures only read their headers here, the pixels arrive over the next frames
+            textureStreamer.init({});
 
-            VuHandle<VuTexture> jetNormalTexture;
-            jetNormalTexture.createHandle()->init({"assets/gltf/jet/textures/texture_normal.png"});
-            VuResourceManager::writeSampledImageToGlobalPool(jetNormalTexture.index, jetNormalTexture.get()->imageView);
+            scene.init({});
+            jet      = scene.createEntity({{0, 200, 0}, glm::quat(glm::vec3{0, 0, 0}), {1, 1, 1}});
+            mountain = scene.createEntity({{0, 0, 125}, glm::quat(glm::vec3{0, 0, 0}), {100, 100, 100}});
 
-            VuMesh mountainMesh{};
-            VuAssetLoader::LoadGltf(mountainPath, mountainMesh);
+            //both files parse on the workers while textures register and the pipeline is created, the shader
+            //only has to be ready once the batch uploads
+            VuGltfScene  jetModel{};
+            VuGltfScene  mountainModel{};
+            VuAssetBatch assets{};
+            assets.addScene(jetPath, {&pbrShader, &textureStreamer}, jetModel);
+            assets.addScene(mountainPath, {&pbrShader, &textureStreamer}, mountainModel);
+            assets.start();
 
-            VuHandle<VuTexture> mountainBaseColorTexture;
-            mountainBaseColorTexture.createHandle()->init({"assets/gltf/mountain/textures/texture_baseColor.png"});
-            VuResourceManager::writeSampledImageToGlobalPool(mountainBaseColorTexture.index, mountainBaseColorTexture.get()->imageView);
+            VuHandle<VuTexture> jetBaseColorTexture = textureStreamer.registerTexture({"assets/gltf/jet/textures/texture_baseColor.png"});
+            VuHandle<VuTexture> jetNormalTexture = textureStreamer.registerTexture({"assets/gltf/jet/textures/texture_normal.png", VK_FORMAT_R8G8B8A8_UNORM});
 
-            VuHandle<VuTexture> mountainNormalTexture;
-            mountainNormalTexture.createHandle()->init({"assets/gltf/mountain/textures/texture_normal.png"});
-            VuResourceManager::writeSampledImageToGlobalPool(mountainNormalTexture.index, mountainNormalTexture.get()->imageView);
+            VuHandle<VuTexture> mountainBaseColorTexture = textureStreamer.registerTexture({"assets/gltf/mountain/textures/texture_baseColor.png"});
+            VuHandle<VuTexture> mountainNormalTexture = textureStreamer.registerTexture({"assets/gltf/mountain/textures/texture_normal.png", VK_FORMAT_R8G8B8A8_UNORM});
 
             pbrShader.initAsGraphicsShader(
                 {
@@ -247,37 +152,71 @@ namespace Vu {
 
             uint32                jetMaterial = pbrShader.createMaterial();
             GPU_PBR_MaterialData* jetMatData  = pbrShader.materials[jetMaterial].getPbrMaterialData();
-            jetMatData->baseColorTexture      = jetBaseColorTexture.index;
-            jetMatData->normalTexture         = jetNormalTexture.index;
+            textureStreamer.linkSlot(jetBaseColorTexture, jetMatData->baseColorTexture);
+            textureStreamer.linkSlot(jetNormalTexture, jetMatData->normalTexture);
             jetMatData->baseColorMul          = {1, 1, 1};
+            jetMatData->sampler               = vuRenderer.defaultSampler;
 
 
             uint32                mountainMaterial = pbrShader.createMaterial();
             GPU_PBR_MaterialData* mountainMatData  = pbrShader.materials[mountainMaterial].getPbrMaterialData();
-            mountainMatData->baseColorTexture      = mountainBaseColorTexture.index;
-            mountainMatData->normalTexture         = mountainNormalTexture.index;
+            textureStreamer.linkSlot(mountainBaseColorTexture, mountainMatData->baseColorTexture);
+            textureStreamer.linkSlot(mountainNormalTexture, mountainMatData->normalTexture);
             mountainMatData->baseColorMul          = {0.2F, 1, 0.2F};
+            mountainMatData->sampler               = VuSamplerCache::getOrCreate({.maxAnisotropy = 8.0F});
 
-            prevTime = std::chrono::high_resolution_clock::now();
+            {
+                VU_CPU_ZONE("load gltf");
+                assets.wait();
+            }
+            //the files carry no materials, their primitives fall back to the hand made ones
+            jetModel.instantiate(scene, jetMaterial, jet);
+            mountainModel.instantiate(scene, mountainMaterial, mountain);
+
+            uint64 frame = 0;
             while (!vuRenderer.shouldWindowClose()) {
+                VU_CPU_ZONE("frame");
                 ctx::PreUpdate();
                 ctx::UpdateInput();
 
-                std::chrono::duration<double> deltaTime = std::chrono::high_resolution_clock::now() - prevTime;
-                prevTime                                = std::chrono::high_resolution_clock::now();
-
-                mountainTransform.Position.z -= 10.0F * deltaTime.count();
+                VuTransformSystem& transforms       = scene.getTransformSystem();
+                const uint32       mountainId       = scene.getTransformId(mountain);
+                float3             mountainPosition = transforms.getPosition(mountainId);
+                mountainPosition.z -= 10.0F * ctx::deltaAsSecond;
+                transforms.setPosition(mountainId, mountainPosition);
+                scene.forEach<Spinn>([&](VuEntity, uint32 transform, Spinn& spinn) {
+                    transforms.setRotation(transform, glm::angleAxis(spinn.angle * ctx::deltaAsSecond, spinn.axis) * transforms.get(transform).Rotation);
+                });
 
                 updateFrameConstant();
+                textureStreamer.update();
+                //queue submissions and other device work the jobs handed back to this thread
+                VuJobSystem::runMainThreadJobs();
                 vuRenderer.beginFrame();
-                renderMesh(jetMesh, pbrShader.materials[jetMaterial], jetTransform);
-                renderMesh(mountainMesh, pbrShader.materials[mountainMaterial], mountainTransform);
+                scene.update(vuRenderer.currentFrame);
+                {
+                    VU_CPU_ZONE("record draws");
+                    vuRenderer.beginGpuScope("meshes");
+                    vuRenderer.beginDrawGroup("meshes");
+                    scene.forEach<MeshRenderer>([&](VuEntity, uint32 transform, MeshRenderer& renderer) {
+                        renderMesh(renderer, transform);
+                    });
+                    vuRenderer.endDrawGroup();
+                    vuRenderer.endGpuScope();
+                }
                 vuRenderer.endFrame();
+
+                if (!cpuTracePath.empty() && ++frame == cpuTraceFrame) {
+                    VuCpuProfiler::exportChromeTrace(cpuTracePath);
+                }
             }
 
 
             vuRenderer.waitIdle();
-            jetMesh.uninit();
+            textureStreamer.uninit();
+            scene.uninit();
+            jetModel.uninit();
+            mountainModel.uninit();
             vuRenderer.uninit();
         }
     };
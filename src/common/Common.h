@@ -9,6 +9,10 @@
 //#define VK_USE_PLATFORM_WIN32_KHR
 #include "vulkan/vulkan_sc.h"
 
+//sse2 is the baseline of every x64 target, the simd paths fall back to scalar code elsewhere
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VU_SSE2 1
+#endif
 
 
 namespace Vu {
@@ -20,6 +24,7 @@ namespace Vu {
     using int8  = int8_t;
     using int16 = int16_t;
     using int32 = int32_t;
+    using int64 = int64_t;
 
     using float2   = glm::vec2;
     using float3   = glm::vec3;
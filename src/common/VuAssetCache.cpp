@@ -0,0 +1,240 @@
+#include "VuAssetCache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "VuFile.h"
+
+namespace Vu {
+
+    namespace {
+        constexpr uint64 HASH_PRIME = 0x9E3779B97F4A7C15ULL;
+        //bumping it drops every entry written before
+        constexpr uint64 CACHE_VERSION = 1U;
+        constexpr size_t READ_CHUNK    = 1U << 20U;
+
+        //murmur3 finalizer
+        uint64 mix(uint64 value) {
+            value ^= value >> 33U;
+            value *= 0xFF51AFD7ED558CCDULL;
+            value ^= value >> 33U;
+            value *= 0xC4CEB9FE1A85EC53ULL;
+            value ^= value >> 33U;
+            return value;
+        }
+
+        int64 writeTimeOf(const std::filesystem::path& path, std::error_code& error) {
+            return static_cast<int64>(std::filesystem::last_write_time(path, error).time_since_epoch().count());
+        }
+    }
+
+    void VuAssetCache::init(const VuAssetCacheCreateInfo& info) {
+        createInfo = info;
+        std::error_code error;
+        std::filesystem::create_directories(createInfo.directory, error);
+        if (error) {
+            std::cout << "[WARNING]: asset cache disabled, " << createInfo.directory.string() << ": " << error.message() << std::endl;
+            enabled = false;
+            return;
+        }
+        enabled = true;
+        readIndex();
+        if (createInfo.maxBytes != 0U) {
+            evict(createInfo.maxBytes);
+        }
+    }
+
+    void VuAssetCache::uninit() {
+        if (!enabled) {
+            return;
+        }
+        if (createInfo.maxBytes != 0U) {
+            evict(createInfo.maxBytes);
+        }
+        writeIndex();
+        sources.clear();
+        enabled = false;
+    }
+
+    bool VuAssetCache::isEnabled() {
+        return enabled;
+    }
+
+    uint64 VuAssetCache::keyOf(std::span<const std::filesystem::path> sourcePaths, std::string_view settings) {
+        uint64 key = hashBytes({reinterpret_cast<const uint8 *>(settings.data()), settings.size()}, CACHE_VERSION);
+        for (const std::filesystem::path& source: sourcePaths) {
+            const uint64 sourceHash = hashSource(source);
+            key = hashBytes({reinterpret_cast<const uint8 *>(&sourceHash), sizeof(sourceHash)}, key);
+        }
+        return key;
+    }
+
+    std::filesystem::path VuAssetCache::find(uint64 key, std::string_view extension) {
+        if (!enabled) {
+            return {};
+        }
+        const std::filesystem::path path = pathOf(key, extension);
+        std::error_code             error;
+        if (!std::filesystem::exists(path, error)) {
+            return {};
+        }
+        //the write time doubles as the last use for evict
+        std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), error);
+        return path;
+    }
+
+    void VuAssetCache::store(uint64 key, std::string_view extension, const std::function<void(const std::filesystem::path&)>& write) {
+        if (!enabled) {
+            return;
+        }
+        const std::filesystem::path path = pathOf(key, extension);
+        //two threads may process the same asset, each writes its own file and the last rename wins
+        std::filesystem::path temp = path;
+        temp += ".tmp" + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+
+        std::error_code error;
+        try {
+            write(temp);
+            std::filesystem::rename(temp, path, error);
+            if (error) {
+                throw std::runtime_error(error.message());
+            }
+        } catch (const std::exception& e) {
+            std::cout << "[WARNING]: asset cache could not store " << path.string() << ": " << e.what() << std::endl;
+            std::filesystem::remove(temp, error);
+        }
+    }
+
+    void VuAssetCache::evict(uint64 maxBytes) {
+        struct Entry {
+            std::filesystem::file_time_type time;
+            uint64                          size;
+            std::filesystem::path           path;
+        };
+        std::vector<Entry> entries;
+        uint64             totalBytes = 0U;
+
+        std::error_code error;
+        for (const std::filesystem::directory_entry& file: std::filesystem::directory_iterator(createInfo.directory, error)) {
+            if (!file.is_regular_file(error) || file.path() == indexPath()) {
+                continue;
+            }
+            const uint64 size = file.file_size(error);
+            entries.push_back({file.last_write_time(error), size, file.path()});
+            totalBytes += size;
+        }
+        if (totalBytes <= maxBytes) {
+            return;
+        }
+
+        std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.time < b.time; });
+        uint32 removed = 0U;
+        for (const Entry& entry: entries) {
+            if (totalBytes <= maxBytes) {
+                break;
+            }
+            if (std::filesystem::remove(entry.path, error)) {
+                totalBytes -= entry.size;
+                removed++;
+            }
+        }
+        std::cout << "[INFO]: asset cache evicted " << removed << " entries, " << totalBytes / (1024U * 1024U) << " MiB left" << std::endl;
+    }
+
+    uint64 VuAssetCache::hashBytes(std::span<const uint8> bytes, uint64 seed) {
+        uint64       hash  = mix(seed ^ (bytes.size() * HASH_PRIME));
+        const size_t words = bytes.size() / sizeof(uint64);
+        for (size_t i = 0U; i < words; i++) {
+            uint64 word;
+            std::memcpy(&word, bytes.data() + i * sizeof(uint64), sizeof(uint64));
+            hash = (hash ^ mix(word)) * HASH_PRIME;
+        }
+        uint64       tail      = 0U;
+        const size_t tailBytes = bytes.size() - words * sizeof(uint64);
+        if (tailBytes != 0U) {
+            std::memcpy(&tail, bytes.data() + words * sizeof(uint64), tailBytes);
+        }
+        return mix(hash ^ tail);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    std::filesystem::path VuAssetCache::pathOf(uint64 key, std::string_view extension) {
+        std::ostringstream name;
+        name << std::hex << key << extension;
+        return createInfo.directory / name.str();
+    }
+
+    std::filesystem::path VuAssetCache::indexPath() {
+        return createInfo.directory / "sources.txt";
+    }
+
+    uint64 VuAssetCache::hashSource(const std::filesystem::path& path) {
+        std::error_code error;
+        const std::string absolute = std::filesystem::absolute(path, error).generic_string();
+        const uint64      size     = std::filesystem::file_size(path, error);
+        if (error) {
+            throw std::runtime_error("asset cache can not read source: " + path.string());
+        }
+        const int64 time = writeTimeOf(path, error);
+
+        {
+            std::lock_guard lock(mutex);
+            auto            it = sources.find(absolute);
+            if (it != sources.end() && it->second.size == size && it->second.time == time) {
+                return it->second.hash;
+            }
+        }
+
+        //fixed chunks, so the hash only depends on the bytes. the source is mapped, nothing is copied
+        const VuMappedFile           file(path, VuFileAccess::Sequential);
+        const std::span<const uint8> bytes = file.bytes();
+        uint64                       hash  = size;
+        for (size_t offset = 0U; offset < bytes.size(); offset += READ_CHUNK) {
+            hash = hashBytes(bytes.subspan(offset, std::min(READ_CHUNK, bytes.size() - offset)), hash);
+        }
+
+        std::lock_guard lock(mutex);
+        sources[absolute] = {size, time, hash};
+        sourcesChanged    = true;
+        return hash;
+    }
+
+    //one source per line: hash size writeTime path
+    void VuAssetCache::readIndex() {
+        std::ifstream file(indexPath());
+        std::string   line;
+        while (std::getline(file, line)) {
+            std::istringstream stream(line);
+            SourceEntry        entry{};
+            std::string        path;
+            stream >> std::hex >> entry.hash >> std::dec >> entry.size >> entry.time;
+            stream.ignore(1);
+            std::getline(stream, path);
+            if (stream && !path.empty()) {
+                sources[path] = entry;
+            }
+        }
+        sourcesChanged = false;
+    }
+
+    void VuAssetCache::writeIndex() {
+        if (!sourcesChanged) {
+            return;
+        }
+        std::ofstream file(indexPath());
+        for (const auto& [path, entry]: sources) {
+            file << std::hex << entry.hash << std::dec << " " << entry.size << " " << entry.time << " " << path << "\n";
+        }
+        if (!file) {
+            std::cout << "[WARNING]: asset cache could not write " << indexPath().string() << std::endl;
+        }
+        sourcesChanged = false;
+    }
+}
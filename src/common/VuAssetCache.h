@@ -0,0 +1,74 @@
+#pragma once
+
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "Common.h"
+
+namespace Vu {
+
+    struct VuAssetCacheCreateInfo {
+        //processed assets live here, created on demand
+        std::filesystem::path directory = "cache";
+        //least recently used entries are deleted down to this size at init and uninit, 0 keeps everything
+        uint64 maxBytes = 0U;
+    };
+
+    //persistent derived data cache. an entry is keyed on a hash of the bytes of its sources and of the processing
+    //settings, so a touched but unchanged source still hits and a changed importer setting misses. source hashes
+    //are remembered with the size and write time they were computed for, a source that still matches both is
+    //not read again. without init every lookup misses and nothing is stored
+    struct VuAssetCache {
+        static void init(const VuAssetCacheCreateInfo& info);
+
+        //writes the source hashes for the next start
+        static void uninit();
+
+        static bool isEnabled();
+
+        //processing code puts its version and every option that changes the output into settings
+        static uint64 keyOf(std::span<const std::filesystem::path> sources, std::string_view settings);
+
+        //the entry of key, touched for the lru eviction. empty when it does not exist
+        static std::filesystem::path find(uint64 key, std::string_view extension);
+
+        //write(path) creates the entry's file, it is renamed into place afterwards so readers never see a
+        //partial entry. a failing write only logs, the asset is processed again next time
+        static void store(uint64 key, std::string_view extension, const std::function<void(const std::filesystem::path&)>& write);
+
+        //deletes the least recently used entries until the cache holds at most maxBytes
+        static void evict(uint64 maxBytes);
+
+        static uint64 hashBytes(std::span<const uint8> bytes, uint64 seed = 0U);
+
+    private:
+        struct SourceEntry {
+            uint64 size = 0U;
+            int64  time = 0;
+            uint64 hash = 0U;
+        };
+
+        inline static bool                   enabled = false;
+        inline static VuAssetCacheCreateInfo createInfo{};
+        inline static std::mutex             mutex;
+        //by absolute source path
+        inline static std::unordered_map<std::string, SourceEntry> sources;
+        inline static bool                                         sourcesChanged = false;
+
+        static std::filesystem::path pathOf(uint64 key, std::string_view extension);
+
+        static std::filesystem::path indexPath();
+
+        //reads the whole file unless size and write time match the remembered hash
+        static uint64 hashSource(const std::filesystem::path& path);
+
+        static void readIndex();
+
+        static void writeIndex();
+    };
+}
@@ -19,7 +19,12 @@ namespace Vu {
 
 namespace Vu::config {
 
+    //the benchmark target overrides this per build
+#ifdef VU_MAX_FRAMES_IN_FLIGHT
+    constexpr uint32 MAX_FRAMES_IN_FLIGHT = VU_MAX_FRAMES_IN_FLIGHT;
+#else
     constexpr uint32 MAX_FRAMES_IN_FLIGHT = 2;
+#endif
     constexpr uint32 SCREEN_WIDTH = 960;
     constexpr uint32 SCREEN_HEIGHT = 540;
 
@@ -36,6 +41,9 @@ namespace Vu::config {
         .storageBufferCount = 4096,
     };
 
+    //also the samplerRequestCount reserved for the device, the sampler cache never creates more
+    constexpr uint32 MAX_SAMPLER_COUNT = 32;
+
     constexpr uint32 SHADER_COUNT = 256;
     constexpr uint32 MATERIAL_COUNT = 1024;
     constexpr uint32 PUSH_CONST_SIZE = 256;
@@ -59,6 +67,13 @@ namespace Vu::config {
 #endif
     };
 
+    //headless rendering needs neither a display nor a surface
+    inline static std::vector<const char *> HEADLESS_INSTANCE_EXTENSIONS = {
+#ifndef  NDEBUG
+        VK_EXT_DEBUG_UTILS_EXTENSION_NAME,
+#endif
+    };
+
     inline static std::vector<const char *> DEVICE_EXTENSIONS = {
         VK_KHR_SWAPCHAIN_EXTENSION_NAME,
         VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME,
@@ -68,6 +83,13 @@ namespace Vu::config {
         //VK_EXT_SCALAR_BLOCK_LAYOUT_EXTENSION_NAME
     };
 
+    inline static std::vector<const char *> HEADLESS_DEVICE_EXTENSIONS = {
+        VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME,
+    };
+
+    //format of the headless ring, same as the color attachment the offline pipeline cache is built for (basic.pc.json)
+    constexpr VkFormat HEADLESS_COLOR_FORMAT = VK_FORMAT_R8G8B8A8_UNORM;
+
     constexpr char SHADER_COMPILER_PATH[] = "bin\\slang\\slangc.exe";
 
 }
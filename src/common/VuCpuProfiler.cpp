@@ -0,0 +1,128 @@
+#include "VuCpuProfiler.h"
+
+#include <algorithm>
+#include <format>
+#include <fstream>
+#include <iostream>
+
+namespace Vu {
+
+    namespace {
+        struct ExportedEvent {
+            const char* name;
+            uint64      begin;
+            uint64      end;
+            uint32      thread;
+        };
+
+        std::string escapeJson(const char* text) {
+            std::string result;
+            for (const char* c = text; *c != '\0'; c++) {
+                if (*c == '"' || *c == '\\') {
+                    result.push_back('\\');
+                }
+                result.push_back(*c);
+            }
+            return result;
+        }
+    }
+
+    VuCpuProfiler::ThreadBuffer& VuCpuProfiler::getThreadBuffer() {
+        thread_local ThreadBuffer* buffer = nullptr;
+        if (buffer == nullptr) {
+            std::lock_guard lock(threadsMutex);
+            threads.push_back(std::make_unique<ThreadBuffer>());
+            buffer              = threads.back().get();
+            buffer->threadIndex = static_cast<uint32>(threads.size());
+        }
+        return *buffer;
+    }
+
+    void VuCpuProfiler::setThreadName(const char* name) {
+        getThreadBuffer().threadName.store(name, std::memory_order_relaxed);
+    }
+
+    void VuCpuProfiler::record(const char* name, uint64 beginNs, uint64 endNs) {
+        ThreadBuffer& buffer = getThreadBuffer();
+        //threads that only ever name themselves never pay for a ring. export touches it once head is non zero
+        if (buffer.events == nullptr) {
+            buffer.events = std::make_unique<Event[]>(EVENTS_PER_THREAD);
+        }
+        const uint64 index = buffer.head.load(std::memory_order_relaxed);
+        Event&       event = buffer.events[index % EVENTS_PER_THREAD];
+        //an export that reads any of the stores below reads a head of at least index afterwards
+        std::atomic_thread_fence(std::memory_order_release);
+        event.name.store(name, std::memory_order_relaxed);
+        event.begin.store(beginNs, std::memory_order_relaxed);
+        event.end.store(endNs, std::memory_order_relaxed);
+        //publishes the event to export
+        buffer.head.store(index + 1U, std::memory_order_release);
+    }
+
+    uint64 VuCpuProfiler::exportChromeTrace(const std::filesystem::path& path) {
+        std::vector<ExportedEvent>                     events;
+        std::vector<std::pair<uint32, const char *>> threadNames;
+        {
+            std::lock_guard lock(threadsMutex);
+            for (const std::unique_ptr<ThreadBuffer>& buffer: threads) {
+                const uint64 head  = buffer->head.load(std::memory_order_acquire);
+                const uint64 first = head > EVENTS_PER_THREAD ? head - EVENTS_PER_THREAD : 0U;
+                const size_t start = events.size();
+                for (uint64 i = first; i < head; i++) {
+                    const Event& event = buffer->events[i % EVENTS_PER_THREAD];
+                    events.push_back({
+                        event.name.load(std::memory_order_relaxed),
+                        event.begin.load(std::memory_order_relaxed),
+                        event.end.load(std::memory_order_relaxed),
+                        buffer->threadIndex
+                    });
+                }
+
+                //the owner kept recording while we copied, drop the slots it may have overwritten meanwhile.
+                //event headAfter may be half written over event headAfter - EVENTS_PER_THREAD, that one goes too
+                std::atomic_thread_fence(std::memory_order_acquire);
+                const uint64 headAfter = buffer->head.load(std::memory_order_relaxed);
+                const uint64 valid     = headAfter >= EVENTS_PER_THREAD ? headAfter - EVENTS_PER_THREAD + 1U : 0U;
+                if (valid > first) {
+                    const size_t overwritten = static_cast<size_t>(std::min(valid, head) - first);
+                    events.erase(events.begin() + static_cast<std::ptrdiff_t>(start),
+                                 events.begin() + static_cast<std::ptrdiff_t>(start + overwritten));
+                }
+
+                if (const char* name = buffer->threadName.load(std::memory_order_relaxed); name != nullptr) {
+                    threadNames.emplace_back(buffer->threadIndex, name);
+                }
+            }
+        }
+
+        std::sort(events.begin(), events.end(), [](const ExportedEvent& a, const ExportedEvent& b) { return a.begin < b.begin; });
+
+        std::ofstream file(path);
+        if (!file.is_open()) {
+            std::cerr << "[ERROR]: failed to open cpu trace file: " << path.string() << std::endl;
+            return 0U;
+        }
+
+        //complete events in microseconds, thread names as metadata events
+        file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        bool first = true;
+        for (const auto& [thread, name]: threadNames) {
+            file << (first ? "" : ",\n")
+                    << std::format(R"({{"name":"thread_name","ph":"M","pid":1,"tid":{},"args":{{"name":"{}"}}}})", thread, escapeJson(name));
+            first = false;
+        }
+        for (const ExportedEvent& event: events) {
+            file << (first ? "" : ",\n")
+                    << std::format(R"({{"name":"{}","ph":"X","pid":1,"tid":{},"ts":{:.3f},"dur":{:.3f}}})",
+                                   escapeJson(event.name),
+                                   event.thread,
+                                   static_cast<double>(event.begin) / 1000.0,
+                                   static_cast<double>(event.end - event.begin) / 1000.0);
+            first = false;
+        }
+        file << "\n]}\n";
+
+        std::cout << std::format("[INFO]: wrote {} cpu zones to {}", events.size(), path.string()) << std::endl;
+        return events.size();
+    }
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Common.h"
+
+namespace Vu {
+
+    //cpu zones for chrome://tracing and perfetto. every thread records into its own ring of the last
+    //EVENTS_PER_THREAD zones without locks, export copies the rings while they are still being written
+    struct VuCpuProfiler {
+        static constexpr uint32 EVENTS_PER_THREAD = 1U << 16U;
+
+        //nanoseconds since startup, ctx::time() and the frame delta use the same clock
+        static uint64 now() {
+            return static_cast<uint64>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - epoch).count());
+        }
+
+        static void setEnabled(bool value) {
+            enabled.store(value, std::memory_order_relaxed);
+        }
+
+        static bool isEnabled() {
+            return enabled.load(std::memory_order_relaxed);
+        }
+
+        //shown as the track name in the trace, name must outlive the profiler
+        static void setThreadName(const char* name);
+
+        //name must be a string literal or otherwise outlive the export
+        static void record(const char* name, uint64 beginNs, uint64 endNs);
+
+        //writes the zones currently held by the rings as trace event json, returns the number of zones written
+        static uint64 exportChromeTrace(const std::filesystem::path& path);
+
+    private:
+        struct Event {
+            std::atomic<const char *> name;
+            std::atomic<uint64>       begin;
+            std::atomic<uint64>       end;
+        };
+
+        //written by its thread only, head counts every zone ever recorded. events is allocated by the first record
+        struct ThreadBuffer {
+            uint32                   threadIndex;
+            std::atomic<const char*> threadName = nullptr;
+            std::atomic<uint64>      head       = 0U;
+            std::unique_ptr<Event[]> events;
+        };
+
+        inline static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+        inline static std::atomic<bool>                            enabled = false;
+
+        //registration happens once per thread, buffers live until exit since zones may still point at them
+        inline static std::mutex                                 threadsMutex;
+        inline static std::vector<std::unique_ptr<ThreadBuffer>> threads;
+
+        static ThreadBuffer& getThreadBuffer();
+    };
+
+    //records the time between construction and destruction as one zone on the current thread
+    struct VuCpuZone {
+        explicit VuCpuZone(const char* name) : name(name), begin(VuCpuProfiler::isEnabled() ? VuCpuProfiler::now() : 0U) {
+        }
+
+        ~VuCpuZone() {
+            if (begin != 0U) {
+                VuCpuProfiler::record(name, begin, VuCpuProfiler::now());
+            }
+        }
+
+        VuCpuZone(const VuCpuZone&)            = delete;
+        VuCpuZone& operator=(const VuCpuZone&) = delete;
+
+    private:
+        const char* name;
+        uint64      begin;
+    };
+
+#define VU_CPU_ZONE_CONCAT_INNER(a, b) a##b
+#define VU_CPU_ZONE_CONCAT(a, b) VU_CPU_ZONE_CONCAT_INNER(a, b)
+#define VU_CPU_ZONE(name) Vu::VuCpuZone VU_CPU_ZONE_CONCAT(vuCpuZone, __LINE__){name}
+}
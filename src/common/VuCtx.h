@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Common.h"
+#include "VuCpuProfiler.h"
 #include "VuTypes.h"
 
 namespace Vu {
@@ -28,9 +29,10 @@ namespace Vu {
         inline float mouseDeltaY = 0;
 
         inline void PreUpdate() {
-            //nano => micro => mili => second
-            //deltaAsSecond        = (SDL_GetTicksNS() - prevTimeAsNanoSecond) / 1000.0f / 1000.0f / 1000.0f;
-            //prevTimeAsNanoSecond = SDL_GetTicksNS();
+            //nano => micro => mili => second, the first frame has no previous one and gets a zero delta
+            const uint64 now     = VuCpuProfiler::now();
+            deltaAsSecond        = prevTimeAsNanoSecond == 0 ? 0.0f : (now - prevTimeAsNanoSecond) / 1000.0f / 1000.0f / 1000.0f;
+            prevTimeAsNanoSecond = now;
         }
 
         inline void UpdateInput() {
@@ -38,9 +40,9 @@ namespace Vu {
             //SDL_GetMouseState(&mouseX, &mouseY);
         }
 
+        //seconds since startup
         inline float time() {
-            //return SDL_GetTicks() / 1000.0f;
-            return 0.016f;
+            return static_cast<float>(static_cast<double>(VuCpuProfiler::now()) / 1000.0 / 1000.0 / 1000.0);
         }
 
     }
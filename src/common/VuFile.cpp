@@ -0,0 +1,204 @@
+#include "VuFile.h"
+
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Vu {
+
+    VuMappedFile::VuMappedFile(VuMappedFile&& other) noexcept {
+        *this = std::move(other);
+    }
+
+    VuMappedFile& VuMappedFile::operator=(VuMappedFile&& other) noexcept {
+        if (this != &other) {
+            close();
+            data   = std::exchange(other.data, nullptr);
+            length = std::exchange(other.length, 0U);
+            opened = std::exchange(other.opened, false);
+            path   = std::move(other.path);
+#ifdef _WIN32
+            fileHandle    = std::exchange(other.fileHandle, nullptr);
+            mappingHandle = std::exchange(other.mappingHandle, nullptr);
+#endif
+        }
+        return *this;
+    }
+
+    std::span<const uint8> VuMappedFile::bytes(uint64 offset, uint64 size) const {
+        if (offset > length || size > length - offset) {
+            throw std::runtime_error("read past the end of " + path.string());
+        }
+        return {data + offset, static_cast<size_t>(size)};
+    }
+
+    void VuMappedFile::touch(uint64 offset, uint64 size) const {
+        //the smallest page size of every target, stepping finer than the real pages only costs a few loads
+        constexpr size_t PAGE_STEP = 4096U;
+
+        const std::span<const uint8> range = bytes(offset, size);
+        //volatile so the loads are not optimized away
+        const auto* pages = reinterpret_cast<const volatile uint8 *>(range.data());
+        for (size_t i = 0U; i < range.size(); i += PAGE_STEP) {
+            (void) pages[i];
+        }
+        if (!range.empty()) {
+            (void) pages[range.size() - 1U];
+        }
+    }
+
+#ifdef _WIN32
+
+    void VuMappedFile::open(const std::filesystem::path& filePath, VuFileAccess access) {
+        close();
+        path = filePath;
+
+        const DWORD hint = access == VuFileAccess::Sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS;
+        HANDLE      file = CreateFileW(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                       FILE_ATTRIBUTE_NORMAL | hint, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            throw std::runtime_error("failed to open file: " + filePath.string());
+        }
+        LARGE_INTEGER fileSize{};
+        if (!GetFileSizeEx(file, &fileSize)) {
+            CloseHandle(file);
+            throw std::runtime_error("failed to read the size of " + filePath.string());
+        }
+        fileHandle = file;
+        opened     = true;
+        length     = static_cast<uint64>(fileSize.QuadPart);
+        //an empty file can not be mapped
+        if (length == 0U) {
+            return;
+        }
+
+        HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        void*  view    = mapping != nullptr ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        if (view == nullptr) {
+            if (mapping != nullptr) {
+                CloseHandle(mapping);
+            }
+            close();
+            throw std::runtime_error("failed to map file: " + filePath.string());
+        }
+        mappingHandle = mapping;
+        data          = static_cast<const uint8 *>(view);
+
+        if (access == VuFileAccess::Sequential) {
+            prefetch(0U, length);
+        }
+    }
+
+    void VuMappedFile::close() {
+        if (data != nullptr) {
+            UnmapViewOfFile(data);
+        }
+        if (mappingHandle != nullptr) {
+            CloseHandle(mappingHandle);
+        }
+        if (fileHandle != nullptr) {
+            CloseHandle(fileHandle);
+        }
+        data          = nullptr;
+        length        = 0U;
+        opened        = false;
+        mappingHandle = nullptr;
+        fileHandle    = nullptr;
+    }
+
+    void VuMappedFile::prefetch(uint64 offset, uint64 size) const {
+#if _WIN32_WINNT >= 0x0602
+        const std::span<const uint8> range = bytes(offset, size);
+        if (range.empty()) {
+            return;
+        }
+        WIN32_MEMORY_RANGE_ENTRY entry{const_cast<uint8 *>(range.data()), range.size()};
+        //only a hint, older systems without the call just fault the pages in later
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &entry, 0);
+#else
+        (void) bytes(offset, size);
+#endif
+    }
+
+#else
+
+    void VuMappedFile::open(const std::filesystem::path& filePath, VuFileAccess access) {
+        close();
+        path = filePath;
+
+        const int file = ::open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+        if (file < 0) {
+            throw std::runtime_error("failed to open file: " + filePath.string() + ": " + std::strerror(errno));
+        }
+        struct stat status{};
+        if (fstat(file, &status) != 0) {
+            ::close(file);
+            throw std::runtime_error("failed to read the size of " + filePath.string());
+        }
+        opened = true;
+        length = static_cast<uint64>(status.st_size);
+        //an empty file can not be mapped
+        if (length == 0U) {
+            ::close(file);
+            return;
+        }
+
+        void* view = mmap(nullptr, static_cast<size_t>(length), PROT_READ, MAP_PRIVATE, file, 0);
+        //the mapping keeps its own reference to the file
+        ::close(file);
+        if (view == MAP_FAILED) {
+            opened = false;
+            length = 0U;
+            throw std::runtime_error("failed to map file: " + filePath.string() + ": " + std::strerror(errno));
+        }
+        data = static_cast<const uint8 *>(view);
+
+        if (access == VuFileAccess::Sequential) {
+            posix_madvise(view, static_cast<size_t>(length), POSIX_MADV_SEQUENTIAL);
+            prefetch(0U, length);
+        } else {
+            posix_madvise(view, static_cast<size_t>(length), POSIX_MADV_RANDOM);
+        }
+    }
+
+    void VuMappedFile::close() {
+        if (data != nullptr) {
+            munmap(const_cast<uint8 *>(data), static_cast<size_t>(length));
+        }
+        data   = nullptr;
+        length = 0U;
+        opened = false;
+    }
+
+    void VuMappedFile::prefetch(uint64 offset, uint64 size) const {
+        const std::span<const uint8> range = bytes(offset, size);
+        if (range.empty()) {
+            return;
+        }
+        //madvise wants a page aligned start
+        const auto   pageSize = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+        const auto   begin    = reinterpret_cast<uintptr_t>(range.data());
+        const auto   aligned  = begin & ~(pageSize - 1U);
+        const size_t count    = range.size() + (begin - aligned);
+        posix_madvise(reinterpret_cast<void *>(aligned), count, POSIX_MADV_WILLNEED);
+    }
+
+#endif
+}
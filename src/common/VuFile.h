@@ -0,0 +1,78 @@
+#pragma once
+
+#include <filesystem>
+#include <span>
+
+#include "Common.h"
+
+namespace Vu {
+
+    //how a mapped file is going to be read, passed to the kernel as a paging hint
+    enum class VuFileAccess : uint8 {
+        //front to back once, read ahead aggressively and drop pages behind the reader
+        Sequential,
+        //scattered ranges such as single mips, read ahead only what is asked for with prefetch
+        Random,
+    };
+
+    //read only memory mapped view of a whole file. nothing is copied to the heap, pages are faulted in on first
+    //touch and shared with every other mapping of the file. the view stays valid until close, moves keep it
+    struct VuMappedFile {
+        VuMappedFile() = default;
+
+        explicit VuMappedFile(const std::filesystem::path& path, VuFileAccess access = VuFileAccess::Sequential) {
+            open(path, access);
+        }
+
+        ~VuMappedFile() {
+            close();
+        }
+
+        VuMappedFile(const VuMappedFile&)            = delete;
+        VuMappedFile& operator=(const VuMappedFile&) = delete;
+
+        VuMappedFile(VuMappedFile&& other) noexcept;
+
+        VuMappedFile& operator=(VuMappedFile&& other) noexcept;
+
+        //throws when the file can not be opened or mapped. sequential access also starts reading the whole file
+        //in the background
+        void open(const std::filesystem::path& path, VuFileAccess access = VuFileAccess::Sequential);
+
+        void close();
+
+        //an empty file is open with no bytes
+        bool isOpen() const {
+            return opened;
+        }
+
+        uint64 size() const {
+            return length;
+        }
+
+        std::span<const uint8> bytes() const {
+            return {data, length};
+        }
+
+        //throws when the range is not inside the file
+        std::span<const uint8> bytes(uint64 offset, uint64 size) const;
+
+        //asks the kernel to read the range in the background and returns right away, a later touch of the range
+        //then finds the pages resident instead of blocking on each fault
+        void prefetch(uint64 offset, uint64 size) const;
+
+        //reads a byte of every page of the range, so the worker preparing a view pays for the disk reads and not
+        //the thread it hands the view to
+        void touch(uint64 offset, uint64 size) const;
+
+    private:
+        const uint8*          data   = nullptr;
+        uint64                length = 0U;
+        bool                  opened = false;
+        std::filesystem::path path;
+#ifdef _WIN32
+        void* fileHandle    = nullptr;
+        void* mappingHandle = nullptr;
+#endif
+    };
+}
@@ -0,0 +1,253 @@
+#include "VuJobSystem.h"
+
+#include <array>
+#include <iostream>
+#include <string>
+
+#include "VuCpuProfiler.h"
+
+namespace Vu {
+
+    void VuJobSystem::init(const VuJobSystemCreateInfo& info) {
+        uninit();
+        mainThread = std::this_thread::get_id();
+        if (info.singleThreaded) {
+            return;
+        }
+
+        uint32 workerCount = info.workerCount;
+        if (workerCount == 0U) {
+            workerCount = std::max(std::thread::hardware_concurrency(), 2U) - 1U;
+        }
+
+        stopping.store(false);
+        queues.clear();
+        for (uint32 i = 0U; i <= workerCount; i++) {
+            queues.push_back(std::make_unique<Queue>());
+        }
+        queueIndex = workerCount;
+        for (uint32 i = 0U; i < workerCount; i++) {
+            workers.emplace_back(workerLoop, i);
+        }
+        std::cout << "[INFO]: job system started " << workerCount << " workers" << std::endl;
+    }
+
+    void VuJobSystem::uninit() {
+        if (workers.empty()) {
+            return;
+        }
+        {
+            std::lock_guard lock(sleepMutex);
+            stopping.store(true);
+        }
+        sleepCondition.notify_all();
+        for (std::thread& worker: workers) {
+            worker.join();
+        }
+        workers.clear();
+
+        //dropping the jobs would leak their closures and leave their counters above zero forever. without
+        //workers, jobs the drained ones start run inline
+        queueIndex = static_cast<uint32>(queues.size()) - 1U;
+        while (tryRunOne() || tryRunBackground()) {
+        }
+        if (isMainThread()) {
+            runMainThreadJobs();
+        }
+
+        queues.clear();
+        queuedJobs.store(0U);
+        queueIndex = NOT_A_WORKER;
+    }
+
+    uint32 VuJobSystem::getThreadCount() {
+        return static_cast<uint32>(workers.size()) + 1U;
+    }
+
+    bool VuJobSystem::isMainThread() {
+        return mainThread == std::thread::id() || std::this_thread::get_id() == mainThread;
+    }
+
+    void VuJobSystem::wait(VuJobCounter& counter) {
+        while (!counter.isDone()) {
+            if (isMainThread()) {
+                runMainThreadJobs();
+            }
+            if (tryRunOne()) {
+                continue;
+            }
+
+            //the remaining jobs run elsewhere. announced before looking once more, so a push or the last job
+            //of counter after that look sees the waiter and bumps the epoch
+            const uint64 epoch = wakeEpoch.load();
+            waitingThreads.fetch_add(1U);
+            if (!tryRunOne()) {
+                std::unique_lock lock(waitMutex);
+                waitCondition.wait(lock, [&] { return counter.pending.load() == 0U || wakeEpoch.load() != epoch; });
+            }
+            waitingThreads.fetch_sub(1U);
+        }
+    }
+
+    void VuJobSystem::runOnMainThread(std::function<void()> fn, VuJobCounter* counter) {
+        if (workers.empty() && isMainThread()) {
+            fn();
+            return;
+        }
+        if (counter != nullptr) {
+            counter->pending.fetch_add(1U, std::memory_order_relaxed);
+        }
+        {
+            std::lock_guard lock(mainThreadMutex);
+            mainThreadJobs.push_back({std::move(fn), counter});
+        }
+        //the main thread may be sleeping in wait
+        wakeWaiters();
+    }
+
+    void VuJobSystem::runMainThreadJobs() {
+        std::vector<MainThreadJob> jobs;
+        {
+            std::lock_guard lock(mainThreadMutex);
+            jobs.swap(mainThreadJobs);
+        }
+        for (MainThreadJob& job: jobs) {
+            job.fn();
+            finish(job.counter);
+        }
+    }
+
+    void VuJobSystem::push(const Job& job) {
+        if (job.counter != nullptr) {
+            job.counter->pending.fetch_add(1U, std::memory_order_relaxed);
+        }
+
+        //threads outside the pool spread their jobs over the workers
+        uint32 target = queueIndex;
+        if (target == NOT_A_WORKER) {
+            target = nextQueue.fetch_add(1U, std::memory_order_relaxed) % static_cast<uint32>(queues.size());
+        }
+        //counted before it is visible, a thief taking it right away never sees the count below zero
+        queuedJobs.fetch_add(1U, std::memory_order_release);
+        {
+            std::lock_guard lock(queues[target]->mutex);
+            queues[target]->jobs.push_back(job);
+        }
+        {
+            std::lock_guard lock(sleepMutex);
+        }
+        sleepCondition.notify_one();
+        wakeWaiters();
+    }
+
+    void VuJobSystem::pushBackground(const Job& job) {
+        if (job.counter != nullptr) {
+            job.counter->pending.fetch_add(1U, std::memory_order_relaxed);
+        }
+        queuedJobs.fetch_add(1U, std::memory_order_release);
+        {
+            std::lock_guard lock(backgroundQueue.mutex);
+            backgroundQueue.jobs.push_back(job);
+        }
+        {
+            std::lock_guard lock(sleepMutex);
+        }
+        sleepCondition.notify_one();
+    }
+
+    bool VuJobSystem::tryRunOne() {
+        const uint32 queueCount = static_cast<uint32>(queues.size());
+        const uint32 self       = queueIndex;
+        Job          job{};
+        bool         found = false;
+
+        if (self != NOT_A_WORKER) {
+            Queue&          own = *queues[self];
+            std::lock_guard lock(own.mutex);
+            if (!own.jobs.empty()) {
+                job = own.jobs.back();
+                own.jobs.pop_back();
+                found = true;
+            }
+        }
+
+        const uint32 start = self == NOT_A_WORKER ? 0U : self + 1U;
+        for (uint32 n = 0U; !found && n < queueCount; n++) {
+            const uint32 victimIndex = (start + n) % queueCount;
+            if (victimIndex == self) {
+                continue;
+            }
+            Queue&          victim = *queues[victimIndex];
+            std::lock_guard lock(victim.mutex);
+            if (!victim.jobs.empty()) {
+                job = victim.jobs.front();
+                victim.jobs.pop_front();
+                found = true;
+            }
+        }
+
+        if (found) {
+            execute(job);
+        }
+        return found;
+    }
+
+    bool VuJobSystem::tryRunBackground() {
+        Job job{};
+        {
+            std::lock_guard lock(backgroundQueue.mutex);
+            if (backgroundQueue.jobs.empty()) {
+                return false;
+            }
+            job = backgroundQueue.jobs.front();
+            backgroundQueue.jobs.pop_front();
+        }
+        execute(job);
+        return true;
+    }
+
+    void VuJobSystem::execute(const Job& job) {
+        queuedJobs.fetch_sub(1U, std::memory_order_relaxed);
+        job.fn(job.data, job.index);
+        finish(job.counter);
+    }
+
+    void VuJobSystem::finish(VuJobCounter* counter) {
+        //seq_cst pairs with the waiter announcing itself before its last look at the counter
+        if (counter != nullptr && counter->pending.fetch_sub(1U) == 1U) {
+            wakeWaiters();
+        }
+    }
+
+    void VuJobSystem::wakeWaiters() {
+        if (waitingThreads.load() == 0U) {
+            return;
+        }
+        {
+            std::lock_guard lock(waitMutex);
+            wakeEpoch.fetch_add(1U);
+        }
+        waitCondition.notify_all();
+    }
+
+    void VuJobSystem::workerLoop(uint32 index) {
+        //the profiler keeps the name pointer, the strings live as long as the process
+        static std::array<std::string, 256> names;
+        if (index < names.size()) {
+            names[index] = "job worker " + std::to_string(index);
+            VuCpuProfiler::setThreadName(names[index].c_str());
+        }
+        queueIndex = index;
+
+        while (true) {
+            if (tryRunOne() || tryRunBackground()) {
+                continue;
+            }
+            std::unique_lock lock(sleepMutex);
+            sleepCondition.wait(lock, [] { return stopping.load() || queuedJobs.load(std::memory_order_acquire) != 0U; });
+            if (stopping.load()) {
+                return;
+            }
+        }
+    }
+}
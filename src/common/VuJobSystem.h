@@ -0,0 +1,203 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Common.h"
+
+namespace Vu {
+
+    struct VuJobSystemCreateInfo {
+        //threads besides the main thread, 0 uses every hardware thread but one
+        uint32 workerCount = 0U;
+        //no workers, every job runs on the submitting thread in submission order. for reproducible debugging
+        bool singleThreaded = false;
+    };
+
+    //jobs of a group that did not finish yet, see VuJobSystem::wait
+    struct VuJobCounter {
+        std::atomic<uint32> pending = 0U;
+
+        bool isDone() const {
+            return pending.load(std::memory_order_acquire) == 0U;
+        }
+    };
+
+    //work stealing thread pool. every worker and the main thread own a deque, the owner pushes and pops at the
+    //back so nested work stays hot in its cache, idle threads steal the oldest job from the front of another
+    //deque. a thread waiting on a counter runs jobs instead of blocking, which makes nested parallelFor safe.
+    //without init, or single threaded, everything runs inline on the calling thread
+    struct VuJobSystem {
+        static void init(const VuJobSystemCreateInfo& info);
+
+        //stops the workers, then runs every job still queued on the calling thread, so no closure leaks and
+        //every counter reaches zero
+        static void uninit();
+
+        //workers plus the main thread
+        static uint32 getThreadCount();
+
+        //the thread that called init, any thread before that
+        static bool isMainThread();
+
+        //fn() on any thread, counter is incremented now and decremented after fn returned
+        template<typename Fn>
+        static void run(Fn&& fn, VuJobCounter* counter = nullptr) {
+            using Closure = std::decay_t<Fn>;
+            if (workers.empty()) {
+                fn();
+                return;
+            }
+            auto* closure = new Closure(std::forward<Fn>(fn));
+            push({
+                [](void* data, uint32) {
+                    std::unique_ptr<Closure> owned(static_cast<Closure *>(data));
+                    (*owned)();
+                },
+                closure,
+                0U,
+                counter
+            });
+        }
+
+        //like run, for long jobs such as disk reads and decodes. only idle workers pick them up, so a thread
+        //waiting on frame work never gets stuck in one
+        template<typename Fn>
+        static void runBackground(Fn&& fn, VuJobCounter* counter = nullptr) {
+            using Closure = std::decay_t<Fn>;
+            if (workers.empty()) {
+                fn();
+                return;
+            }
+            auto* closure = new Closure(std::forward<Fn>(fn));
+            pushBackground({
+                [](void* data, uint32) {
+                    std::unique_ptr<Closure> owned(static_cast<Closure *>(data));
+                    (*owned)();
+                },
+                closure,
+                0U,
+                counter
+            });
+        }
+
+        //the calling thread runs queued jobs, stolen ones included, until counter reaches zero. when only jobs it
+        //may not take are left, e.g. background jobs, it sleeps until a job is pushed or the counter is done
+        static void wait(VuJobCounter& counter);
+
+        //fn(first, end) over [0, count) in jobs of at least minItemsPerJob items, a few jobs per thread so
+        //stealing evens out uneven items. returns when every item ran
+        template<typename Fn>
+        static void parallelFor(uint32 count, uint32 minItemsPerJob, const Fn& fn) {
+            const uint32 byItems  = count / std::max(minItemsPerJob, 1U);
+            const uint32 jobCount = std::min(byItems, getThreadCount() * JOBS_PER_THREAD);
+            if (jobCount <= 1U || workers.empty()) {
+                if (count != 0U) {
+                    fn(0U, count);
+                }
+                return;
+            }
+
+            struct Range {
+                const Fn* fn;
+                uint32    count;
+                uint32    jobCount;
+            } range{&fn, count, jobCount};
+
+            VuJobCounter counter{};
+            for (uint32 job = 0U; job < jobCount; job++) {
+                push({
+                    [](void* data, uint32 index) {
+                        const Range* r     = static_cast<const Range *>(data);
+                        const uint32 first = static_cast<uint32>(static_cast<uint64>(r->count) * index / r->jobCount);
+                        const uint32 end   = static_cast<uint32>(static_cast<uint64>(r->count) * (index + 1U) / r->jobCount);
+                        (*r->fn)(first, end);
+                    },
+                    &range,
+                    job,
+                    &counter
+                });
+            }
+            wait(counter);
+        }
+
+        //queued until the main thread calls runMainThreadJobs, for vulkan queue submission and other work that
+        //is bound to the thread owning the device objects
+        static void runOnMainThread(std::function<void()> fn, VuJobCounter* counter = nullptr);
+
+        //the frame loop calls this once per frame
+        static void runMainThreadJobs();
+
+    private:
+        static constexpr uint32 JOBS_PER_THREAD = 4U;
+        static constexpr uint32 NOT_A_WORKER    = UINT32_MAX;
+
+        struct Job {
+            void (*fn)(void* data, uint32 index);
+            void*         data;
+            uint32        index;
+            VuJobCounter* counter;
+        };
+
+        //the mutex is only contended while somebody steals, the owner's push and pop take it uncontended
+        struct Queue {
+            std::mutex      mutex;
+            std::deque<Job> jobs;
+        };
+
+        //queues[workerCount] belongs to the main thread
+        inline static std::vector<std::unique_ptr<Queue>> queues;
+        inline static std::vector<std::thread>            workers;
+        inline static std::thread::id                     mainThread;
+        inline static thread_local uint32                 queueIndex = NOT_A_WORKER;
+
+        //counts queued jobs so idle workers can sleep, pushes notify under sleepMutex so no wakeup is lost
+        inline static std::atomic<uint32>     queuedJobs = 0U;
+        inline static std::atomic<bool>       stopping   = false;
+        inline static std::atomic<uint32>     nextQueue  = 0U;
+        inline static std::mutex              sleepMutex;
+        inline static std::condition_variable sleepCondition;
+
+        //threads sleeping in wait. pushes and finished counters bump wakeEpoch under waitMutex while anybody waits
+        inline static std::atomic<uint32>     waitingThreads = 0U;
+        inline static std::atomic<uint64>     wakeEpoch      = 0U;
+        inline static std::mutex              waitMutex;
+        inline static std::condition_variable waitCondition;
+
+        struct MainThreadJob {
+            std::function<void()> fn;
+            VuJobCounter*         counter;
+        };
+
+        inline static std::mutex                 mainThreadMutex;
+        inline static std::vector<MainThreadJob> mainThreadJobs;
+
+        //oldest first, shared by all workers
+        inline static Queue backgroundQueue;
+
+        static void push(const Job& job);
+
+        static void pushBackground(const Job& job);
+
+        //own queue from the back first, then the front of the others
+        static bool tryRunOne();
+
+        static bool tryRunBackground();
+
+        static void execute(const Job& job);
+
+        static void finish(VuJobCounter* counter);
+
+        static void wakeWaiters();
+
+        static void workerLoop(uint32 index);
+    };
+}
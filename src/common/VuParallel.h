@@ -0,0 +1,51 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+
+#include "Common.h"
+#include "VuJobSystem.h"
+
+namespace Vu {
+
+    //fork-join over an index range for load time and per frame batch work, on top of the job system
+    struct VuParallel {
+        //0 means every thread of the job system
+        static uint32 resolveThreadCount(uint32 threadCount) {
+            if (threadCount != 0U) {
+                return threadCount;
+            }
+            return VuJobSystem::getThreadCount();
+        }
+
+        //first item of chunk out of chunkCount equal chunks
+        static uint32 chunkBegin(uint32 chunk, uint32 itemCount, uint32 chunkCount) {
+            return static_cast<uint32>(static_cast<uint64>(itemCount) * chunk / chunkCount);
+        }
+
+        //runs fn(0..count-1) on the calling thread and up to threadCount - 1 jobs that pull the next index,
+        //returns when every index ran
+        template<typename Fn>
+        static void forEach(uint32 count, uint32 threadCount, const Fn& fn) {
+            const uint32 jobCount = std::min({count, resolveThreadCount(threadCount), VuJobSystem::getThreadCount()});
+            if (jobCount <= 1U) {
+                for (uint32 i = 0U; i < count; i++) {
+                    fn(i);
+                }
+                return;
+            }
+            std::atomic<uint32> next{0U};
+            auto                loop = [&] {
+                for (uint32 i = next.fetch_add(1U); i < count; i = next.fetch_add(1U)) {
+                    fn(i);
+                }
+            };
+            VuJobCounter counter{};
+            for (uint32 job = 1U; job < jobCount; job++) {
+                VuJobSystem::run(loop, &counter);
+            }
+            loop();
+            VuJobSystem::wait(counter);
+        }
+    };
+}
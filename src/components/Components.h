@@ -9,14 +9,19 @@ namespace Vu {
     struct VuShader;
 
     struct MeshRenderer {
-        VuMesh* mesh;
-        VuHandle<VuShader> shader;
-        uint32 materialIndex;
+        VuMesh*   mesh          = nullptr;
+        VuShader* shader        = nullptr;
+        //index into shader->materials
+        uint32    materialIndex = 0U;
+        //the submeshes drawn, subMeshCount 0 draws the whole mesh
+        uint32    firstSubMesh  = 0U;
+        uint32    subMeshCount  = 0U;
     };
 
 
     struct Spinn {
         float3 axis = float3(0, 1, 0);
+        //radians per second around axis
         float angle = glm::radians(0.f);
     };
 }
@@ -9,35 +9,21 @@
 
 
 namespace Vu {
-    struct VuMaterialCreateInfo {
-        VkPipelineCache pipelineCache;
-        VkRenderPass renderPass;
-    };
-
+    //a block of the global material data buffer. materials draw with the pipeline of their shader and only pass
+    //the block index in the push constants
     struct VuMaterial {
-        VuGraphicsPipeline vuPipeline;
         uint32 index;
 
-        void init(const VuMaterialCreateInfo& createInfo) {
-            vuPipeline.initGraphicsPipeline(
-                ctx::vuDevice->globalPipelineLayout,
-                createInfo.pipelineCache,
-                createInfo.renderPass
-            );
+        void init() {
             index = VuMaterialDataPool::allocBlock();
         }
 
         void uninit() {
-            vuPipeline.Dispose();
             VuMaterialDataPool::freeBlock(index);
         }
 
         GPU_PBR_MaterialData* getPbrMaterialData() {
             return Vu::VuMaterialDataPool::getMaterialData(index);
         }
-
-        void bindPipeline(const VkCommandBuffer& commandBuffer) const {
-            vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vuPipeline.pipeline);
-        }
     };
 }
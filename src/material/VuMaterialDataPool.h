@@ -44,6 +44,9 @@ namespace Vu {
                 index = freeList.top();
                 freeList.pop();
             } else {
+                if (allocCounter == BLOCK_COUNT) {
+                    throw std::runtime_error("material data pool is full!");
+                }
                 index = allocCounter;
                 allocCounter++;
             }
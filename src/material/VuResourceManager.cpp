@@ -21,79 +21,155 @@ void Vu::VuResourceManager::registerStorageBuffer(uint32 writeIndex, const VuBuf
 }
 
 void Vu::VuResourceManager::writeStorageBuffer(const VuBuffer& buffer, uint32 binding) {
-    VkDescriptorBufferInfo bufferInfo{};
-    bufferInfo.buffer = buffer.buffer;
-    bufferInfo.range  = buffer.lenght * buffer.stride;
-
-    for (size_t i = 0; i < config::MAX_FRAMES_IN_FLIGHT; i++) {
-        VkWriteDescriptorSet descriptorWrite{};
-        descriptorWrite.sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        descriptorWrite.dstSet          = ctx::vuDevice->globalDescriptorSets[i];
-        descriptorWrite.dstBinding      = binding;
-        descriptorWrite.dstArrayElement = 0;
-        descriptorWrite.descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-        descriptorWrite.descriptorCount = 1;
-        descriptorWrite.pBufferInfo     = &bufferInfo;
-        vkUpdateDescriptorSets(ctx::vuDevice->device, 1, &descriptorWrite, 0, nullptr);
-    }
+    queueGlobalWrite({
+        .binding = binding,
+        .arrayElement = 0,
+        .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        .bufferInfo = {
+            .buffer = buffer.buffer,
+            .offset = 0,
+            .range = buffer.lenght * buffer.stride
+        },
+    });
 }
 
 void Vu::VuResourceManager::writeSampledImageToGlobalPool(uint32 writeIndex, const VkImageView& imageView) {
+    queueGlobalWrite({
+        .binding = config::BINDLESS_CONFIG_INFO.sampledImageBinding,
+        .arrayElement = writeIndex,
+        .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+        .imageInfo = {
+            .sampler = VK_NULL_HANDLE,
+            .imageView = imageView,
+            .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        },
+    });
+}
+
+void Vu::VuResourceManager::writeSamplerToGlobalPool(uint32 writeIndex, const VkSampler& sampler) {
+    queueGlobalWrite({
+        .binding = config::BINDLESS_CONFIG_INFO.samplerBinding,
+        .arrayElement = writeIndex,
+        .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER,
+        .imageInfo = {
+            .sampler = sampler,
+        },
+    });
+}
+
+void Vu::VuResourceManager::writeFrameUBO(uint32 frameIndex, const VuBuffer& buffer) {
+    frameWrites[frameIndex].push_back({
+        .binding = config::BINDLESS_CONFIG_INFO.uboBinding,
+        .arrayElement = 0,
+        .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+        .bufferInfo = {
+            .buffer = buffer.buffer,
+            .offset = 0,
+            .range = sizeof(GPU_FrameConst)
+        },
+    });
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void Vu::VuResourceManager::queueGlobalWrite(const PendingDescriptorWrite& write) {
+    globalWrites.push_back(write);
+}
 
-    VkDescriptorImageInfo imageInfo{
-        .sampler = VK_NULL_HANDLE,
-        .imageView = imageView,
-        .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-    };
-
-    for (size_t i = 0; i < config::MAX_FRAMES_IN_FLIGHT; i++) {
-        VkWriteDescriptorSet descriptorWrite{};
-        descriptorWrite.sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        descriptorWrite.dstSet          = ctx::vuDevice->globalDescriptorSets[i];
-        descriptorWrite.dstBinding      = config::BINDLESS_CONFIG_INFO.sampledImageBinding;
-        descriptorWrite.dstArrayElement = writeIndex;
-        descriptorWrite.descriptorType  = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
-        descriptorWrite.descriptorCount = 1;
-        descriptorWrite.pImageInfo      = &imageInfo;
-        vkUpdateDescriptorSets(ctx::vuDevice->device, 1, &descriptorWrite, 0, nullptr);
+void Vu::VuResourceManager::appendMergedWrites(VkDescriptorSet                      dstSet,
+                                               std::vector<PendingDescriptorWrite>& queue,
+                                               std::vector<VkWriteDescriptorSet>&   outWrites,
+                                               std::vector<VkDescriptorImageInfo>&  outImageInfos,
+                                               std::vector<VkDescriptorBufferInfo>& outBufferInfos) {
+    //stable, so for the same element the latest write stays last
+    std::stable_sort(queue.begin(), queue.end(), [](const PendingDescriptorWrite& a, const PendingDescriptorWrite& b) {
+        return a.binding != b.binding ? a.binding < b.binding : a.arrayElement < b.arrayElement;
+    });
+
+    for (size_t i = 0; i < queue.size(); i++) {
+        const PendingDescriptorWrite& write = queue[i];
+        if (i + 1 < queue.size() && queue[i + 1].binding == write.binding && queue[i + 1].arrayElement == write.arrayElement) {
+            continue;
+        }
+
+        const bool isBuffer = write.descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER
+                              || write.descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+
+        VkWriteDescriptorSet* last    = outWrites.empty() ? nullptr : &outWrites.back();
+        const bool            extends = last != nullptr
+                                        && last->dstSet == dstSet
+                                        && last->dstBinding == write.binding
+                                        && last->descriptorType == write.descriptorType
+                                        && last->dstArrayElement + last->descriptorCount == write.arrayElement;
+        if (extends) {
+            last->descriptorCount++;
+        } else {
+            VkWriteDescriptorSet descriptorWrite{};
+            descriptorWrite.sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            descriptorWrite.dstSet          = dstSet;
+            descriptorWrite.dstBinding      = write.binding;
+            descriptorWrite.dstArrayElement = write.arrayElement;
+            descriptorWrite.descriptorType  = write.descriptorType;
+            descriptorWrite.descriptorCount = 1;
+            //info arrays are reserved up front, so these pointers stay valid while the run grows
+            if (isBuffer) {
+                descriptorWrite.pBufferInfo = outBufferInfos.data() + outBufferInfos.size();
+            } else {
+                descriptorWrite.pImageInfo = outImageInfos.data() + outImageInfos.size();
+            }
+            outWrites.push_back(descriptorWrite);
+        }
+
+        if (isBuffer) {
+            outBufferInfos.push_back(write.bufferInfo);
+        } else {
+            outImageInfos.push_back(write.imageInfo);
+        }
     }
 }
 
-void Vu::VuResourceManager::writeSamplerToGlobalPool(uint32 writeIndex, const VkSampler& sampler) {
+void Vu::VuResourceManager::flushSets(uint32 firstFrame, uint32 frameCount) {
+    size_t queuedCount = globalWrites.size();
+    for (uint32 i = firstFrame; i < firstFrame + frameCount; i++) {
+        queuedCount += frameWrites[i].size();
+    }
+
+    lastFlushStats = {static_cast<uint32>(queuedCount), 0, 0};
+    if (queuedCount == 0) {
+        return;
+    }
 
-    VkDescriptorImageInfo imageInfo{
-        .sampler = sampler,
-    };
-
-    for (size_t i = 0; i < config::MAX_FRAMES_IN_FLIGHT; i++) {
-        VkWriteDescriptorSet samplerWrite{};
-        samplerWrite.sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        samplerWrite.dstSet          = ctx::vuDevice->globalDescriptorSets[i];
-        samplerWrite.dstBinding      = config::BINDLESS_CONFIG_INFO.samplerBinding;
-        samplerWrite.dstArrayElement = writeIndex;
-        samplerWrite.descriptorType  = VK_DESCRIPTOR_TYPE_SAMPLER;
-        samplerWrite.descriptorCount = 1;
-        samplerWrite.pImageInfo      = &imageInfo;
-        vkUpdateDescriptorSets(ctx::vuDevice->device, 1, &samplerWrite, 0, nullptr);
+    std::vector<VkWriteDescriptorSet>   writes;
+    std::vector<VkDescriptorImageInfo>  imageInfos;
+    std::vector<VkDescriptorBufferInfo> bufferInfos;
+    writes.reserve(queuedCount);
+    imageInfos.reserve(queuedCount);
+    bufferInfos.reserve(queuedCount);
+
+    appendMergedWrites(ctx::vuDevice->globalDescriptorSet, globalWrites, writes, imageInfos, bufferInfos);
+    globalWrites.clear();
+    for (uint32 i = firstFrame; i < firstFrame + frameCount; i++) {
+        appendMergedWrites(ctx::vuDevice->frameDescriptorSets[i], frameWrites[i], writes, imageInfos, bufferInfos);
+        frameWrites[i].clear();
     }
+
+    vkUpdateDescriptorSets(ctx::vuDevice->device, static_cast<uint32>(writes.size()), writes.data(), 0, nullptr);
+    lastFlushStats.mergedWrites = static_cast<uint32>(writes.size());
+    lastFlushStats.updateCalls  = 1;
 }
 
-void Vu::VuResourceManager::writeUBO_ToGlobalPool(uint32 writeIndex, uint32 setIndex, const VuBuffer& buffer) {
+void Vu::VuResourceManager::flushDescriptorWrites(uint32 frameIndex) {
+    flushSets(frameIndex, 1);
+}
 
-    VkDescriptorBufferInfo bufferInfo{
-        .buffer = buffer.buffer,
-        .offset = 0,
-        .range = sizeof(GPU_FrameConst)
-    };
+void Vu::VuResourceManager::flushAllDescriptorWrites() {
+    flushSets(0, config::MAX_FRAMES_IN_FLIGHT);
+}
 
-    VkWriteDescriptorSet descriptorWrite{};
-    descriptorWrite.sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    descriptorWrite.dstSet          = ctx::vuDevice->globalDescriptorSets[setIndex];
-    descriptorWrite.dstBinding      = 0;
-    descriptorWrite.dstArrayElement = 0;
-    descriptorWrite.descriptorType  = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    descriptorWrite.descriptorCount = 1;
-    descriptorWrite.pBufferInfo     = &bufferInfo;
+Vu::uint32 Vu::VuResourceManager::getPendingWriteCount(uint32 frameIndex) {
+    return static_cast<uint32>(globalWrites.size() + frameWrites[frameIndex].size());
+}
 
-    vkUpdateDescriptorSets(ctx::vuDevice->device, 1, &descriptorWrite, 0, nullptr);
+const Vu::VuDescriptorFlushStats& Vu::VuResourceManager::getLastFlushStats() {
+    return lastFlushStats;
 }
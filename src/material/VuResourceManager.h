@@ -1,10 +1,10 @@
 #pragma once
 
 #include "VuBuffer.h"
+#include "VuConfig.h"
 
 
 namespace Vu {
-    struct VuBindlessConfigInfo;
 
     template<typename T>
     struct VuHandle;
@@ -93,10 +93,45 @@ namespace Vu {
 
 
     ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    struct VuDescriptorFlushStats {
+        //single element writes that were queued for the flushed sets
+        uint32 queuedWrites;
+        //VkWriteDescriptorSet entries left after dropping overwritten elements and merging contiguous ones
+        uint32 mergedWrites;
+        //vkUpdateDescriptorSets calls, at most one per flush
+        uint32 updateCalls;
+    };
+
     struct VuResourceManager {
     private:
         inline static VuBuffer bufferOfStorageBuffer;
 
+        struct PendingDescriptorWrite {
+            uint32                 binding;
+            uint32                 arrayElement;
+            VkDescriptorType       descriptorType;
+            VkDescriptorImageInfo  imageInfo;
+            VkDescriptorBufferInfo bufferInfo;
+        };
+
+        //the bindless set is shared by every frame, so each registration is queued once. an element is only
+        //written while no frame in flight can read it: new registrations, or slots retired for MAX_FRAMES_IN_FLIGHT
+        //frames. a live descriptor is replaced by writing a fresh element instead (see VuTextureStreamer).
+        //per frame set writes land when that frame starts recording again and its set is idle
+        inline static std::vector<PendingDescriptorWrite>                                           globalWrites;
+        inline static std::array<std::vector<PendingDescriptorWrite>, config::MAX_FRAMES_IN_FLIGHT> frameWrites;
+        inline static VuDescriptorFlushStats                                                        lastFlushStats{};
+
+        static void queueGlobalWrite(const PendingDescriptorWrite& write);
+
+        static void appendMergedWrites(VkDescriptorSet                      dstSet,
+                                       std::vector<PendingDescriptorWrite>& queue,
+                                       std::vector<VkWriteDescriptorSet>&   outWrites,
+                                       std::vector<VkDescriptorImageInfo>&  outImageInfos,
+                                       std::vector<VkDescriptorBufferInfo>& outBufferInfos);
+
+        static void flushSets(uint32 firstFrame, uint32 frameCount);
+
     public:
         static void init(const VuBindlessConfigInfo& info);
 
@@ -112,6 +147,19 @@ namespace Vu {
 
         static void writeSamplerToGlobalPool(uint32 writeIndex, const VkSampler& sampler);
 
-        static void writeUBO_ToGlobalPool(uint32 writeIndex, uint32 setIndex, const VuBuffer& buffer);
+        static void writeFrameUBO(uint32 frameIndex, const VuBuffer& buffer);
+
+        ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+        //applies the queued bindless writes and the ones of frameDescriptorSets[frameIndex] with a single vkUpdateDescriptorSets,
+        //call after the frame fence is waited and before the sets are bound
+        static void flushDescriptorWrites(uint32 frameIndex);
+
+        //same for every set at once, for load batches outside of the frame loop (device must be idle)
+        static void flushAllDescriptorWrites();
+
+        static uint32 getPendingWriteCount(uint32 frameIndex);
+
+        static const VuDescriptorFlushStats& getLastFlushStats();
     };
 }
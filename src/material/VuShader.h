@@ -17,25 +17,34 @@ namespace Vu {
     private:
     public:
         VuGraphicsShaderCreateInfo lastCreateInfo{};
+        //shared by every material of the shader, SC reserves only a handful of pipelines up front
+        VuGraphicsPipeline      pipeline{};
         std::vector<VuMaterial> materials;
 
 
         void initAsGraphicsShader(const VuGraphicsShaderCreateInfo& createInfo) {
             lastCreateInfo = createInfo;
+            pipeline.initGraphicsPipeline(ctx::vuDevice->globalPipelineLayout, createInfo.pipelineCache, createInfo.renderPass);
         }
 
         void uninit() {
             for (auto& material: materials) {
                 material.uninit();
             }
+            materials.clear();
+            pipeline.Dispose();
         }
 
-        //returns material Index
+        //returns material Index. only takes a material data block, no pipeline is created
         uint32 createMaterial() {
             VuMaterial material;
-            material.init({lastCreateInfo.pipelineCache, lastCreateInfo.renderPass});
+            material.init();
             materials.push_back(material);
-            return materials.capacity() - 1;
+            return static_cast<uint32>(materials.size() - 1);
+        }
+
+        void bindPipeline(const VkCommandBuffer& commandBuffer) const {
+            vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.pipeline);
         }
     };
 }
@@ -1,14 +1,26 @@
 #pragma once
 
+#include <atomic>
 #include <filesystem>
+#include <functional>
 #include <iostream>
+#include <memory>
+#include <span>
+#include <string>
+#include <variant>
+#include <vector>
 
 #include "Common.h"
+#include "VuCpuProfiler.h"
+#include "VuFile.h"
 #include "VuMesh.h"
+#include "VuMeshOptimizer.h"
+#include "VuTangentGenerator.h"
 #include <fastgltf/core.hpp>
 #include <fastgltf/tools.hpp>
 #include <fastgltf/util.hpp>
 #include <fastgltf/glm_element_traits.hpp>
+#include "VuJobSystem.h"
 #include "VuResourceManager.h"
 #include "VuTypes.h"
 
@@ -22,136 +34,280 @@ namespace Vu {
     };
 
 
+    //a parsed gltf whose external buffers are memory mapped instead of read into the heap. the asset points into
+    //the mappings, both move together
+    struct VuGltfAsset {
+        fastgltf::Asset           asset;
+        std::vector<VuMappedFile> buffers;
+    };
+
     struct VuAssetLoader {
 
         static void LoadGltf(const std::filesystem::path& path, VuMesh& dstMesh) {
+            VuMeshData             meshData{};
+            std::vector<VuSubMesh> subMeshes;
+            VkIndexType            indexType = VK_INDEX_TYPE_UINT32;
+            ParseGltf(path, meshData, subMeshes, indexType);
+            dstMesh.initFromData(meshData, subMeshes, indexType);
+        }
+
+        //everything of LoadGltf but the gpu buffers, touches no device state so it can run on any thread
+        static void ParseGltf(const std::filesystem::path& path,
+                              VuMeshData&                  meshData,
+                              std::vector<VuSubMesh>&      subMeshes,
+                              VkIndexType&                 indexType) {
 
+            const VuGltfAsset gltf = LoadAsset(path);
+            ReadPrimitive(gltf.asset, gltf.asset.meshes.at(0).primitives.at(0), path.filename().string(), meshData);
+
+            //weld, reorder for vertex cache, overdraw and fetch, then narrow indices
+            VuMeshOptimizeStats stats = VuMeshOptimizer::optimize(meshData, subMeshes, indexType);
+            stats.print(path.filename().string());
+        }
+
+        //parses the json and maps the external buffers, images stay referenced by their uri. the buffers are
+        //handed to fastgltf as views of the mappings, so accessors read the files in place
+        static VuGltfAsset LoadAsset(const std::filesystem::path& path) {
             fastgltf::Parser parser;
 
             auto data = fastgltf::GltfDataBuffer::FromPath(path);
 
             if (data.error() != fastgltf::Error::None) {
-                std::cout << "gltf file cannot be loaded!" << "\n";
+                throw std::runtime_error("gltf file cannot be loaded: " + path.string() + ", " + std::string(fastgltf::getErrorMessage(data.error())));
             }
 
-            auto asset = parser.loadGltf(
-                data.get(), path.parent_path(), fastgltf::Options::LoadExternalBuffers);
+            auto asset = parser.loadGltf(data.get(), path.parent_path(), fastgltf::Options::None);
             if (auto error = asset.error(); error != fastgltf::Error::None) {
-                std::cout << "Some error occurred while reading the buffer, parsing the JSON, or validating the data." << "\n";
+                throw std::runtime_error("gltf could not be parsed: " + path.string() + ", " + std::string(fastgltf::getErrorMessage(error)));
             }
 
-            auto mesh      = asset.get().meshes.at(0);
-            auto prims     = mesh.primitives;
-            auto primitive = prims.at(0);
-
-            auto parentPath = path.parent_path();
-
-
-            dstMesh.vertexBuffer.createHandle();
-            dstMesh.indexBuffer.createHandle();
-
+            VuGltfAsset result{std::move(asset.get()), {}};
+            result.buffers.reserve(result.asset.buffers.size());
+            for (fastgltf::Buffer& buffer: result.asset.buffers) {
+                const auto* uri = std::get_if<fastgltf::sources::URI>(&buffer.data);
+                //data uris and glb chunks are already decoded into memory by the parser
+                if (uri == nullptr || !uri->uri.isLocalPath()) {
+                    continue;
+                }
+                VuMappedFile&                file  = result.buffers.emplace_back(path.parent_path() / uri->uri.fspath(), VuFileAccess::Sequential);
+                const std::span<const uint8> bytes = file.bytes(uri->fileByteOffset, buffer.byteLength);
+                buffer.data = fastgltf::sources::ByteView{
+                    fastgltf::span<const std::byte>(reinterpret_cast<const std::byte *>(bytes.data()), bytes.size()),
+                    fastgltf::MimeType::GltfBuffer
+                };
+            }
+            return result;
+        }
 
-            //Indices
+        //the gltf and the external buffer files it references, what an import reads. only parses the json
+        static std::vector<std::filesystem::path> ListSourceFiles(const std::filesystem::path& path) {
+            fastgltf::Parser parser;
 
-            if (!primitive.indicesAccessor.has_value()) {
-                std::cout << "Primitive index accessor has not been set!" << "\n";
+            auto data = fastgltf::GltfDataBuffer::FromPath(path);
+            if (data.error() != fastgltf::Error::None) {
+                throw std::runtime_error("gltf file cannot be loaded: " + path.string() + ", " + std::string(fastgltf::getErrorMessage(data.error())));
+            }
+            auto asset = parser.loadGltf(data.get(), path.parent_path(), fastgltf::Options::None);
+            if (auto error = asset.error(); error != fastgltf::Error::None) {
+                throw std::runtime_error("gltf could not be parsed: " + path.string() + ", " + std::string(fastgltf::getErrorMessage(error)));
             }
-            auto&  indexAccesor = asset->accessors[primitive.indicesAccessor.value()];
-            uint64 indexCount   = indexAccesor.count;
-            dstMesh.indexBuffer.get()->init({
-                .length = indexCount,
-                .strideInBytes = sizeof(uint32),
-                .usageFlags = VK_BUFFER_USAGE_INDEX_BUFFER_BIT
-            });
-            dstMesh.indexBuffer.get()->map();
-            auto              indexSpanByte = dstMesh.indexBuffer.get()->getSpan(0, indexCount * sizeof(uint32));
-            std::span<uint32> indexSpan     = std::span(reinterpret_cast<uint32 *>(indexSpanByte.data()), indexCount);
-            fastgltf::iterateAccessorWithIndex<uint32>(
-                asset.get(), indexAccesor,
-                [&](uint32 index, std::size_t idx) { indexSpan[idx] = index; }
-            );
-            dstMesh.indexBuffer.get()->unmap();
 
+            std::vector<std::filesystem::path> files{path};
+            for (const fastgltf::Buffer& buffer: asset->buffers) {
+                const auto* uri = std::get_if<fastgltf::sources::URI>(&buffer.data);
+                if (uri != nullptr && uri->uri.isLocalPath()) {
+                    files.push_back(path.parent_path() / uri->uri.fspath());
+                }
+            }
+            return files;
+        }
 
+        //the streams of one triangle primitive, missing normals and tangents are generated. name is only used for logging
+        static void ReadPrimitive(const fastgltf::Asset&     asset,
+                                  const fastgltf::Primitive& primitive,
+                                  const std::string&         name,
+                                  VuMeshData&                meshData) {
             //Position
-            fastgltf::Attribute* positionIt       = primitive.findAttribute("POSITION");
-            fastgltf::Accessor&  positionAccessor = asset->accessors[positionIt->accessorIndex];
-
-            dstMesh.vertexCount = static_cast<uint32>(positionAccessor.count);
-            dstMesh.vertexBuffer.get()->init({
-                .length = dstMesh.vertexCount * dstMesh.totalAttributesSizePerVertex(),
-                .strideInBytes = 1U,
-                .usageFlags = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
-            });
-            VuResourceManager::registerStorageBuffer(dstMesh.vertexBuffer.index, *dstMesh.vertexBuffer.get());
-            dstMesh.vertexBuffer.get()->map();
-
-            std::span<uint8>  vertexSpanByte = dstMesh.vertexBuffer.get()->getSpan(0, sizeof(float3) * dstMesh.vertexCount);
-            std::span<float3> vertexSpan     = std::span(reinterpret_cast<float3 *>(vertexSpanByte.data()), dstMesh.vertexCount);
-
-            std::span<uint8> normalSpanByte = dstMesh.vertexBuffer.get()->getSpan(dstMesh.getNormalOffsetAsByte(),
-                                                                                  sizeof(float3) * dstMesh.vertexCount);
-            std::span<float3> normalSpan = std::span(reinterpret_cast<float3 *>(normalSpanByte.data()), dstMesh.vertexCount);
+            const fastgltf::Attribute* positionIt = primitive.findAttribute("POSITION");
+            if (positionIt == primitive.attributes.end()) {
+                throw std::runtime_error("primitive of " + name + " has no positions!");
+            }
+            const fastgltf::Accessor& positionAccessor = asset.accessors[positionIt->accessorIndex];
 
-            std::span<uint8> tangentSpanByte = dstMesh.vertexBuffer.get()->getSpan(dstMesh.getTangentOffsetAsByte(),
-                                                                                   sizeof(float4) * dstMesh.vertexCount);
-            std::span<float4> tangentSpan = std::span(reinterpret_cast<float4 *>(tangentSpanByte.data()), dstMesh.vertexCount);
+            const size_t vertexCount = positionAccessor.count;
+            meshData.positions.resize(vertexCount);
+            meshData.normals.resize(vertexCount);
+            meshData.tangents.resize(vertexCount);
+            meshData.uvs.resize(vertexCount);
 
-            std::span<uint8> uvSpanByte = dstMesh.vertexBuffer.get()->getSpan(dstMesh.getUV_OffsetAsByte(),
-                                                                              sizeof(float2) * dstMesh.vertexCount);
-            std::span<float2> uvSpan = std::span(reinterpret_cast<float2 *>(uvSpanByte.data()), dstMesh.vertexCount);
+            //Indices, a non indexed primitive draws its vertices in order
+            if (!primitive.indicesAccessor.has_value()) {
+                meshData.indices.resize(vertexCount);
+                for (size_t i = 0; i < vertexCount; i++) {
+                    meshData.indices[i] = static_cast<uint32>(i);
+                }
+            } else {
+                const fastgltf::Accessor& indexAccesor = asset.accessors[primitive.indicesAccessor.value()];
+                meshData.indices.resize(indexAccesor.count);
+                fastgltf::iterateAccessorWithIndex<uint32>(
+                    asset, indexAccesor,
+                    [&](uint32 index, std::size_t idx) { meshData.indices[idx] = index; }
+                );
+            }
 
             //pos
             {
                 fastgltf::iterateAccessorWithIndex<glm::vec3>(
-                    asset.get(), positionAccessor,
-                    [&](const glm::vec3 pos,const std::size_t idx) { vertexSpan[idx] = pos; }
+                    asset, positionAccessor,
+                    [&](const glm::vec3 pos,const std::size_t idx) { meshData.positions[idx] = pos; }
                 );
             }
 
             //normal
             {
-                auto* normalIt       = primitive.findAttribute("NORMAL");
-                auto& normalAccessor = asset->accessors[normalIt->accessorIndex];
-
-                fastgltf::iterateAccessorWithIndex<glm::vec3>(
-                    asset.get(), normalAccessor,
-                    [&](const glm::vec3 normal,const std::size_t idx) { normalSpan[idx] = normal; }
-                );
+                const auto* normalIt = primitive.findAttribute("NORMAL");
+                if (normalIt == primitive.attributes.end()) {
+                    std::cout << "[INFO]: " << name << " has no normals, generating them" << std::endl;
+                    VuTangentGenerator::generateNormals(meshData.indices, meshData.positions, meshData.normals);
+                } else {
+                    const auto& normalAccessor = asset.accessors[normalIt->accessorIndex];
 
+                    fastgltf::iterateAccessorWithIndex<glm::vec3>(
+                        asset, normalAccessor,
+                        [&](const glm::vec3 normal,const std::size_t idx) { meshData.normals[idx] = normal; }
+                    );
+                }
             }
-            //uv
+            //uv, left at zero when missing, tangents then fall back to any direction perpendicular to the normal
             {
-                auto* uvIter     = primitive.findAttribute("TEXCOORD_0");
-                auto& uvAccessor = asset->accessors[uvIter->accessorIndex];
+                const auto* uvIter = primitive.findAttribute("TEXCOORD_0");
+                if (uvIter != primitive.attributes.end()) {
+                    const auto& uvAccessor = asset.accessors[uvIter->accessorIndex];
 
-                fastgltf::iterateAccessorWithIndex<glm::vec2>(
-                    asset.get(), uvAccessor,
-                    [&uvSpan](const glm::vec2 uv, const std::size_t idx) { uvSpan[idx] = uv; }
-                );
+                    fastgltf::iterateAccessorWithIndex<glm::vec2>(
+                        asset, uvAccessor,
+                        [&meshData](const glm::vec2 uv, const std::size_t idx) { meshData.uvs[idx] = uv; }
+                    );
+                }
             }
 
-            //tangent
+            //tangent, an accessor without a buffer view is all zeros
             {
-                auto* tangentIt = primitive.findAttribute("TANGENT");
-
-                fastgltf::Accessor& tangentAccessor    = asset->accessors[tangentIt->accessorIndex];
-                auto                tangentbufferIndex = tangentAccessor.bufferViewIndex.value();
-                if (tangentbufferIndex == 0U && tangentAccessor.byteOffset == 0U) {
-                    std::cout << "Gltf file has no tangents" << std::endl;
-
-                    Vu::VuMesh::calculateTangents(indexSpan, vertexSpan, normalSpan, uvSpan, tangentSpan);
-
+                const auto* tangentIt = primitive.findAttribute("TANGENT");
+                if (tangentIt == primitive.attributes.end() || !asset.accessors[tangentIt->accessorIndex].bufferViewIndex.has_value()) {
+                    std::cout << "[INFO]: " << name << " has no tangents, generating them" << std::endl;
+                    VuTangentGenerator::generateTangents(meshData.indices, meshData.positions, meshData.normals, meshData.uvs, meshData.tangents);
                 } else {
                     fastgltf::iterateAccessorWithIndex<float4>(
-                        asset.get(), tangentAccessor,
-                        [&tangentSpan](const float4 tangent, const std::size_t idx) { tangentSpan[idx] = tangent; }
+                        asset, asset.accessors[tangentIt->accessorIndex],
+                        [&meshData](const float4 tangent, const std::size_t idx) { meshData.tangents[idx] = tangent; }
                     );
                 }
             }
+        }
+    };
+
+    struct VuGltfImportInfo;
+    struct VuGltfScene;
+
+    //loads a set of meshes and gltf scenes concurrently. every asset is parsed, given tangents and optimized in
+    //its own job, the gpu buffers are created on the thread that polls, since the resource pools are not thread
+    //safe. textures need no batch, VuTextureStreamer already decodes every registration in a background job
+    struct VuAssetBatch {
+    public:
+        VuAssetBatch() = default;
+
+        //the jobs write through pointers into the requests, a batch left early by an exception must not free
+        //them while a job still runs
+        ~VuAssetBatch() {
+            VuJobSystem::wait(counter);
+        }
+
+        VuAssetBatch(const VuAssetBatch&)            = delete;
+        VuAssetBatch& operator=(const VuAssetBatch&) = delete;
+        VuAssetBatch(VuAssetBatch&&)                 = delete;
+        VuAssetBatch& operator=(VuAssetBatch&&)      = delete;
+
+        //dstMesh becomes valid once poll() returned true or wait() returned, add everything before start()
+        void addMesh(const std::filesystem::path& path, VuMesh& dstMesh) {
+            struct Parsed {
+                VuMeshData             data{};
+                std::vector<VuSubMesh> subMeshes;
+                VkIndexType            indexType = VK_INDEX_TYPE_UINT32;
+            };
+            auto parsed = std::make_shared<Parsed>();
+            add(path,
+                [path, parsed] { VuAssetLoader::ParseGltf(path, parsed->data, parsed->subMeshes, parsed->indexType); },
+                [parsed, &dstMesh] { dstMesh.initFromData(parsed->data, parsed->subMeshes, parsed->indexType); });
+        }
+
+        //every node, mesh and material of the file, see VuGltfImporter. defined in VuGltfImporter.h
+        void addScene(const std::filesystem::path& path, const VuGltfImportInfo& info, VuGltfScene& dstScene);
+
+        //returns immediately, the caller can record, create pipelines or register textures meanwhile
+        void start() {
+            for (std::unique_ptr<Request>& request: requests) {
+                VuJobSystem::run([asset = request.get()] {
+                    VU_CPU_ZONE("parse gltf");
+                    try {
+                        asset->parse();
+                    } catch (const std::exception& e) {
+                        asset->error = e.what();
+                    }
+                    asset->parsed.store(true, std::memory_order_release);
+                }, &counter);
+            }
+        }
+
+        //uploads what finished parsing, true when every asset of the batch is valid. throws the first load error
+        bool poll() {
+            bool done = true;
+            for (std::unique_ptr<Request>& request: requests) {
+                if (request->uploaded) {
+                    continue;
+                }
+                if (!request->parsed.load(std::memory_order_acquire)) {
+                    done = false;
+                    continue;
+                }
+                if (!request->error.empty()) {
+                    throw std::runtime_error(request->path.string() + ": " + request->error);
+                }
+                request->upload();
+                //drops the cpu copy
+                request->parse    = {};
+                request->upload   = {};
+                request->uploaded = true;
+            }
+            return done;
+        }
 
+        //helps the workers until every asset is parsed, then uploads the rest
+        void wait() {
+            VuJobSystem::wait(counter);
+            poll();
+        }
 
-            dstMesh.vertexBuffer.get()->unmap();
+    private:
+        //parse runs in a job, upload on the polling thread, they share the parsed data through their captures
+        struct Request {
+            std::filesystem::path path;
+            std::function<void()> parse;
+            std::function<void()> upload;
+            std::string           error;
+            std::atomic<bool>     parsed   = false;
+            bool                  uploaded = false;
+        };
+
+        std::vector<std::unique_ptr<Request>> requests;
+        VuJobCounter                          counter{};
+
+        void add(const std::filesystem::path& path, std::function<void()> parse, std::function<void()> upload) {
+            auto request    = std::make_unique<Request>();
+            request->path   = path;
+            request->parse  = std::move(parse);
+            request->upload = std::move(upload);
+            requests.push_back(std::move(request));
         }
     };
 }
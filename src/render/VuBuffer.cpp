@@ -15,7 +15,7 @@ namespace Vu {
     void VuBuffer::init(const VuBufferCreateInfo& info) {
 
         VkCheck(createBuffer(ctx::vuDevice->device, ctx::vuDevice->physicalDevice, (info.length * info.strideInBytes), info.usageFlags,
-                             info.memoryPropertyFlags, buffer, memory));
+                             info.memoryPropertyFlags, buffer, memory, &memoryFlags));
         createInfo = info;
         stride     = info.strideInBytes;
         lenght     = info.length;
@@ -54,6 +54,10 @@ namespace Vu {
         return VK_SUCCESS;
     }
 
+    bool VuBuffer::isHostCached() const {
+        return (memoryFlags & VK_MEMORY_PROPERTY_HOST_CACHED_BIT) != 0U;
+    }
+
     VkDeviceSize VuBuffer::getSizeInBytes() {
         return lenght * stride;
     }
@@ -80,13 +84,14 @@ namespace Vu {
     }
 
     VkResult VuBuffer::createBuffer(
-        VkDevice              device,
-        VkPhysicalDevice      physicalDevice,
-        VkDeviceSize          size,
-        VkBufferUsageFlags    usage,
-        VkMemoryPropertyFlags properties,
-        VkBuffer&             buffer,
-        VkDeviceMemory&       bufferMemory) {
+        VkDevice               device,
+        VkPhysicalDevice       physicalDevice,
+        VkDeviceSize           size,
+        VkBufferUsageFlags     usage,
+        VkMemoryPropertyFlags  properties,
+        VkBuffer&              buffer,
+        VkDeviceMemory&        bufferMemory,
+        VkMemoryPropertyFlags* outMemoryFlags) {
 
         // Create buffer
         VkBufferCreateInfo bufferInfo{};
@@ -150,6 +155,9 @@ namespace Vu {
             return result;
         }
 
+        if (outMemoryFlags != nullptr) {
+            *outMemoryFlags = memProperties.memoryTypes[memoryTypeIndex].propertyFlags;
+        }
         return VK_SUCCESS;
     }
 }
@@ -14,12 +14,14 @@ namespace Vu {
 
     struct VuBuffer {
     public:
-        VuBufferCreateInfo createInfo;
-        VkBuffer           buffer;
-        VkDeviceMemory     memory;
-        VkDeviceSize       lenght;
-        VkDeviceSize       stride;
-        void*              mapPtr;
+        VuBufferCreateInfo    createInfo;
+        VkBuffer              buffer;
+        VkDeviceMemory        memory;
+        VkDeviceSize          lenght;
+        VkDeviceSize          stride;
+        void*                 mapPtr;
+        //of the memory type it was allocated from, can hold more than createInfo asked for
+        VkMemoryPropertyFlags memoryFlags;
 
         static inline VuBuffer* globalStagingBuffer;
 
@@ -41,17 +43,21 @@ namespace Vu {
 
         std::span<uint8> getSpan(VkDeviceSize start, VkDeviceSize byteLength);
 
+        //false for write combined memory, reading the mapping back is then very slow
+        bool isHostCached() const;
+
         static void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
 
         static VkDeviceSize alignedSize(VkDeviceSize value, VkDeviceSize alignment);
 
         static VkResult createBuffer(
-            VkDevice              device,
-            VkPhysicalDevice      physicalDevice,
-            VkDeviceSize          size,
-            VkBufferUsageFlags    usage,
-            VkMemoryPropertyFlags properties,
-            VkBuffer&             buffer,
-            VkDeviceMemory&       bufferMemory);
+            VkDevice               device,
+            VkPhysicalDevice       physicalDevice,
+            VkDeviceSize           size,
+            VkBufferUsageFlags     usage,
+            VkMemoryPropertyFlags  properties,
+            VkBuffer&              buffer,
+            VkDeviceMemory&        bufferMemory,
+            VkMemoryPropertyFlags* outMemoryFlags = nullptr);
     };
 }
@@ -23,17 +23,26 @@ namespace Vu {
         VkInstance                   instance;
         VkDebugUtilsMessengerEXT     debugMessenger;
         VkPhysicalDevice             physicalDevice;
+        VkPhysicalDeviceProperties   physicalDeviceProperties;
         QueueFamilyIndices           queueFamilyIndices;
         VkDevice                     device;
         VkQueue                      graphicsQueue;
         VkQueue                      presentQueue;
         VkCommandPool                commandPool;
+        //set 0: one long lived bindless set shared by every frame
         VkDescriptorSetLayout        globalDescriptorSetLayout;
-        std::vector<VkDescriptorSet> globalDescriptorSets;
+        VkDescriptorSet              globalDescriptorSet;
         VkDescriptorPool             descriptorPool;
+        //set 1: tiny per frame set, only the frame constants ubo
+        VkDescriptorSetLayout        frameDescriptorSetLayout;
+        std::vector<VkDescriptorSet> frameDescriptorSets;
+        VkDescriptorPool             frameDescriptorPool;
         VkDescriptorPool             uiDescriptorPool;
         VkPipelineLayout             globalPipelineLayout;
 
+        //synchronization2 is an extension in vulkan sc, its commands have to be fetched from the device
+        PFN_vkCmdPipelineBarrier2KHR cmdPipelineBarrier2 = nullptr;
+
 
         VuDisposeStack disposeStack;
 
@@ -60,6 +69,7 @@ namespace Vu {
 
         void initPhysicalDevice() {
             createPhysicalDevice(instance, physicalDevice);
+            vkGetPhysicalDeviceProperties(physicalDevice, &physicalDeviceProperties);
         }
 
         void initDevice(const VuDeviceCreateInfo& info) {
@@ -75,9 +85,17 @@ namespace Vu {
                 vkDestroyDevice(device, nullptr);
             });
 
+            initDeviceFunctions();
             initCommandPool();
         }
 
+        void initDeviceFunctions() {
+            cmdPipelineBarrier2 = reinterpret_cast<PFN_vkCmdPipelineBarrier2KHR>(vkGetDeviceProcAddr(device, "vkCmdPipelineBarrier2KHR"));
+            if (cmdPipelineBarrier2 == nullptr) {
+                throw std::runtime_error("vkCmdPipelineBarrier2KHR is not available, enable VK_KHR_synchronization2!");
+            }
+        }
+
         void initCommandPool() {
 
             VkCommandPoolMemoryReservationCreateInfo poolMemoryReservationInfo{
@@ -101,9 +119,15 @@ namespace Vu {
                 vkDestroyDescriptorSetLayout(device, globalDescriptorSetLayout, nullptr);
 
             });
+            initFrameDescriptorSetLayout(info);
+            disposeStack.push([this] {
+                vkDestroyDescriptorSetLayout(device, frameDescriptorSetLayout, nullptr);
+            });
             initDescriptorPool(info);
-            initGlobalDescriptorSet(maxFramesInFlight);
-            std::array descSetLayouts{globalDescriptorSetLayout};
+            initFrameDescriptorPool(info, maxFramesInFlight);
+            initGlobalDescriptorSet();
+            initFrameDescriptorSets(maxFramesInFlight);
+            std::array descSetLayouts{globalDescriptorSetLayout, frameDescriptorSetLayout};
 
             createPipelineLayout(device, descSetLayouts, config::PUSH_CONST_SIZE, globalPipelineLayout);
             disposeStack.push([this] {
@@ -112,12 +136,6 @@ namespace Vu {
         }
 
         void initDescriptorSetLayout(const VuBindlessConfigInfo& info) {
-            VkDescriptorSetLayoutBinding ubo{
-                .binding = info.uboBinding,
-                .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-                .descriptorCount = info.uboCount,
-                .stageFlags = VK_SHADER_STAGE_ALL,
-            };
             VkDescriptorSetLayoutBinding sampler{
                 .binding = info.samplerBinding,
                 .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER,
@@ -144,7 +162,6 @@ namespace Vu {
                 .stageFlags = VK_SHADER_STAGE_ALL,
             };
             std::array descriptorSetLayoutBindings{
-                ubo,
                 sampler,
                 sampledImage,
                 storageImage,
@@ -162,7 +179,7 @@ namespace Vu {
                     | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT
                     | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
 
-            std::array descriptorSetLayoutFlags{flag, flag, flag, flag, flag};
+            std::array descriptorSetLayoutFlags{flag, flag, flag, flag};
 
             VkDescriptorSetLayoutBindingFlagsCreateInfo binding_flags{};
             binding_flags.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
@@ -173,11 +190,25 @@ namespace Vu {
             VkCheck(vkCreateDescriptorSetLayout(device, &globalSetLayout, nullptr, &globalDescriptorSetLayout));
         }
 
+        void initFrameDescriptorSetLayout(const VuBindlessConfigInfo& info) {
+            VkDescriptorSetLayoutBinding ubo{
+                .binding = info.uboBinding,
+                .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+                .descriptorCount = info.uboCount,
+                .stageFlags = VK_SHADER_STAGE_ALL,
+            };
+            VkDescriptorSetLayoutCreateInfo frameSetLayout{
+                .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+                .bindingCount = 1,
+                .pBindings = &ubo,
+            };
+            VkCheck(vkCreateDescriptorSetLayout(device, &frameSetLayout, nullptr, &frameDescriptorSetLayout));
+        }
+
         void initDescriptorPool(const VuBindlessConfigInfo& info) {
 
-            std::array<VkDescriptorPoolSize, 5> poolSizes{
+            std::array<VkDescriptorPoolSize, 4> poolSizes{
                 {
-                    {.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, .descriptorCount = info.uboCount},
                     {.type = VK_DESCRIPTOR_TYPE_SAMPLER, .descriptorCount = info.samplerCount},
                     {.type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, .descriptorCount = info.sampledImageCount},
                     {.type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, .descriptorCount = info.storageImageCount},
@@ -188,25 +219,50 @@ namespace Vu {
             VkDescriptorPoolCreateInfo poolInfo{
                 .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
                 .flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT,
-                .maxSets = 2,
+                .maxSets = 1,
                 .poolSizeCount = static_cast<uint32_t>(poolSizes.size()),
                 .pPoolSizes = poolSizes.data(),
             };
             VkCheck(vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool));
         }
 
-        void initGlobalDescriptorSet(uint32 maxFramesInFligth) {
-            std::vector globalLayouts(maxFramesInFligth, globalDescriptorSetLayout);
+        void initFrameDescriptorPool(const VuBindlessConfigInfo& info, uint32 maxFramesInFligth) {
+            VkDescriptorPoolSize poolSize{
+                .type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+                .descriptorCount = info.uboCount * maxFramesInFligth,
+            };
+
+            VkDescriptorPoolCreateInfo poolInfo{
+                .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+                .maxSets = maxFramesInFligth,
+                .poolSizeCount = 1,
+                .pPoolSizes = &poolSize,
+            };
+            VkCheck(vkCreateDescriptorPool(device, &poolInfo, nullptr, &frameDescriptorPool));
+        }
 
-            VkDescriptorSetAllocateInfo globalSetsAllocInfo{
+        void initGlobalDescriptorSet() {
+            VkDescriptorSetAllocateInfo globalSetAllocInfo{
                 .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
                 .descriptorPool = descriptorPool,
+                .descriptorSetCount = 1,
+                .pSetLayouts = &globalDescriptorSetLayout,
+            };
+            VkCheck(vkAllocateDescriptorSets(device, &globalSetAllocInfo, &globalDescriptorSet));
+        }
+
+        void initFrameDescriptorSets(uint32 maxFramesInFligth) {
+            std::vector frameLayouts(maxFramesInFligth, frameDescriptorSetLayout);
+
+            VkDescriptorSetAllocateInfo frameSetsAllocInfo{
+                .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+                .descriptorPool = frameDescriptorPool,
                 .descriptorSetCount = maxFramesInFligth,
-                .pSetLayouts = globalLayouts.data(),
+                .pSetLayouts = frameLayouts.data(),
             };
 
-            globalDescriptorSets.resize(maxFramesInFligth);
-            VkCheck(vkAllocateDescriptorSets(device, &globalSetsAllocInfo, globalDescriptorSets.data()));
+            frameDescriptorSets.resize(maxFramesInFligth);
+            VkCheck(vkAllocateDescriptorSets(device, &frameSetsAllocInfo, frameDescriptorSets.data()));
         }
 
 
@@ -0,0 +1,170 @@
+#pragma once
+
+#include "Common.h"
+#include "VuFile.h"
+#include "VuRenderer.h"
+#include "VuUtils.h"
+
+namespace Vu {
+
+    //the vulkan sc object reservations and the feature chain a scene creates its device with.
+    //the structs point at each other, so the object must stay in place until the device exists
+    struct VuDeviceSetup {
+        //mapped for the device lifetime, the cache is created with USE_APPLICATION_STORAGE and reads it in place
+        VuMappedFile                             pipelineCacheBinary;
+        VkPipelineCacheCreateInfo                pipelineCacheCreateInfo{};
+        VkPipelinePoolSize                       poolSize{};
+        VkDeviceObjectReservationCreateInfo      scReservationCreateInfo{};
+        VkPhysicalDeviceVulkanSC10Features       sc10Features{};
+        VkPhysicalDeviceSynchronization2Features synchronization2Features{};
+        VkPhysicalDeviceVulkan12Features         vkPhysicalDeviceVulkan12Features{};
+        VkPhysicalDeviceFeatures2                deviceFeatures2{};
+
+        VuDeviceSetup() = default;
+
+        VuDeviceSetup(const VuDeviceSetup&)            = delete;
+        VuDeviceSetup& operator=(const VuDeviceSetup&) = delete;
+
+        void init(const VuRenderBackendInfo& backendInfo) {
+            pipelineCacheBinary.open("assets\\shaders\\pipeline_cache.bin");
+
+            pipelineCacheCreateInfo = {
+                .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+                .pNext = nullptr,
+                .flags = VK_PIPELINE_CACHE_CREATE_READ_ONLY_BIT | VK_PIPELINE_CACHE_CREATE_USE_APPLICATION_STORAGE_BIT,
+                .initialDataSize = pipelineCacheBinary.size(),
+                .pInitialData = pipelineCacheBinary.bytes().data()
+            };
+
+            poolSize = {
+                .sType = VK_STRUCTURE_TYPE_PIPELINE_POOL_SIZE,
+                .pNext = nullptr,
+                .poolEntrySize = 8U * 1024U * 1024U,
+                .poolEntryCount = 8U
+            };
+
+            scReservationCreateInfo = {
+                .sType = VK_STRUCTURE_TYPE_DEVICE_OBJECT_RESERVATION_CREATE_INFO,
+                .pNext = nullptr,
+                .pipelineCacheCreateInfoCount = 1U,
+                .pPipelineCacheCreateInfos = &pipelineCacheCreateInfo,
+                .pipelinePoolSizeCount = 1U,
+                .pPipelinePoolSizes = &poolSize,
+                .semaphoreRequestCount = 32U,
+                .commandBufferRequestCount = 32U,
+                .fenceRequestCount = 32U,
+                .deviceMemoryRequestCount = 4096U,
+                .bufferRequestCount = 4096U,
+                .imageRequestCount = 4096U,
+                .eventRequestCount = 32U,
+                .queryPoolRequestCount = 32U,
+                .bufferViewRequestCount = 4096U,
+                .imageViewRequestCount = 4096U,
+                .layeredImageViewRequestCount = 32U,
+                .pipelineCacheRequestCount = 32U,
+                .pipelineLayoutRequestCount = 32U,
+                .renderPassRequestCount = 32U,
+                .graphicsPipelineRequestCount = 32U,
+                .computePipelineRequestCount = 32U,
+                .descriptorSetLayoutRequestCount = 32U,
+                .samplerRequestCount = config::MAX_SAMPLER_COUNT,
+                .descriptorPoolRequestCount = 32U,
+                .descriptorSetRequestCount = 32U,
+                .framebufferRequestCount = 32U,
+                .commandPoolRequestCount = 32U,
+                .samplerYcbcrConversionRequestCount = 0U,
+                .surfaceRequestCount = 32U,
+                .swapchainRequestCount = 32U,
+                .displayModeRequestCount = 32U,
+                .subpassDescriptionRequestCount = 32U,
+                .attachmentDescriptionRequestCount = 32U,
+                .descriptorSetLayoutBindingRequestCount = 32U,
+                .descriptorSetLayoutBindingLimit = 32U,
+                .maxImageViewMipLevels = 16U,
+                .maxImageViewArrayLayers = 8U,
+                .maxLayeredImageViewMipLevels = 8U,
+                .maxOcclusionQueriesPerPool = 32U,
+                .maxPipelineStatisticsQueriesPerPool = 32U,
+                .maxTimestampQueriesPerPool = 128U,
+                .maxImmutableSamplersPerDescriptorSetLayout = 32U,
+            };
+
+            sc10Features = {
+                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_SC_1_0_FEATURES,
+                .pNext = &scReservationCreateInfo,
+                .shaderAtomicInstructions = VK_FALSE
+            };
+
+            synchronization2Features = {
+                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES,
+                .pNext = &sc10Features,
+                .synchronization2 = VK_TRUE
+            };
+
+            vkPhysicalDeviceVulkan12Features = {
+                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+                .pNext = &synchronization2Features,
+                .samplerMirrorClampToEdge = VK_FALSE,
+                .drawIndirectCount = VK_FALSE,
+                .storageBuffer8BitAccess = VK_FALSE,
+                .uniformAndStorageBuffer8BitAccess = VK_FALSE,
+                .storagePushConstant8 = VK_FALSE,
+                .shaderBufferInt64Atomics = VK_FALSE,
+                .shaderSharedInt64Atomics = VK_FALSE,
+                .shaderFloat16 = VK_FALSE,
+                .shaderInt8 = VK_FALSE,
+                .descriptorIndexing = VK_TRUE,
+                .shaderInputAttachmentArrayDynamicIndexing = VK_TRUE,
+                .shaderUniformTexelBufferArrayDynamicIndexing = VK_TRUE,
+                .shaderStorageTexelBufferArrayDynamicIndexing = VK_TRUE,
+                .shaderUniformBufferArrayNonUniformIndexing = VK_TRUE,
+                .shaderSampledImageArrayNonUniformIndexing = VK_TRUE,
+                .shaderStorageBufferArrayNonUniformIndexing = VK_TRUE,
+                .shaderStorageImageArrayNonUniformIndexing = VK_TRUE,
+                .shaderInputAttachmentArrayNonUniformIndexing = VK_TRUE,
+                .shaderUniformTexelBufferArrayNonUniformIndexing = VK_TRUE,
+                .shaderStorageTexelBufferArrayNonUniformIndexing = VK_TRUE,
+                .descriptorBindingUniformBufferUpdateAfterBind = VK_TRUE,
+                .descriptorBindingSampledImageUpdateAfterBind = VK_TRUE,
+                .descriptorBindingStorageImageUpdateAfterBind = VK_TRUE,
+                .descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE,
+                .descriptorBindingUniformTexelBufferUpdateAfterBind = VK_TRUE,
+                .descriptorBindingStorageTexelBufferUpdateAfterBind = VK_TRUE,
+                .descriptorBindingUpdateUnusedWhilePending = VK_TRUE,
+                .descriptorBindingPartiallyBound = VK_TRUE,
+                .descriptorBindingVariableDescriptorCount = VK_FALSE,
+                .runtimeDescriptorArray = VK_TRUE,
+                .samplerFilterMinmax = VK_FALSE,
+                .scalarBlockLayout = VK_TRUE,
+                .imagelessFramebuffer = VK_FALSE,
+                .uniformBufferStandardLayout = VK_FALSE,
+                .shaderSubgroupExtendedTypes = VK_FALSE,
+                .separateDepthStencilLayouts = VK_FALSE,
+                .hostQueryReset = VK_FALSE,
+                .timelineSemaphore = VK_FALSE,
+                .bufferDeviceAddress = VK_TRUE,
+                .bufferDeviceAddressCaptureReplay = VK_FALSE,
+                .bufferDeviceAddressMultiDevice = VK_FALSE,
+                .vulkanMemoryModel = VK_FALSE,
+                .vulkanMemoryModelDeviceScope = VK_FALSE,
+                .vulkanMemoryModelAvailabilityVisibilityChains = VK_FALSE,
+                .shaderOutputViewportIndex = VK_FALSE,
+                .shaderOutputLayer = VK_FALSE,
+                .subgroupBroadcastDynamicId = VK_FALSE,
+            };
+
+
+            deviceFeatures2 = {
+                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+                .pNext = &vkPhysicalDeviceVulkan12Features,
+                .features = {
+                    .samplerAnisotropy = VK_TRUE,
+                    .textureCompressionBC = VK_TRUE,
+                    .occlusionQueryPrecise = backendInfo.pipelineStatistics.enabled ? VK_TRUE : VK_FALSE,
+                    .pipelineStatisticsQuery = backendInfo.pipelineStatistics.enabled ? VK_TRUE : VK_FALSE,
+                    .shaderInt64 = VK_TRUE
+                },
+            };
+        }
+    };
+}
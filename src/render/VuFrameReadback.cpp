@@ -0,0 +1,179 @@
+#include "VuFrameReadback.h"
+
+#include <format>
+#include <iostream>
+
+#include "VuImageWriter.h"
+
+namespace Vu {
+
+    void VuFrameReadback::init(const VuFrameReadbackCreateInfo& info, VkExtent2D imageExtent, VkFormat imageFormat) {
+        createInfo          = info;
+        createInfo.interval = std::max(info.interval, 1U);
+        extent              = imageExtent;
+        format              = imageFormat;
+        stats               = {};
+        writtenDumps        = 0U;
+
+        //only 4 byte texels, every color attachment format this renderer picks is one
+        switch (format) {
+            case VK_FORMAT_R8G8B8A8_UNORM:
+            case VK_FORMAT_R8G8B8A8_SRGB:
+            case VK_FORMAT_B8G8R8A8_UNORM:
+            case VK_FORMAT_B8G8R8A8_SRGB:
+                break;
+            default:
+                throw std::runtime_error("frame readback: unsupported attachment format!");
+        }
+
+        for (Slot& slot: slots) {
+            slot.buffer = VuBuffer{};
+            slot.buffer.init({
+                .length = frameSize(),
+                .strideInBytes = 1U,
+                .usageFlags = VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                .memoryPropertyFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            });
+            slot.buffer.map();
+            slot.pending = false;
+        }
+
+        if (createInfo.dumpFormat != VuFrameDumpFormat::None) {
+            std::filesystem::create_directories(createInfo.dumpDirectory);
+            stopWriter = false;
+            writer     = std::thread(&VuFrameReadback::writerLoop, this);
+        }
+    }
+
+    void VuFrameReadback::uninit() {
+        {
+            std::lock_guard lock(dumpMutex);
+            stopWriter = true;
+        }
+        dumpSignal.notify_all();
+        if (writer.joinable()) {
+            writer.join();
+        }
+
+        //expects the device to be idle, the buffer memory itself can not be freed on vulkan sc
+        for (Slot& slot: slots) {
+            slot.buffer.uninit();
+            slot.pending = false;
+        }
+    }
+
+    bool VuFrameReadback::wantsFrame(uint64 frameNumber) const {
+        return frameNumber % createInfo.interval == 0U;
+    }
+
+    VkBuffer VuFrameReadback::getBuffer(uint32 frameSlot) const {
+        return slots[frameSlot].buffer.buffer;
+    }
+
+    void VuFrameReadback::recordCopy(VkCommandBuffer commandBuffer, VkImage image, uint32 frameSlot, uint64 frameNumber) {
+        if (!wantsFrame(frameNumber)) {
+            return;
+        }
+
+        VkBufferImageCopy region{};
+        region.bufferOffset                    = 0U;
+        region.bufferRowLength                 = 0U;
+        region.bufferImageHeight               = 0U;
+        region.imageSubresource.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel       = 0U;
+        region.imageSubresource.baseArrayLayer = 0U;
+        region.imageSubresource.layerCount     = 1U;
+        region.imageOffset                     = {0, 0, 0};
+        region.imageExtent                     = {extent.width, extent.height, 1U};
+        vkCmdCopyImageToBuffer(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, slots[frameSlot].buffer.buffer, 1U, &region);
+
+        slots[frameSlot].pending     = true;
+        slots[frameSlot].frameNumber = frameNumber;
+        stats.copiedFrames++;
+    }
+
+    void VuFrameReadback::collect(uint32 frameSlot) {
+        Slot& slot = slots[frameSlot];
+        if (!slot.pending) {
+            return;
+        }
+        slot.pending = false;
+
+        const std::span<const uint8> pixels = slot.buffer.getSpan(0U, frameSize());
+
+        if (createInfo.callback) {
+            createInfo.callback({slot.frameNumber, extent.width, extent.height, format, pixels});
+        }
+        stats.deliveredFrames++;
+
+        if (createInfo.dumpFormat == VuFrameDumpFormat::None) {
+            return;
+        }
+
+        //a copy out of the mapped buffer is all the frame loop pays for a dump, encoding happens on the writer
+        std::unique_lock lock(dumpMutex);
+        if (dumps.size() >= createInfo.maxQueuedDumps) {
+            if (stats.droppedDumps == 0U) {
+                std::cerr << "[WARNING]: frame dumps can not keep up, frames are skipped" << std::endl;
+            }
+            stats.droppedDumps++;
+            return;
+        }
+        dumps.push_back({slot.frameNumber, std::vector<uint8>(pixels.begin(), pixels.end())});
+        lock.unlock();
+        dumpSignal.notify_one();
+    }
+
+    VuFrameReadbackStats VuFrameReadback::getStats() const {
+        VuFrameReadbackStats result = stats;
+        result.writtenDumps         = writtenDumps;
+        return result;
+    }
+
+    void VuFrameReadback::writerLoop() {
+        while (true) {
+            DumpJob job;
+            {
+                std::unique_lock lock(dumpMutex);
+                dumpSignal.wait(lock, [this] { return stopWriter || !dumps.empty(); });
+                //pending dumps are still written on shutdown
+                if (dumps.empty()) {
+                    return;
+                }
+                job = std::move(dumps.front());
+                dumps.pop_front();
+            }
+
+            try {
+                writeDump(job);
+                writtenDumps++;
+            } catch (const std::exception& e) {
+                std::cerr << "[ERROR]: frame dump failed: " << e.what() << std::endl;
+            }
+        }
+    }
+
+    void VuFrameReadback::writeDump(DumpJob& job) const {
+        const std::string name = std::format("frame_{:06}_{}x{}", job.frameNumber, extent.width, extent.height);
+
+        if (createInfo.dumpFormat == VuFrameDumpFormat::Raw) {
+            VuImageWriter::writeRaw(createInfo.dumpDirectory / (name + (isBgra(format) ? "_bgra8.raw" : "_rgba8.raw")), job.pixels);
+            return;
+        }
+
+        if (isBgra(format)) {
+            for (size_t i = 0; i < job.pixels.size(); i += 4U) {
+                std::swap(job.pixels[i], job.pixels[i + 2U]);
+            }
+        }
+        VuImageWriter::writePng(createInfo.dumpDirectory / (name + ".png"), extent.width, extent.height, job.pixels);
+    }
+
+    VkDeviceSize VuFrameReadback::frameSize() const {
+        return static_cast<VkDeviceSize>(extent.width) * extent.height * 4U;
+    }
+
+    bool VuFrameReadback::isBgra(VkFormat format) {
+        return format == VK_FORMAT_B8G8R8A8_UNORM || format == VK_FORMAT_B8G8R8A8_SRGB;
+    }
+}
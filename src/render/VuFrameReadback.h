@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <thread>
+
+#include "Common.h"
+#include "VuBuffer.h"
+#include "VuConfig.h"
+
+namespace Vu {
+
+    enum class VuFrameDumpFormat : uint8 {
+        None,
+        Png,
+        //tightly packed rgba8 rows, the size is in the file name
+        Raw,
+    };
+
+    struct VuReadbackFrame {
+        uint64                 frameNumber;
+        uint32                 width;
+        uint32                 height;
+        VkFormat               format;
+        //tightly packed rows of 4 byte texels in the attachment format, bgra stays bgra
+        std::span<const uint8> pixels;
+    };
+
+    struct VuFrameReadbackCreateInfo {
+        //copy every n-th frame, 1 copies all of them
+        uint32                                      interval      = 1U;
+        VuFrameDumpFormat                           dumpFormat    = VuFrameDumpFormat::None;
+        std::filesystem::path                       dumpDirectory = "captures";
+        //dumps waiting for the writer thread, frames beyond this are not dumped instead of stalling the frame loop
+        uint32                                      maxQueuedDumps = 16U;
+        //called on the render thread, pixels are only valid during the call
+        std::function<void(const VuReadbackFrame&)> callback;
+    };
+
+    struct VuFrameReadbackStats {
+        uint64 copiedFrames;
+        uint64 deliveredFrames;
+        uint64 writtenDumps;
+        uint64 droppedDumps;
+    };
+
+    //copies the final color attachment into one host visible buffer per frame in flight.
+    //a copy is only read after the fence of its frame was waited by the renderer anyway,
+    //so reading back never stalls the gpu or adds a wait to the frame loop
+    struct VuFrameReadback {
+    public:
+        void init(const VuFrameReadbackCreateInfo& info, VkExtent2D extent, VkFormat format);
+
+        void uninit();
+
+        bool wantsFrame(uint64 frameNumber) const;
+
+        VkBuffer getBuffer(uint32 frameSlot) const;
+
+        //image has to be in transfer src layout, the render graph takes care of that
+        void recordCopy(VkCommandBuffer commandBuffer, VkImage image, uint32 frameSlot, uint64 frameNumber);
+
+        //call once the fence of frameSlot is signaled, hands the finished copy to the callback and the dump writer
+        void collect(uint32 frameSlot);
+
+        VuFrameReadbackStats getStats() const;
+
+    private:
+        struct Slot {
+            VuBuffer buffer;
+            bool     pending     = false;
+            uint64   frameNumber = 0U;
+        };
+
+        struct DumpJob {
+            uint64             frameNumber;
+            std::vector<uint8> pixels;
+        };
+
+        VuFrameReadbackCreateInfo                          createInfo{};
+        VkExtent2D                                         extent{};
+        VkFormat                                           format = VK_FORMAT_UNDEFINED;
+        std::array<Slot, config::MAX_FRAMES_IN_FLIGHT>     slots{};
+        VuFrameReadbackStats                               stats{};
+        std::atomic<uint64>                                writtenDumps = 0U;
+
+        std::thread             writer;
+        std::mutex              dumpMutex;
+        std::condition_variable dumpSignal;
+        std::deque<DumpJob>     dumps;
+        bool                    stopWriter = false;
+
+        void writerLoop();
+
+        void writeDump(DumpJob& job) const;
+
+        VkDeviceSize frameSize() const;
+
+        static bool isBgra(VkFormat format);
+    };
+}
@@ -0,0 +1,677 @@
+#pragma once
+
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "glm/gtx/matrix_decompose.hpp"
+
+#include "Common.h"
+#include "Components.h"
+#include "Transform.h"
+#include "VuAssetCache.h"
+#include "VuAssetLoader.h"
+#include "VuBuffer.h"
+#include "VuCtx.h"
+#include "VuFile.h"
+#include "VuJobSystem.h"
+#include "VuMesh.h"
+#include "VuMeshOptimizer.h"
+#include "VuRenderer.h"
+#include "VuScene.h"
+#include "VuShader.h"
+#include "VuTangentGenerator.h"
+#include "VuTextureStreamer.h"
+
+namespace Vu {
+
+    //a triangle primitive of a gltf mesh, drawn as a submesh range of the scene's mesh
+    struct VuGltfPrimitive {
+        uint32 firstSubMesh = 0U;
+        uint32 subMeshCount = 0U;
+        //gltf material while parsing, shader material after create. UINT32_MAX when the primitive has none
+        uint32 material = UINT32_MAX;
+    };
+
+    struct VuGltfMesh {
+        uint32 firstPrimitive = 0U;
+        uint32 primitiveCount = 0U;
+    };
+
+    //parents are stored before their children
+    struct VuGltfNode {
+        std::string name;
+        Transform   local{};
+        uint32      parent = UINT32_MAX;
+        uint32      mesh   = UINT32_MAX;
+    };
+
+    //the pbr part of a gltf material the shader understands, images index VuGltfSceneData::images
+    struct VuGltfMaterialDesc {
+        float3 baseColorMul   = {1, 1, 1};
+        uint32 baseColorImage = UINT32_MAX;
+        uint32 normalImage    = UINT32_MAX;
+    };
+
+    //everything of a gltf file that needs no device, see VuGltfImporter::Parse
+    struct VuGltfSceneData {
+        //already in the layout of the gpu buffers
+        VuMeshBytes                        meshBytes{};
+        std::vector<VuSubMesh>             subMeshes;
+        VkIndexType                        indexType = VK_INDEX_TYPE_UINT32;
+        std::vector<VuGltfPrimitive>       primitives;
+        std::vector<VuGltfMesh>            meshes;
+        std::vector<VuGltfNode>            nodes;
+        std::vector<VuGltfMaterialDesc>    materials;
+        //empty for images embedded in a buffer, the streamer only reads files
+        std::vector<std::filesystem::path> images;
+        //primitives sharing their accessors share their geometry
+        uint32                             geometryCount = 0U;
+    };
+
+    //.vumesh layout: VuBakedMeshHeader, the submesh, primitive, mesh, material and node tables, node names and
+    //image paths (relative to the gltf) as length prefixed strings, then at payloadOffset the vertex buffer and
+    //the index buffer exactly as uploaded
+    struct VuBakedMeshHeader {
+        static constexpr uint32 MAGIC             = 0x534D5556U; //"VUMS"
+        static constexpr uint32 VERSION           = 2U;
+        static constexpr uint64 PAYLOAD_ALIGNMENT = 16U;
+
+        uint32 magic   = MAGIC;
+        uint32 version = VERSION;
+        //VuAssetCache key of the sources it was baked from
+        uint64 sourceKey = 0U;
+
+        uint32 indexType      = VK_INDEX_TYPE_UINT32;
+        uint32 vertexCount    = 0U;
+        uint32 indexCount     = 0U;
+        uint32 subMeshCount   = 0U;
+        uint32 primitiveCount = 0U;
+        uint32 meshCount      = 0U;
+        uint32 materialCount  = 0U;
+        uint32 nodeCount      = 0U;
+        uint32 imageCount     = 0U;
+        uint32 geometryCount  = 0U;
+        float3 boundsCenter{0.0F};
+        float  boundsRadius = 0.0F;
+
+        uint64 payloadOffset = 0U;
+        uint64 vertexBytes   = 0U;
+        uint64 indexBytes    = 0U;
+    };
+
+    struct VuGltfImportInfo {
+        //owns the materials. a gltf material only takes a block of the material data pool and draws with the
+        //shader's one pipeline, so any number of them fit the pipelines SC reserves
+        VuShader*          shader          = nullptr;
+        //nullptr leaves every material on the fallback textures
+        VuTextureStreamer* textureStreamer = nullptr;
+        //bindless texture indices for materials without one, UINT32_MAX uses the renderer's debug textures
+        uint32             fallbackBaseColorTexture = UINT32_MAX;
+        uint32             fallbackNormalTexture    = UINT32_MAX;
+        //UINT32_MAX uses the renderer's default sampler
+        uint32             sampler                  = UINT32_MAX;
+    };
+
+    //an imported gltf file. every primitive lives in one vertex and one index buffer, so the whole file is a
+    //single upload and draws without rebinding buffers between its primitives
+    struct VuGltfScene {
+        VuMesh                           mesh{};
+        VuShader*                        shader = nullptr;
+        std::vector<VuGltfPrimitive>     primitives;
+        std::vector<VuGltfMesh>          meshes;
+        std::vector<VuGltfNode>          nodes;
+        //shader material of every gltf material
+        std::vector<uint32>              materials;
+        //owned by the texture streamer
+        std::vector<VuHandle<VuTexture>> textures;
+
+        //an entity per node below parent, returned in node order. a node with a single primitive carries its
+        //MeshRenderer, several primitives get a child entity each. primitives without a material use defaultMaterial
+        std::vector<VuEntity> instantiate(VuScene& scene, uint32 defaultMaterial, VuEntity parent = {}) {
+            std::vector<VuEntity> entities(nodes.size());
+            for (uint32 i = 0U; i < nodes.size(); i++) {
+                const VuGltfNode& node = nodes[i];
+                entities[i] = scene.createEntity(node.local, node.parent == UINT32_MAX ? parent : entities[node.parent]);
+                if (node.mesh == UINT32_MAX) {
+                    continue;
+                }
+
+                const VuGltfMesh& gltfMesh = meshes[node.mesh];
+                for (uint32 p = gltfMesh.firstPrimitive; p < gltfMesh.firstPrimitive + gltfMesh.primitiveCount; p++) {
+                    const VuGltfPrimitive& primitive = primitives[p];
+                    //a count of zero would draw the whole file
+                    if (primitive.subMeshCount == 0U) {
+                        continue;
+                    }
+                    const VuEntity target = gltfMesh.primitiveCount == 1U ? entities[i] : scene.createEntity({}, entities[i]);
+                    scene.add<MeshRenderer>(target, {
+                                                &mesh,
+                                                shader,
+                                                primitive.material == UINT32_MAX ? defaultMaterial : primitive.material,
+                                                primitive.firstSubMesh,
+                                                primitive.subMeshCount
+                                            });
+                }
+            }
+            return entities;
+        }
+
+        void uninit() {
+            mesh.uninit();
+        }
+    };
+
+    //imports a whole gltf file: every scene node, mesh, primitive and material. primitives sharing accessors
+    //are read and optimized once, each unique geometry in its own job. images are registered with the texture
+    //streamer once per format, and pbr materials become blocks of the shader's material pool
+    struct VuGltfImporter {
+
+        static void Import(const std::filesystem::path& path, const VuGltfImportInfo& info, VuGltfScene& dstScene) {
+            VuGltfSceneData data = Parse(path);
+            Create(data, info, dstScene);
+        }
+
+        //reads and optimizes the geometry and collects nodes and materials, touches no device state.
+        //with the asset cache enabled a warm start only reads the bake of the gltf and its buffers, a cold
+        //one imports them and stores the bake
+        static VuGltfSceneData Parse(const std::filesystem::path& path) {
+            if (!VuAssetCache::isEnabled()) {
+                return ParseSource(path);
+            }
+
+            const std::vector<std::filesystem::path> sources = VuAssetLoader::ListSourceFiles(path);
+            const uint64 key = VuAssetCache::keyOf(sources, BakeSettings());
+
+            VuGltfSceneData             data{};
+            const std::filesystem::path cached = VuAssetCache::find(key, ".vumesh");
+            if (!cached.empty() && ReadBaked(cached, path, key, data)) {
+                return data;
+            }
+
+            data = ParseSource(path);
+            VuAssetCache::store(key, ".vumesh", [&](const std::filesystem::path& bakedPath) {
+                WriteBaked(bakedPath, path, key, data);
+            });
+            return data;
+        }
+
+        //everything besides the sources that shapes a bake, changing any of it misses the old entries
+        static std::string BakeSettings() {
+            return std::format("vumesh {} optimizer fifo {} forsyth {} overdraw {} tangents chunk {} block {}",
+                               VuBakedMeshHeader::VERSION,
+                               VuMeshOptimizer::SIMULATED_CACHE_SIZE,
+                               VuMeshOptimizer::FORSYTH_CACHE_SIZE,
+                               VuMeshOptimizer::OVERDRAW_THRESHOLD,
+                               VuTangentGenerator::MIN_TRIANGLES_PER_CHUNK,
+                               VuTangentGenerator::VERTICES_PER_BLOCK);
+        }
+
+        //Parse without the bake
+        static VuGltfSceneData ParseSource(const std::filesystem::path& path) {
+            const VuGltfAsset      gltf  = VuAssetLoader::LoadAsset(path);
+            const fastgltf::Asset& asset = gltf.asset;
+            const std::string      name  = path.filename().string();
+            VuGltfSceneData        data{};
+
+            readGeometry(asset, name, data);
+            readNodes(asset, data);
+            readMaterials(asset, path.parent_path(), name, data);
+
+            std::cout << "[INFO]: " << name << " imported " << data.nodes.size() << " nodes, "
+                    << data.primitives.size() << " primitives of " << data.geometryCount << " geometries, "
+                    << data.meshBytes.vertexCount << " vertices, "
+                    << data.materials.size() << " materials, " << data.images.size() << " images" << std::endl;
+            return data;
+        }
+
+        //false when the bake was written by another version or for other sources. sourcePath is the gltf,
+        //image paths are stored relative to it. the streams stay in the mapped file until Create uploads them
+        static bool ReadBaked(const std::filesystem::path& bakedPath,
+                              const std::filesystem::path& sourcePath,
+                              uint64                       sourceKey,
+                              VuGltfSceneData&             dst) {
+            VU_CPU_ZONE("read baked mesh");
+            auto                         mapping = std::make_shared<const VuMappedFile>(bakedPath, VuFileAccess::Sequential);
+            const std::span<const uint8> file    = mapping->bytes();
+            VuBakedMeshHeader            header{};
+            if (file.size() < sizeof(header)) {
+                return false;
+            }
+            std::memcpy(&header, file.data(), sizeof(header));
+            if (header.magic != VuBakedMeshHeader::MAGIC || header.version != VuBakedMeshHeader::VERSION || header.sourceKey != sourceKey) {
+                return false;
+            }
+
+            dst.indexType     = static_cast<VkIndexType>(header.indexType);
+            dst.geometryCount = header.geometryCount;
+
+            std::vector<VuBakedNode> nodes;
+            uint64                   cursor = sizeof(header);
+            bool                     valid  = readArray(file, cursor, dst.subMeshes, header.subMeshCount)
+                                              && readArray(file, cursor, dst.primitives, header.primitiveCount)
+                                              && readArray(file, cursor, dst.meshes, header.meshCount)
+                                              && readArray(file, cursor, dst.materials, header.materialCount)
+                                              && readArray(file, cursor, nodes, header.nodeCount);
+            dst.nodes.resize(valid ? header.nodeCount : 0U);
+            for (uint32 i = 0U; valid && i < header.nodeCount; i++) {
+                dst.nodes[i].local  = nodes[i].local;
+                dst.nodes[i].parent = nodes[i].parent;
+                dst.nodes[i].mesh   = nodes[i].mesh;
+                valid               = readString(file, cursor, dst.nodes[i].name);
+            }
+            const std::filesystem::path directory = sourcePath.parent_path();
+            dst.images.resize(valid ? header.imageCount : 0U);
+            for (std::filesystem::path& image: dst.images) {
+                std::string relative;
+                valid = valid && readString(file, cursor, relative);
+                image = relative.empty() ? std::filesystem::path() : directory / std::filesystem::path(relative);
+            }
+            valid = valid && header.payloadOffset <= file.size() && header.vertexBytes + header.indexBytes <= file.size() - header.payloadOffset;
+            if (!valid) {
+                std::cout << "[WARNING]: truncated baked mesh, importing the source again: " << bakedPath.string() << std::endl;
+                dst = {};
+                return false;
+            }
+
+            //the streams go in as stored, nothing is converted or copied. their pages are read here, on the
+            //parsing thread, so the upload does not wait on the disk
+            VuMeshBytes& bytes   = dst.meshBytes;
+            bytes.vertexCount    = header.vertexCount;
+            bytes.indexCount     = header.indexCount;
+            bytes.boundsCenter   = header.boundsCenter;
+            bytes.boundsRadius   = header.boundsRadius;
+            bytes.mappedVertices = file.subspan(header.payloadOffset, header.vertexBytes);
+            bytes.mappedIndices  = file.subspan(header.payloadOffset + header.vertexBytes, header.indexBytes);
+            mapping->touch(header.payloadOffset, header.vertexBytes + header.indexBytes);
+            bytes.mapping = std::move(mapping);
+
+            std::cout << "[INFO]: " << sourcePath.filename().string() << " loaded baked, "
+                    << header.vertexCount << " vertices, " << header.nodeCount << " nodes" << std::endl;
+            return true;
+        }
+
+        static void WriteBaked(const std::filesystem::path& bakedPath,
+                               const std::filesystem::path& sourcePath,
+                               uint64                       sourceKey,
+                               const VuGltfSceneData&       data) {
+            VuBakedMeshHeader header{};
+            header.sourceKey      = sourceKey;
+            header.indexType      = static_cast<uint32>(data.indexType);
+            header.vertexCount    = data.meshBytes.vertexCount;
+            header.indexCount     = data.meshBytes.indexCount;
+            header.subMeshCount   = static_cast<uint32>(data.subMeshes.size());
+            header.primitiveCount = static_cast<uint32>(data.primitives.size());
+            header.meshCount      = static_cast<uint32>(data.meshes.size());
+            header.materialCount  = static_cast<uint32>(data.materials.size());
+            header.nodeCount      = static_cast<uint32>(data.nodes.size());
+            header.imageCount     = static_cast<uint32>(data.images.size());
+            header.geometryCount  = data.geometryCount;
+            header.boundsCenter   = data.meshBytes.boundsCenter;
+            header.boundsRadius   = data.meshBytes.boundsRadius;
+            header.vertexBytes    = data.meshBytes.getVertices().size();
+            header.indexBytes     = data.meshBytes.getIndices().size();
+
+            std::ofstream file(bakedPath, std::ios::binary | std::ios::out);
+            if (!file.is_open()) {
+                throw std::runtime_error("Failed to open file: " + bakedPath.string());
+            }
+            //rewritten with the payload offset once the tables are out
+            file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            writeArray(file, data.subMeshes);
+            writeArray(file, data.primitives);
+            writeArray(file, data.meshes);
+            writeArray(file, data.materials);
+
+            std::vector<VuBakedNode> nodes(data.nodes.size());
+            for (uint32 i = 0U; i < data.nodes.size(); i++) {
+                nodes[i] = {data.nodes[i].local, data.nodes[i].parent, data.nodes[i].mesh};
+            }
+            writeArray(file, nodes);
+            for (const VuGltfNode& node: data.nodes) {
+                writeString(file, node.name);
+            }
+            const std::filesystem::path directory = sourcePath.parent_path();
+            for (const std::filesystem::path& image: data.images) {
+                writeString(file, image.empty() ? std::string() : image.lexically_relative(directory).generic_string());
+            }
+
+            //payload aligned for copies straight out of the file
+            const uint64 tablesEnd = static_cast<uint64>(file.tellp());
+            header.payloadOffset   = VuBuffer::alignedSize(tablesEnd, VuBakedMeshHeader::PAYLOAD_ALIGNMENT);
+            const std::vector<char> padding(header.payloadOffset - tablesEnd, 0);
+            file.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+            file.write(reinterpret_cast<const char *>(data.meshBytes.getVertices().data()), static_cast<std::streamsize>(header.vertexBytes));
+            file.write(reinterpret_cast<const char *>(data.meshBytes.getIndices().data()), static_cast<std::streamsize>(header.indexBytes));
+            file.seekp(0);
+            file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            if (!file) {
+                throw std::runtime_error("Failed to write to file: " + bakedPath.string());
+            }
+        }
+
+        //uploads the mesh, registers the images and creates the materials, on the thread owning the device.
+        //moves the scene graph out of data
+        static void Create(VuGltfSceneData& data, const VuGltfImportInfo& info, VuGltfScene& dstScene) {
+            if (info.shader == nullptr) {
+                throw std::runtime_error("gltf import needs a shader for its materials!");
+            }
+            dstScene.mesh.initFromBytes(data.meshBytes, data.subMeshes, data.indexType);
+            dstScene.shader     = info.shader;
+            dstScene.primitives = std::move(data.primitives);
+            dstScene.meshes     = std::move(data.meshes);
+            dstScene.nodes      = std::move(data.nodes);
+
+            const uint32 fallbackBaseColor = info.fallbackBaseColorTexture != UINT32_MAX ? info.fallbackBaseColorTexture : ctx::vuRenderer->debugTexture0.index;
+            const uint32 fallbackNormal    = info.fallbackNormalTexture != UINT32_MAX ? info.fallbackNormalTexture : ctx::vuRenderer->debugTexture1.index;
+            const uint32 sampler           = info.sampler != UINT32_MAX ? info.sampler : ctx::vuRenderer->defaultSampler;
+
+            //an image used as color and as data needs both views
+            //streamed textures are linked, their slot changes whenever a view is swapped
+            std::map<std::pair<uint32, VkFormat>, VuHandle<VuTexture>> registered;
+            auto setTexture = [&](uint32& slotField, uint32 image, VkFormat format, uint32 fallback) {
+                if (image == UINT32_MAX || info.textureStreamer == nullptr || data.images[image].empty()) {
+                    slotField = fallback;
+                    return;
+                }
+                auto [it, inserted] = registered.try_emplace({image, format}, VuHandle<VuTexture>{});
+                if (inserted) {
+                    it->second = info.textureStreamer->registerTexture({data.images[image], format});
+                    dstScene.textures.push_back(it->second);
+                }
+                info.textureStreamer->linkSlot(it->second, slotField);
+            };
+
+            dstScene.materials.clear();
+            for (const VuGltfMaterialDesc& desc: data.materials) {
+                const uint32          material = info.shader->createMaterial();
+                GPU_PBR_MaterialData* matData  = info.shader->materials[material].getPbrMaterialData();
+                setTexture(matData->baseColorTexture, desc.baseColorImage, VK_FORMAT_R8G8B8A8_SRGB, fallbackBaseColor);
+                setTexture(matData->normalTexture, desc.normalImage, VK_FORMAT_R8G8B8A8_UNORM, fallbackNormal);
+                matData->baseColorMul          = desc.baseColorMul;
+                matData->sampler               = sampler;
+                dstScene.materials.push_back(material);
+            }
+            for (VuGltfPrimitive& primitive: dstScene.primitives) {
+                if (primitive.material != UINT32_MAX) {
+                    primitive.material = dstScene.materials[primitive.material];
+                }
+            }
+            data.meshBytes = {};
+        }
+
+    private:
+        static constexpr size_t NO_ACCESSOR = SIZE_MAX;
+
+        using GeometryKey = std::array<size_t, 5>;
+
+        //Transform and indices of a node, its name follows the node table
+        struct VuBakedNode {
+            Transform local{};
+            uint32    parent = UINT32_MAX;
+            uint32    mesh   = UINT32_MAX;
+        };
+
+        template<typename T>
+        static void writeArray(std::ofstream& file, const std::vector<T>& values) {
+            static_assert(std::is_trivially_copyable_v<T>);
+            file.write(reinterpret_cast<const char *>(values.data()), static_cast<std::streamsize>(sizeof(T) * values.size()));
+        }
+
+        //false when the array runs past the end of file
+        template<typename T>
+        static bool readArray(std::span<const uint8> file, uint64& cursor, std::vector<T>& values, uint32 count) {
+            static_assert(std::is_trivially_copyable_v<T>);
+            const uint64 size = sizeof(T) * static_cast<uint64>(count);
+            if (cursor > file.size() || size > file.size() - cursor) {
+                return false;
+            }
+            values.resize(count);
+            std::memcpy(values.data(), file.data() + cursor, size);
+            cursor += size;
+            return true;
+        }
+
+        static void writeString(std::ofstream& file, const std::string& value) {
+            const uint32 length = static_cast<uint32>(value.size());
+            file.write(reinterpret_cast<const char *>(&length), sizeof(length));
+            file.write(value.data(), length);
+        }
+
+        static bool readString(std::span<const uint8> file, uint64& cursor, std::string& value) {
+            uint32 length = 0U;
+            if (cursor > file.size() || sizeof(length) > file.size() - cursor) {
+                return false;
+            }
+            std::memcpy(&length, file.data() + cursor, sizeof(length));
+            cursor += sizeof(length);
+            if (length > file.size() - cursor) {
+                return false;
+            }
+            value.assign(reinterpret_cast<const char *>(file.data() + cursor), length);
+            cursor += length;
+            return true;
+        }
+
+        struct Geometry {
+            const fastgltf::Primitive* primitive = nullptr;
+            VuMeshData                 data{};
+            std::vector<VuSubMesh>     subMeshes;
+            VkIndexType                indexType = VK_INDEX_TYPE_UINT32;
+            std::string                error;
+            uint32                     firstSubMesh = 0U;
+        };
+
+        static size_t accessorOf(const fastgltf::Primitive& primitive, std::string_view attribute) {
+            const auto* it = primitive.findAttribute(attribute);
+            return it == primitive.attributes.end() ? NO_ACCESSOR : it->accessorIndex;
+        }
+
+        //the primitives of all meshes, geometry read once per accessor set and concatenated into one stream set
+        static void readGeometry(const fastgltf::Asset& asset, const std::string& name, VuGltfSceneData& data) {
+            std::map<GeometryKey, uint32>          geometryIndices;
+            std::vector<std::unique_ptr<Geometry>> geometries;
+            std::vector<uint32>                    primitiveGeometry;
+
+            for (const fastgltf::Mesh& mesh: asset.meshes) {
+                VuGltfMesh& dstMesh    = data.meshes.emplace_back();
+                dstMesh.firstPrimitive = static_cast<uint32>(data.primitives.size());
+                for (const fastgltf::Primitive& primitive: mesh.primitives) {
+                    if (primitive.type != fastgltf::PrimitiveType::Triangles) {
+                        std::cout << "[WARNING]: " << name << " has a primitive that is not a triangle list, skipping it" << std::endl;
+                        continue;
+                    }
+                    const GeometryKey key = {
+                        primitive.indicesAccessor.has_value() ? primitive.indicesAccessor.value() : NO_ACCESSOR,
+                        accessorOf(primitive, "POSITION"),
+                        accessorOf(primitive, "NORMAL"),
+                        accessorOf(primitive, "TEXCOORD_0"),
+                        accessorOf(primitive, "TANGENT"),
+                    };
+                    auto [it, inserted] = geometryIndices.try_emplace(key, static_cast<uint32>(geometries.size()));
+                    if (inserted) {
+                        geometries.push_back(std::make_unique<Geometry>());
+                        geometries.back()->primitive = &primitive;
+                    }
+                    primitiveGeometry.push_back(it->second);
+
+                    VuGltfPrimitive& dstPrimitive = data.primitives.emplace_back();
+                    if (primitive.materialIndex.has_value()) {
+                        dstPrimitive.material = static_cast<uint32>(primitive.materialIndex.value());
+                    }
+                }
+                dstMesh.primitiveCount = static_cast<uint32>(data.primitives.size()) - dstMesh.firstPrimitive;
+            }
+            data.geometryCount = static_cast<uint32>(geometries.size());
+
+            //read, tangent generation and optimization dominate an import, geometries are independent
+            VuJobSystem::parallelFor(data.geometryCount, 1U, [&](uint32 first, uint32 end) {
+                for (uint32 g = first; g < end; g++) {
+                    VU_CPU_ZONE("import geometry");
+                    Geometry& geometry = *geometries[g];
+                    try {
+                        VuAssetLoader::ReadPrimitive(asset, *geometry.primitive, name, geometry.data);
+                        VuMeshOptimizer::optimize(geometry.data, geometry.subMeshes, geometry.indexType);
+                    } catch (const std::exception& e) {
+                        geometry.error = e.what();
+                    }
+                }
+            });
+
+            //16 bit indices survive only when every geometry fits them, 32 bit indices are absolute
+            bool allShort = true;
+            for (const std::unique_ptr<Geometry>& geometry: geometries) {
+                if (!geometry->error.empty()) {
+                    throw std::runtime_error(geometry->error);
+                }
+                allShort = allShort && geometry->indexType == VK_INDEX_TYPE_UINT16;
+            }
+            data.indexType = allShort && !geometries.empty() ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+
+            VuMeshData dst{};
+            for (const std::unique_ptr<Geometry>& geometry: geometries) {
+                const VuMeshData& src        = geometry->data;
+                const uint32      vertexBase = dst.vertexCount();
+                const uint32      indexBase  = static_cast<uint32>(dst.indices.size());
+
+                geometry->firstSubMesh = static_cast<uint32>(data.subMeshes.size());
+                for (VuSubMesh subMesh: geometry->subMeshes) {
+                    subMesh.firstIndex += indexBase;
+                    subMesh.vertexOffset = allShort ? subMesh.vertexOffset + static_cast<int32>(vertexBase) : 0;
+                    data.subMeshes.push_back(subMesh);
+                }
+                for (const uint32 index: src.indices) {
+                    dst.indices.push_back(index + vertexBase);
+                }
+                dst.positions.insert(dst.positions.end(), src.positions.begin(), src.positions.end());
+                dst.normals.insert(dst.normals.end(), src.normals.begin(), src.normals.end());
+                dst.tangents.insert(dst.tangents.end(), src.tangents.begin(), src.tangents.end());
+                dst.uvs.insert(dst.uvs.end(), src.uvs.begin(), src.uvs.end());
+            }
+
+            data.meshBytes = VuMesh::toBytes(dst, data.subMeshes, data.indexType);
+
+            for (uint32 p = 0U; p < data.primitives.size(); p++) {
+                const Geometry& geometry        = *geometries[primitiveGeometry[p]];
+                data.primitives[p].firstSubMesh = geometry.firstSubMesh;
+                data.primitives[p].subMeshCount = static_cast<uint32>(geometry.subMeshes.size());
+            }
+        }
+
+        static Transform toTransform(const fastgltf::Node& node) {
+            Transform transform{};
+            if (const auto* trs = std::get_if<fastgltf::TRS>(&node.transform)) {
+                transform.Position = {trs->translation[0], trs->translation[1], trs->translation[2]};
+                transform.Rotation = quat(trs->rotation[3], trs->rotation[0], trs->rotation[1], trs->rotation[2]);
+                transform.Scale    = {trs->scale[0], trs->scale[1], trs->scale[2]};
+                return transform;
+            }
+
+            const auto& matrix = std::get<fastgltf::math::fmat4x4>(node.transform);
+            float4x4    m{};
+            for (uint32 column = 0U; column < 4U; column++) {
+                for (uint32 row = 0U; row < 4U; row++) {
+                    m[column][row] = matrix[column][row];
+                }
+            }
+            float3 skew{};
+            float4 perspective{};
+            glm::decompose(m, transform.Scale, transform.Rotation, transform.Position, skew, perspective);
+            return transform;
+        }
+
+        //the node trees of the default scene, or of every root when the file has no scene, parents first
+        static void readNodes(const fastgltf::Asset& asset, VuGltfSceneData& data) {
+            std::vector<size_t> roots;
+            if (!asset.scenes.empty()) {
+                const size_t scene = asset.defaultScene.has_value() ? asset.defaultScene.value() : 0U;
+                roots.assign(asset.scenes[scene].nodeIndices.begin(), asset.scenes[scene].nodeIndices.end());
+            } else {
+                std::vector<bool> isChild(asset.nodes.size(), false);
+                for (const fastgltf::Node& node: asset.nodes) {
+                    for (const size_t child: node.children) {
+                        isChild[child] = true;
+                    }
+                }
+                for (size_t n = 0U; n < asset.nodes.size(); n++) {
+                    if (!isChild[n]) {
+                        roots.push_back(n);
+                    }
+                }
+            }
+
+            //gltf node and the index of its parent in data.nodes
+            std::vector<std::pair<size_t, uint32>> stack;
+            for (size_t r = roots.size(); r > 0U; r--) {
+                stack.emplace_back(roots[r - 1U], UINT32_MAX);
+            }
+            while (!stack.empty()) {
+                const auto [nodeIndex, parent] = stack.back();
+                stack.pop_back();
+
+                const fastgltf::Node& node  = asset.nodes[nodeIndex];
+                const uint32          index = static_cast<uint32>(data.nodes.size());
+                VuGltfNode&           dst   = data.nodes.emplace_back();
+                dst.name   = std::string(node.name.c_str());
+                dst.local  = toTransform(node);
+                dst.parent = parent;
+                if (node.meshIndex.has_value()) {
+                    dst.mesh = static_cast<uint32>(node.meshIndex.value());
+                }
+                //reversed so the first child is visited first
+                for (size_t c = node.children.size(); c > 0U; c--) {
+                    stack.emplace_back(node.children[c - 1U], index);
+                }
+            }
+        }
+
+        static uint32 imageOf(const fastgltf::Asset& asset, size_t textureIndex) {
+            const fastgltf::Texture& texture = asset.textures[textureIndex];
+            return texture.imageIndex.has_value() ? static_cast<uint32>(texture.imageIndex.value()) : UINT32_MAX;
+        }
+
+        static void readMaterials(const fastgltf::Asset&       asset,
+                                  const std::filesystem::path& directory,
+                                  const std::string&           name,
+                                  VuGltfSceneData&             data) {
+            for (const fastgltf::Image& image: asset.images) {
+                std::filesystem::path& path = data.images.emplace_back();
+                const auto*            uri  = std::get_if<fastgltf::sources::URI>(&image.data);
+                if (uri != nullptr && uri->uri.isLocalPath() && uri->fileByteOffset == 0U) {
+                    path = directory / uri->uri.fspath();
+                } else {
+                    std::cout << "[WARNING]: " << name << " has an embedded image, its materials use the fallback texture" << std::endl;
+                }
+            }
+
+            for (const fastgltf::Material& material: asset.materials) {
+                VuGltfMaterialDesc& desc = data.materials.emplace_back();
+                const auto&         mul  = material.pbrData.baseColorFactor;
+                desc.baseColorMul = {mul[0], mul[1], mul[2]};
+                if (material.pbrData.baseColorTexture.has_value()) {
+                    desc.baseColorImage = imageOf(asset, material.pbrData.baseColorTexture->textureIndex);
+                }
+                if (material.normalTexture.has_value()) {
+                    desc.normalImage = imageOf(asset, material.normalTexture->textureIndex);
+                }
+            }
+        }
+    };
+
+    inline void VuAssetBatch::addScene(const std::filesystem::path& path, const VuGltfImportInfo& info, VuGltfScene& dstScene) {
+        auto parsed = std::make_shared<VuGltfSceneData>();
+        add(path,
+            [path, parsed] { *parsed = VuGltfImporter::Parse(path); },
+            [parsed, info, &dstScene] { VuGltfImporter::Create(*parsed, info, dstScene); });
+    }
+}
@@ -0,0 +1,253 @@
+#include "VuGpuProfiler.h"
+
+#include <algorithm>
+#include <format>
+#include <iostream>
+
+#include "VuCtx.h"
+#include "VuDevice.h"
+
+namespace Vu {
+
+    void VuGpuProfiler::init(const VuGpuProfilerCreateInfo& info) {
+        createInfo            = info;
+        createInfo.windowSize = std::max(info.windowSize, 1U);
+        //begin and end of a scope always land in the same pool
+        createInfo.maxQueriesPerFrame = info.maxQueriesPerFrame & ~1U;
+
+        const VkPhysicalDeviceProperties& properties = ctx::vuDevice->physicalDeviceProperties;
+
+        uint32 familyCount = 0U;
+        vkGetPhysicalDeviceQueueFamilyProperties(ctx::vuDevice->physicalDevice, &familyCount, nullptr);
+        std::vector<VkQueueFamilyProperties> families(familyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(ctx::vuDevice->physicalDevice, &familyCount, families.data());
+        const uint32 validBits = families[ctx::vuDevice->queueFamilyIndices.graphicsFamily.value()].timestampValidBits;
+
+        if (validBits == 0U || properties.limits.timestampPeriod <= 0.0F || createInfo.maxQueriesPerFrame == 0U) {
+            std::cerr << "[WARNING]: gpu timestamps are not supported by the graphics queue, the gpu profiler is disabled" << std::endl;
+            enabled = false;
+            return;
+        }
+
+        timestampPeriod = properties.limits.timestampPeriod;
+        timestampMask   = validBits >= 64U ? UINT64_MAX : (1ULL << validBits) - 1ULL;
+
+        VkQueryPoolCreateInfo poolInfo{};
+        poolInfo.sType      = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        poolInfo.queryType  = VK_QUERY_TYPE_TIMESTAMP;
+        poolInfo.queryCount = createInfo.maxQueriesPerFrame;
+
+        for (FrameQueries& frame: frames) {
+            VkCheck(vkCreateQueryPool(ctx::vuDevice->device, &poolInfo, nullptr, &frame.queryPool));
+            frame.scopes.clear();
+            frame.usedQueries = 0U;
+        }
+        //value and availability word per query
+        results.resize(static_cast<size_t>(createInfo.maxQueriesPerFrame) * 2U);
+        frameCount = 0U;
+        enabled    = true;
+    }
+
+    void VuGpuProfiler::uninit() {
+        for (FrameQueries& frame: frames) {
+            if (frame.queryPool != VK_NULL_HANDLE) {
+                vkDestroyQueryPool(ctx::vuDevice->device, frame.queryPool, nullptr);
+                frame.queryPool = VK_NULL_HANDLE;
+            }
+        }
+        enabled = false;
+    }
+
+    bool VuGpuProfiler::isEnabled() const {
+        return enabled;
+    }
+
+    void VuGpuProfiler::beginFrame(VkCommandBuffer commandBuffer, uint32 frameSlot) {
+        if (!enabled) {
+            return;
+        }
+
+        currentSlot         = frameSlot;
+        FrameQueries& frame = frames[frameSlot];
+        collect(frame);
+
+        openScopes.clear();
+        vkCmdResetQueryPool(commandBuffer, frame.queryPool, 0U, createInfo.maxQueriesPerFrame);
+
+        frameCount++;
+        if (createInfo.dumpInterval != 0U && frameCount % createInfo.dumpInterval == 0U) {
+            dump();
+        }
+    }
+
+    void VuGpuProfiler::beginScope(VkCommandBuffer commandBuffer, const std::string& name) {
+        if (!enabled) {
+            return;
+        }
+
+        FrameQueries& frame = frames[currentSlot];
+        if (frame.usedQueries + 2U > createInfo.maxQueriesPerFrame) {
+            openScopes.push_back(UINT32_MAX);
+            return;
+        }
+
+        const RecordedScope recorded{getOrAddScope(name), frame.usedQueries, frame.usedQueries + 1U};
+        frame.usedQueries += 2U;
+        openScopes.push_back(static_cast<uint32>(frame.scopes.size()));
+        frame.scopes.push_back(recorded);
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, frame.queryPool, recorded.beginQuery);
+    }
+
+    void VuGpuProfiler::endScope(VkCommandBuffer commandBuffer) {
+        if (!enabled || openScopes.empty()) {
+            return;
+        }
+
+        const uint32 open = openScopes.back();
+        openScopes.pop_back();
+        if (open == UINT32_MAX) {
+            return;
+        }
+
+        FrameQueries& frame = frames[currentSlot];
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frame.queryPool, frame.scopes[open].endQuery);
+    }
+
+    void VuGpuProfiler::collect(FrameQueries& frame) {
+        if (frame.usedQueries == 0U) {
+            return;
+        }
+
+        //no wait flag, the frame's fence was signaled already. a scope left open has no end value and is skipped
+        const VkResult result = vkGetQueryPoolResults(ctx::vuDevice->device,
+                                                      frame.queryPool,
+                                                      0U,
+                                                      frame.usedQueries,
+                                                      frame.usedQueries * 2U * sizeof(uint64),
+                                                      results.data(),
+                                                      2U * sizeof(uint64),
+                                                      VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+        if (result != VK_SUCCESS && result != VK_NOT_READY) {
+            VkCheck(result);
+        }
+
+        for (const RecordedScope& recorded: frame.scopes) {
+            const uint64 beginValue     = results[recorded.beginQuery * 2U];
+            const uint64 beginAvailable = results[recorded.beginQuery * 2U + 1U];
+            const uint64 endValue       = results[recorded.endQuery * 2U];
+            const uint64 endAvailable   = results[recorded.endQuery * 2U + 1U];
+            if (beginAvailable == 0U || endAvailable == 0U) {
+                continue;
+            }
+
+            const uint64 ticks = (endValue - beginValue) & timestampMask;
+            const double ms    = static_cast<double>(ticks) * timestampPeriod / 1000000.0;
+
+            Scope& scope = scopes[recorded.scope];
+            if (scope.samples.size() < createInfo.windowSize) {
+                scope.samples.push_back(ms);
+            } else {
+                scope.samples[scope.head] = ms;
+                scope.head                = (scope.head + 1U) % createInfo.windowSize;
+            }
+            scope.last = ms;
+        }
+
+        frame.scopes.clear();
+        frame.usedQueries = 0U;
+    }
+
+    void VuGpuProfiler::collectPending() {
+        if (!enabled) {
+            return;
+        }
+        //oldest frame first so the windows stay in submission order
+        for (uint32 i = 1; i <= config::MAX_FRAMES_IN_FLIGHT; i++) {
+            collect(frames[(currentSlot + i) % config::MAX_FRAMES_IN_FLIGHT]);
+        }
+    }
+
+    void VuGpuProfiler::resetStats() {
+        for (Scope& scope: scopes) {
+            scope.samples.clear();
+            scope.head = 0U;
+            scope.last = 0.0;
+        }
+    }
+
+    uint32 VuGpuProfiler::getOrAddScope(const std::string& name) {
+        const auto it = scopeIndices.find(name);
+        if (it != scopeIndices.end()) {
+            return it->second;
+        }
+
+        const uint32 index = static_cast<uint32>(scopes.size());
+        scopes.push_back({.name = name});
+        scopes.back().samples.reserve(createInfo.windowSize);
+        scopeIndices.emplace(name, index);
+        return index;
+    }
+
+    VuGpuScopeStats VuGpuProfiler::computeStats(const Scope& scope) const {
+        VuGpuScopeStats stats{scope.name, scope.last, 0.0, 0.0, 0.0, 0.0, static_cast<uint32>(scope.samples.size())};
+        if (scope.samples.empty()) {
+            return stats;
+        }
+
+        std::vector<double> sorted = scope.samples;
+        std::sort(sorted.begin(), sorted.end());
+
+        double sum = 0.0;
+        for (double sample: sorted) {
+            sum += sample;
+        }
+        //nearest rank
+        const size_t p99Rank = (sorted.size() * 99U + 99U) / 100U;
+
+        stats.minMs = sorted.front();
+        stats.maxMs = sorted.back();
+        stats.avgMs = sum / static_cast<double>(sorted.size());
+        stats.p99Ms = sorted[std::min(p99Rank, sorted.size()) - 1U];
+        return stats;
+    }
+
+    std::vector<VuGpuScopeStats> VuGpuProfiler::getAllStats() const {
+        std::vector<VuGpuScopeStats> result;
+        result.reserve(scopes.size());
+        for (const Scope& scope: scopes) {
+            result.push_back(computeStats(scope));
+        }
+        return result;
+    }
+
+    bool VuGpuProfiler::getStats(const std::string& name, VuGpuScopeStats& outStats) const {
+        const auto it = scopeIndices.find(name);
+        if (it == scopeIndices.end()) {
+            return false;
+        }
+        outStats = computeStats(scopes[it->second]);
+        return true;
+    }
+
+    bool VuGpuProfiler::getSamples(const std::string& name, std::vector<double>& outSamples) const {
+        const auto it = scopeIndices.find(name);
+        if (it == scopeIndices.end()) {
+            return false;
+        }
+        const Scope& scope = scopes[it->second];
+        outSamples.assign(scope.samples.begin() + scope.head, scope.samples.end());
+        outSamples.insert(outSamples.end(), scope.samples.begin(), scope.samples.begin() + scope.head);
+        return true;
+    }
+
+    void VuGpuProfiler::dump() const {
+        std::cout << std::format("[INFO]: gpu timings after {} frames (ms)\n", frameCount);
+        std::cout << std::format("    {:<24} {:>8} {:>8} {:>8} {:>8} {:>8} {:>6}\n", "scope", "last", "min", "avg", "max", "p99", "n");
+        for (const Scope& scope: scopes) {
+            const VuGpuScopeStats s = computeStats(scope);
+            std::cout << std::format("    {:<24} {:>8.3f} {:>8.3f} {:>8.3f} {:>8.3f} {:>8.3f} {:>6}\n",
+                                     s.name, s.lastMs, s.minMs, s.avgMs, s.maxMs, s.p99Ms, s.sampleCount);
+        }
+        std::cout.flush();
+    }
+}
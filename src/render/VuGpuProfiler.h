@@ -0,0 +1,130 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Common.h"
+#include "VuConfig.h"
+
+namespace Vu {
+
+    struct VuGpuProfilerCreateInfo {
+        //timestamps per frame, every scope takes two. vulkan sc caps this with maxTimestampQueriesPerPool
+        uint32 maxQueriesPerFrame = 128U;
+        //samples kept per scope for the rolling statistics
+        uint32 windowSize = 256U;
+        //print every scope to the log every n frames, 0 never prints
+        uint32 dumpInterval = 0U;
+    };
+
+    //rolling statistics of one scope in milliseconds over the last windowSize frames it was recorded in
+    struct VuGpuScopeStats {
+        std::string name;
+        double      lastMs;
+        double      minMs;
+        double      avgMs;
+        double      maxMs;
+        double      p99Ms;
+        uint32      sampleCount;
+    };
+
+    //timestamps around named scopes of a frame's command buffer. every frame in flight owns a query pool
+    //which is read back once the renderer waited for that frame's fence anyway, so results are
+    //MAX_FRAMES_IN_FLIGHT frames old and reading them never waits on the gpu
+    struct VuGpuProfiler {
+    public:
+        void init(const VuGpuProfilerCreateInfo& info);
+
+        void uninit();
+
+        //after the fence of frameSlot was waited and before any scope, outside of a render pass:
+        //collects the results of the slot's previous frame and resets its queries
+        void beginFrame(VkCommandBuffer commandBuffer, uint32 frameSlot);
+
+        //scopes nest, a scope that does not fit into the pool any more is skipped for this frame
+        void beginScope(VkCommandBuffer commandBuffer, const std::string& name);
+
+        void endScope(VkCommandBuffer commandBuffer);
+
+        bool isEnabled() const;
+
+        std::vector<VuGpuScopeStats> getAllStats() const;
+
+        bool getStats(const std::string& name, VuGpuScopeStats& outStats) const;
+
+        //the raw window of a scope in milliseconds, oldest first
+        bool getSamples(const std::string& name, std::vector<double>& outSamples) const;
+
+        //forgets every sample, scopes keep their names
+        void resetStats();
+
+        //reads every frame still holding results, only after the device went idle
+        void collectPending();
+
+        void dump() const;
+
+    private:
+        struct Scope {
+            std::string         name;
+            //milliseconds, a ring of windowSize once full
+            std::vector<double> samples;
+            uint32              head = 0U;
+            double              last = 0.0;
+        };
+
+        struct RecordedScope {
+            uint32 scope;
+            uint32 beginQuery;
+            uint32 endQuery;
+        };
+
+        struct FrameQueries {
+            VkQueryPool                queryPool = VK_NULL_HANDLE;
+            std::vector<RecordedScope> scopes;
+            uint32                     usedQueries = 0U;
+        };
+
+        VuGpuProfilerCreateInfo createInfo{};
+        bool                    enabled = false;
+        //nanoseconds per tick
+        double                  timestampPeriod = 1.0;
+        uint64                  timestampMask   = UINT64_MAX;
+        uint64                  frameCount      = 0U;
+
+        std::array<FrameQueries, config::MAX_FRAMES_IN_FLIGHT> frames{};
+        uint32                                                 currentSlot = 0U;
+        //indices into frames[currentSlot].scopes of the scopes still open
+        std::vector<uint32>                                    openScopes;
+
+        std::vector<Scope>                      scopes;
+        std::unordered_map<std::string, uint32> scopeIndices;
+        std::vector<uint64>                     results;
+
+        void collect(FrameQueries& frame);
+
+        uint32 getOrAddScope(const std::string& name);
+
+        VuGpuScopeStats computeStats(const Scope& scope) const;
+    };
+
+    //records a scope for the lifetime of the object
+    struct VuGpuScope {
+        VuGpuScope(VuGpuProfiler& profiler, VkCommandBuffer commandBuffer, const std::string& name)
+            : profiler(profiler), commandBuffer(commandBuffer) {
+            profiler.beginScope(commandBuffer, name);
+        }
+
+        ~VuGpuScope() {
+            profiler.endScope(commandBuffer);
+        }
+
+        VuGpuScope(const VuGpuScope&)            = delete;
+        VuGpuScope& operator=(const VuGpuScope&) = delete;
+
+    private:
+        VuGpuProfiler&  profiler;
+        VkCommandBuffer commandBuffer;
+    };
+}
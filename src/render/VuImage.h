@@ -1,8 +1,11 @@
 #pragma once
 
+#include <cmath>
+
 #include "Common.h"
 #include "VuCtx.h"
 #include "VuDevice.h"
+#include "VuImageDecoder.h"
 #include "VuUtils.h"
 
 namespace Vu {
@@ -16,14 +19,15 @@ namespace Vu {
                                 VkImageUsageFlags usage,
                                 VkMemoryPropertyFlags properties,
                                 VkImage& image,
-                                VkDeviceMemory& imageMemory) {
+                                VkDeviceMemory& imageMemory,
+                                uint32 mipLevels = 1U) {
             VkImageCreateInfo imageInfo{};
             imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
             imageInfo.imageType = VK_IMAGE_TYPE_2D;
             imageInfo.extent.width = width;
             imageInfo.extent.height = height;
             imageInfo.extent.depth = 1;
-            imageInfo.mipLevels = 1;
+            imageInfo.mipLevels = mipLevels;
             imageInfo.arrayLayers = 1;
             imageInfo.format = format;
             imageInfo.tiling = tiling;
@@ -70,7 +74,8 @@ namespace Vu {
         }
 
 
-        static void createImageView(VkFormat format, VkImage image,VkImageAspectFlags aspectFlags, VkImageView& outImageView) {
+        static void createImageView(VkFormat format, VkImage image,VkImageAspectFlags aspectFlags, VkImageView& outImageView,
+                                    uint32 mipLevels = 1U) {
             VkImageViewCreateInfo viewInfo{};
             viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
             viewInfo.image = image;
@@ -78,14 +83,14 @@ namespace Vu {
             viewInfo.format = format;
             viewInfo.subresourceRange.aspectMask = aspectFlags;
             viewInfo.subresourceRange.baseMipLevel = 0;
-            viewInfo.subresourceRange.levelCount = 1;
+            viewInfo.subresourceRange.levelCount = mipLevels;
             viewInfo.subresourceRange.baseArrayLayer = 0;
             viewInfo.subresourceRange.layerCount = 1;
 
             VkCheck(vkCreateImageView(ctx::vuDevice->device, &viewInfo, nullptr, &outImageView));
         }
 
-        static void transitionImageLayout(VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout) {
+        static void transitionImageLayout(VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout, uint32 mipLevels = 1U) {
 
             VkCommandBuffer commandBuffer = ctx::vuDevice->BeginSingleTimeCommands();
             VkImageMemoryBarrier barrier{};
@@ -97,7 +102,7 @@ namespace Vu {
             barrier.image = image;
             barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
             barrier.subresourceRange.baseMipLevel = 0;
-            barrier.subresourceRange.levelCount = 1;
+            barrier.subresourceRange.levelCount = mipLevels;
             barrier.subresourceRange.baseArrayLayer = 0;
             barrier.subresourceRange.layerCount = 1;
 
@@ -132,12 +137,116 @@ namespace Vu {
             ctx::vuDevice->EndSingleTimeCommands(commandBuffer);
         }
 
-        static void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height) {
+        static uint32 calculateMipLevels(uint32 width, uint32 height) {
+            return static_cast<uint32>(std::floor(std::log2(std::max(width, height)))) + 1U;
+        }
+
+        //rgba8 row pitch of a staging upload, rounded up to the row pitch the device copies fastest
+        static VkDeviceSize stagingRowPitch(uint32 width) {
+            const VkDeviceSize alignment = ctx::vuDevice->physicalDeviceProperties.limits.optimalBufferCopyRowPitchAlignment;
+            return VuImageDecoder::rowPitchOf(width, alignment);
+        }
+
+        static bool supportsLinearBlit(VkFormat format) {
+            VkFormatProperties formatProperties;
+            vkGetPhysicalDeviceFormatProperties(ctx::vuDevice->physicalDevice, format, &formatProperties);
+            const VkFormatFeatureFlags required = VK_FORMAT_FEATURE_BLIT_SRC_BIT
+                                                  | VK_FORMAT_FEATURE_BLIT_DST_BIT
+                                                  | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+            return (formatProperties.optimalTilingFeatures & required) == required;
+        }
+
+        //expects every level in TRANSFER_DST_OPTIMAL with level 0 filled,
+        //blits each level from the previous one and leaves the whole chain in SHADER_READ_ONLY_OPTIMAL
+        static void generateMipmaps(VkImage image, uint32 width, uint32 height, uint32 mipLevels) {
+            VkCommandBuffer commandBuffer = ctx::vuDevice->BeginSingleTimeCommands();
+
+            VkImageMemoryBarrier barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            barrier.image = image;
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            barrier.subresourceRange.baseArrayLayer = 0;
+            barrier.subresourceRange.layerCount = 1;
+            barrier.subresourceRange.levelCount = 1;
+
+            auto mipWidth  = static_cast<int32>(width);
+            auto mipHeight = static_cast<int32>(height);
+
+            for (uint32 i = 1; i < mipLevels; i++) {
+                barrier.subresourceRange.baseMipLevel = i - 1;
+                barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+                barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+                barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+                barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+                vkCmdPipelineBarrier(commandBuffer,
+                                     VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                                     0, nullptr,
+                                     0, nullptr,
+                                     1, &barrier);
+
+                const int32 nextWidth  = mipWidth > 1 ? mipWidth / 2 : 1;
+                const int32 nextHeight = mipHeight > 1 ? mipHeight / 2 : 1;
+
+                VkImageBlit blit{};
+                blit.srcOffsets[0] = {0, 0, 0};
+                blit.srcOffsets[1] = {mipWidth, mipHeight, 1};
+                blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+                blit.srcSubresource.mipLevel = i - 1;
+                blit.srcSubresource.baseArrayLayer = 0;
+                blit.srcSubresource.layerCount = 1;
+                blit.dstOffsets[0] = {0, 0, 0};
+                blit.dstOffsets[1] = {nextWidth, nextHeight, 1};
+                blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+                blit.dstSubresource.mipLevel = i;
+                blit.dstSubresource.baseArrayLayer = 0;
+                blit.dstSubresource.layerCount = 1;
+
+                vkCmdBlitImage(commandBuffer,
+                               image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                               image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                               1, &blit,
+                               VK_FILTER_LINEAR);
+
+                barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+                barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+                barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+                barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+                vkCmdPipelineBarrier(commandBuffer,
+                                     VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+                                     0, nullptr,
+                                     0, nullptr,
+                                     1, &barrier);
+
+                mipWidth  = nextWidth;
+                mipHeight = nextHeight;
+            }
+
+            barrier.subresourceRange.baseMipLevel = mipLevels - 1;
+            barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+            vkCmdPipelineBarrier(commandBuffer,
+                                 VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+                                 0, nullptr,
+                                 0, nullptr,
+                                 1, &barrier);
+
+            ctx::vuDevice->EndSingleTimeCommands(commandBuffer);
+        }
+
+        //rowLength in texels, 0 for tightly packed rows
+        static void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32 rowLength = 0U) {
             VkCommandBuffer commandBuffer = ctx::vuDevice->BeginSingleTimeCommands();
 
             VkBufferImageCopy region{};
             region.bufferOffset = 0;
-            region.bufferRowLength = 0;
+            region.bufferRowLength = rowLength;
             region.bufferImageHeight = 0;
             region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
             region.imageSubresource.mipLevel = 0;
@@ -153,5 +262,17 @@ namespace Vu {
             vkCmdCopyBufferToImage(commandBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
             ctx::vuDevice->EndSingleTimeCommands(commandBuffer);
         }
+
+        //uploads several subresources (e.g. a prebaked mip chain) in a single copy command
+        static void copyBufferToImage(VkBuffer buffer, VkImage image, std::span<const VkBufferImageCopy> regions) {
+            VkCommandBuffer commandBuffer = ctx::vuDevice->BeginSingleTimeCommands();
+            vkCmdCopyBufferToImage(commandBuffer,
+                                   buffer,
+                                   image,
+                                   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                   static_cast<uint32>(regions.size()),
+                                   regions.data());
+            ctx::vuDevice->EndSingleTimeCommands(commandBuffer);
+        }
     };
 }
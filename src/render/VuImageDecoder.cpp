@@ -0,0 +1,165 @@
+#include "VuImageDecoder.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace Vu {
+    namespace {
+        //the destination of the decode running on this thread. stb asks for the final image with one allocation of
+        //its size, jpeg with one byte more, that one is served from here instead of the heap.
+        //the match is on size alone. jpeg's other buffers never hit 4 * w * h + 1: component planes are 15 mod 64
+        //bytes and a line buffer is w + 3. png only matches exactly, a scratch buffer of the same size (zlib output
+        //of a 1 pixel wide image, the first idat chunk) may still take the target, it is freed or grown onto the
+        //heap before the result is allocated, which then lands on the heap and is copied. png decodes in place
+        //only into readable memory, so that costs the copy and nothing else
+        struct DecodeTarget {
+            uint8* data      = nullptr;
+            size_t size      = 0U;
+            size_t capacity  = 0U;
+            bool   jpegSlack = false;
+            bool   inUse     = false;
+        };
+
+        thread_local DecodeTarget target;
+
+        void* allocate(size_t size) {
+            const bool imageSized = size == target.size || (target.jpegSlack && size == target.size + 1U);
+            if (target.data != nullptr && !target.inUse && imageSized && size <= target.capacity) {
+                target.inUse = true;
+                return target.data;
+            }
+            return std::malloc(size);
+        }
+
+        void* reallocate(void* pointer, size_t size) {
+            if (pointer != nullptr && pointer == target.data) {
+                //grown out of the destination, continues on the heap
+                void* moved = std::malloc(size);
+                if (moved != nullptr) {
+                    std::memcpy(moved, pointer, std::min(size, target.capacity));
+                }
+                target.inUse = false;
+                return moved;
+            }
+            return std::realloc(pointer, size);
+        }
+
+        void release(void* pointer) {
+            if (pointer != nullptr && pointer == target.data) {
+                target.inUse = false;
+                return;
+            }
+            std::free(pointer);
+        }
+    }
+}
+
+#define STBI_MALLOC(size)           Vu::allocate(size)
+#define STBI_REALLOC(pointer, size) Vu::reallocate(pointer, size)
+#define STBI_FREE(pointer)          Vu::release(pointer)
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+namespace Vu {
+    namespace {
+        bool isJpeg(std::span<const uint8> encoded) {
+            return encoded.size() >= 3U && encoded[0] == 0xFFU && encoded[1] == 0xD8U && encoded[2] == 0xFFU;
+        }
+
+        //clears the target however the decode ends
+        struct TargetScope {
+            TargetScope(uint8* data, size_t size, size_t capacity, bool jpegSlack) {
+                target = {data, size, capacity, jpegSlack, false};
+            }
+
+            ~TargetScope() {
+                target = {};
+            }
+
+            TargetScope(const TargetScope&)            = delete;
+            TargetScope& operator=(const TargetScope&) = delete;
+        };
+    }
+
+    bool VuImageDecoder::readInfo(std::span<const uint8> encoded, VuImageInfo& info) {
+        int width;
+        int height;
+        int channels;
+        if (stbi_info_from_memory(encoded.data(), static_cast<int>(encoded.size()), &width, &height, &channels) == 0) {
+            return false;
+        }
+        info.width    = static_cast<uint32>(width);
+        info.height   = static_cast<uint32>(height);
+        info.channels = static_cast<uint32>(channels);
+        return true;
+    }
+
+    bool VuImageDecoder::decodeRGBA8(std::span<const uint8> encoded, const VuImageInfo& info, const VuImageDestination& dst) {
+        if (info.width == 0U || info.height == 0U) {
+            throw std::runtime_error("failed to decode image: empty image");
+        }
+        const uint64 tightPitch = static_cast<uint64>(info.width) * 4U;
+        const uint64 rowPitch   = dst.rowPitch != 0U ? dst.rowPitch : tightPitch;
+        //the slack byte of byteSizeOf is optional
+        if (rowPitch < tightPitch || dst.bytes.size() < byteSizeOf(info, rowPitch) - 1U) {
+            throw std::runtime_error("image destination too small for " + std::to_string(info.width) + "x" + std::to_string(info.height));
+        }
+
+        //stb writes tight rows, padding them afterwards reads them back, which write combined memory must not see
+        const bool jpeg      = isJpeg(encoded);
+        const bool inPlace   = dst.readable || (rowPitch == tightPitch && jpeg);
+        const auto imageSize = static_cast<size_t>(tightPitch * info.height);
+
+        stbi_uc* pixels;
+        int      width;
+        int      height;
+        int      channels;
+        {
+            TargetScope scope(inPlace ? dst.bytes.data() : nullptr, imageSize, dst.bytes.size(), jpeg);
+            pixels = stbi_load_from_memory(encoded.data(), static_cast<int>(encoded.size()), &width, &height, &channels, STBI_rgb_alpha);
+        }
+        if (pixels == nullptr) {
+            throw std::runtime_error(std::string("failed to decode image: ") + stbi_failure_reason());
+        }
+        if (static_cast<uint32>(width) != info.width || static_cast<uint32>(height) != info.height) {
+            //the target is out of scope by now, dst itself must not reach free
+            if (pixels != dst.bytes.data()) {
+                stbi_image_free(pixels);
+            }
+            throw std::runtime_error("decoded image size does not match its header!");
+        }
+        if (pixels == dst.bytes.data()) {
+            //back to front, every row moves up and never over a row that still has to move
+            for (uint32 y = info.height - 1U; y > 0U && rowPitch != tightPitch; y--) {
+                std::memmove(dst.bytes.data() + y * rowPitch, dst.bytes.data() + y * tightPitch, static_cast<size_t>(tightPitch));
+            }
+            return true;
+        }
+
+        if (rowPitch == tightPitch) {
+            std::memcpy(dst.bytes.data(), pixels, imageSize);
+        } else {
+            for (uint32 y = 0U; y < info.height; y++) {
+                std::memcpy(dst.bytes.data() + y * rowPitch, pixels + y * tightPitch, static_cast<size_t>(tightPitch));
+            }
+        }
+        stbi_image_free(pixels);
+        return false;
+    }
+
+    uint64 VuImageDecoder::rowPitchOf(uint32 width, uint64 alignment) {
+        const uint64 rowAlignment = std::max<uint64>(alignment, 4U);
+        return (static_cast<uint64>(width) * 4U + rowAlignment - 1U) & ~(rowAlignment - 1U);
+    }
+
+    uint64 VuImageDecoder::byteSizeOf(const VuImageInfo& info, uint64 rowPitch) {
+        if (info.height == 0U) {
+            return 0U;
+        }
+        //the last row needs no padding, the byte of slack lets jpeg decode in place
+        return rowPitch * (info.height - 1U) + static_cast<uint64>(info.width) * 4U + 1U;
+    }
+}
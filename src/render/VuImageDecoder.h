@@ -0,0 +1,43 @@
+#pragma once
+
+#include <span>
+
+#include "Common.h"
+
+namespace Vu {
+
+    struct VuImageInfo {
+        uint32 width    = 0U;
+        uint32 height   = 0U;
+        uint32 channels = 0U;
+    };
+
+    //where a decode writes its rgba8 pixels
+    struct VuImageDestination {
+        std::span<uint8> bytes;
+        //bytes from one row start to the next, 0 for tightly packed rows
+        uint64 rowPitch = 0U;
+        //false for write combined memory, e.g. a device local staging buffer that is not HOST_CACHED. only decoders
+        //that never read back their output (jpeg) write into it directly, png unfiltering reads the previous row.
+        //padded rows are then copied from the heap as well
+        bool readable = true;
+    };
+
+    //stb_image decoding into caller memory. stb allocates its result itself, the allocator hooks of the decoder's
+    //translation unit hand it the destination for the allocation of the final rgba8 image, so the pixels are
+    //written in place. when stb ends up with another buffer after all (format conversions, padded rows), the rows
+    //are copied over once
+    struct VuImageDecoder {
+        //from the header only, false when the format is not recognized
+        static bool readInfo(std::span<const uint8> encoded, VuImageInfo& info);
+
+        //throws when the image can not be decoded or dst is too small. returns true when no copy was needed
+        static bool decodeRGBA8(std::span<const uint8> encoded, const VuImageInfo& info, const VuImageDestination& dst);
+
+        //rgba8 rows rounded up to alignment, a power of two. for vkCmdCopyBufferToImage bufferRowLength is pitch / 4
+        static uint64 rowPitchOf(uint32 width, uint64 alignment);
+
+        //bytes dst should have, a byte more than the pixels. a smaller dst still works but copies more often
+        static uint64 byteSizeOf(const VuImageInfo& info, uint64 rowPitch);
+    };
+}
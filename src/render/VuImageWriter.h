@@ -0,0 +1,121 @@
+#pragma once
+
+#include <array>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "Common.h"
+
+namespace Vu {
+
+    //minimal writers for captured frames, pixels are tightly packed 8 bit rgba rows
+    struct VuImageWriter {
+
+        //png with stored (uncompressed) deflate blocks, large but exact and fast to write
+        static void writePng(const std::filesystem::path& path, uint32 width, uint32 height, std::span<const uint8> rgba) {
+            const size_t rowSize = static_cast<size_t>(width) * 4U;
+            if (rgba.size() < rowSize * height) {
+                throw std::runtime_error("png writer: pixel data is smaller than the image!");
+            }
+
+            //every scanline starts with filter type 0
+            std::vector<uint8> scanlines;
+            scanlines.reserve((rowSize + 1U) * height);
+            for (uint32 y = 0; y < height; y++) {
+                scanlines.push_back(0U);
+                scanlines.insert(scanlines.end(), rgba.begin() + y * rowSize, rgba.begin() + (y + 1U) * rowSize);
+            }
+
+            std::vector<uint8> zlib{0x78U, 0x01U};
+            constexpr size_t   MAX_STORED_BLOCK = 65535U;
+            for (size_t offset = 0;; offset += MAX_STORED_BLOCK) {
+                const size_t length = std::min(MAX_STORED_BLOCK, scanlines.size() - offset);
+                const bool   last   = offset + length == scanlines.size();
+                zlib.push_back(last ? 1U : 0U);
+                zlib.push_back(static_cast<uint8>(length));
+                zlib.push_back(static_cast<uint8>(length >> 8U));
+                zlib.push_back(static_cast<uint8>(~length));
+                zlib.push_back(static_cast<uint8>(~length >> 8U));
+                zlib.insert(zlib.end(), scanlines.begin() + offset, scanlines.begin() + offset + length);
+                if (last) {
+                    break;
+                }
+            }
+            appendBigEndian(zlib, adler32(scanlines));
+
+            std::vector<uint8> header;
+            appendBigEndian(header, width);
+            appendBigEndian(header, height);
+            //8 bit, rgba, deflate, no filter method extensions, not interlaced
+            header.insert(header.end(), {8U, 6U, 0U, 0U, 0U});
+
+            std::vector<uint8> png{0x89U, 'P', 'N', 'G', '\r', '\n', 0x1AU, '\n'};
+            appendChunk(png, "IHDR", header);
+            appendChunk(png, "IDAT", zlib);
+            appendChunk(png, "IEND", {});
+            writeFile(path, png);
+        }
+
+        static void writeRaw(const std::filesystem::path& path, std::span<const uint8> pixels) {
+            writeFile(path, pixels);
+        }
+
+    private:
+        static void writeFile(const std::filesystem::path& path, std::span<const uint8> data) {
+            std::ofstream file(path, std::ios::binary);
+            if (!file.is_open()) {
+                throw std::runtime_error("failed to open file: " + path.string());
+            }
+            file.write(reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(data.size()));
+        }
+
+        static void appendBigEndian(std::vector<uint8>& out, uint32 value) {
+            out.push_back(static_cast<uint8>(value >> 24U));
+            out.push_back(static_cast<uint8>(value >> 16U));
+            out.push_back(static_cast<uint8>(value >> 8U));
+            out.push_back(static_cast<uint8>(value));
+        }
+
+        static void appendChunk(std::vector<uint8>& out, const char (&type)[5], std::span<const uint8> data) {
+            appendBigEndian(out, static_cast<uint32>(data.size()));
+            const size_t typeStart = out.size();
+            out.insert(out.end(), type, type + 4);
+            out.insert(out.end(), data.begin(), data.end());
+            appendBigEndian(out, crc32(std::span(out).subspan(typeStart)));
+        }
+
+        static uint32 crc32(std::span<const uint8> data) {
+            static const std::array<uint32, 256> table = [] {
+                std::array<uint32, 256> result{};
+                for (uint32 n = 0; n < 256U; n++) {
+                    uint32 c = n;
+                    for (uint32 k = 0; k < 8U; k++) {
+                        c = (c & 1U) != 0U ? 0xEDB88320U ^ (c >> 1U) : c >> 1U;
+                    }
+                    result[n] = c;
+                }
+                return result;
+            }();
+
+            uint32 crc = 0xFFFFFFFFU;
+            for (uint8 byte: data) {
+                crc = table[(crc ^ byte) & 0xFFU] ^ (crc >> 8U);
+            }
+            return crc ^ 0xFFFFFFFFU;
+        }
+
+        static uint32 adler32(std::span<const uint8> data) {
+            constexpr uint32 MOD = 65521U;
+            uint32           a   = 1U;
+            uint32           b   = 0U;
+            for (uint8 byte: data) {
+                a = (a + byte) % MOD;
+                b = (b + a) % MOD;
+            }
+            return (b << 16U) | a;
+        }
+    };
+}
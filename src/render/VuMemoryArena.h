@@ -0,0 +1,92 @@
+#pragma once
+
+#include "Common.h"
+#include "VuCtx.h"
+#include "VuDevice.h"
+#include "VuUtils.h"
+
+namespace Vu {
+
+    struct VuMemoryRange {
+        VkDeviceSize offset = 0U;
+        VkDeviceSize size   = 0U;
+    };
+
+    //one VkDeviceMemory sub allocated with a first fit free list.
+    //vulkan sc can not free device memory, so anything that comes and goes at runtime has to live in a fixed block like this
+    struct VuMemoryArena {
+        VkDeviceMemory memory          = VK_NULL_HANDLE;
+        VkDeviceSize   capacity        = 0U;
+        VkDeviceSize   usedSize        = 0U;
+        uint32         memoryTypeIndex = 0U;
+
+        void init(VkDeviceSize size, uint32 memoryTypeBits, VkMemoryPropertyFlags properties) {
+            capacity        = size;
+            memoryTypeIndex = findMemoryType(ctx::vuDevice->physicalDevice, memoryTypeBits, properties);
+
+            VkMemoryAllocateInfo allocInfo{};
+            allocInfo.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+            allocInfo.allocationSize  = capacity;
+            allocInfo.memoryTypeIndex = memoryTypeIndex;
+            VkCheck(vkAllocateMemory(ctx::vuDevice->device, &allocInfo, nullptr, &memory));
+
+            freeRanges.clear();
+            freeRanges.push_back({0U, capacity});
+            usedSize = 0U;
+        }
+
+        bool isCompatible(const VkMemoryRequirements& requirements) const {
+            return (requirements.memoryTypeBits & (1U << memoryTypeIndex)) != 0U;
+        }
+
+        //offset to bind the resource at, allocations keep their alignment padding at the front
+        static VkDeviceSize alignedOffset(const VuMemoryRange& range, VkDeviceSize alignment) {
+            return (range.offset + alignment - 1U) / alignment * alignment;
+        }
+
+        bool allocate(const VkMemoryRequirements& requirements, VuMemoryRange& outRange) {
+            for (auto it = freeRanges.begin(); it != freeRanges.end(); ++it) {
+                const VkDeviceSize padding = alignedOffset(*it, requirements.alignment) - it->offset;
+                if (padding + requirements.size > it->size) {
+                    continue;
+                }
+
+                //the alignment padding stays with the allocation so free() can give back the whole range
+                outRange = {it->offset, padding + requirements.size};
+                it->offset += outRange.size;
+                it->size -= outRange.size;
+                if (it->size == 0U) {
+                    freeRanges.erase(it);
+                }
+                usedSize += outRange.size;
+                return true;
+            }
+            return false;
+        }
+
+        void free(const VuMemoryRange& range) {
+            usedSize -= range.size;
+
+            auto it = std::lower_bound(freeRanges.begin(), freeRanges.end(), range.offset, [](const VuMemoryRange& r, VkDeviceSize offset) {
+                return r.offset < offset;
+            });
+            it = freeRanges.insert(it, range);
+
+            //merge with the next and the previous neighbour
+            if (auto next = std::next(it); next != freeRanges.end() && it->offset + it->size == next->offset) {
+                it->size += next->size;
+                freeRanges.erase(next);
+            }
+            if (it != freeRanges.begin()) {
+                auto prev = std::prev(it);
+                if (prev->offset + prev->size == it->offset) {
+                    prev->size += it->size;
+                    freeRanges.erase(it);
+                }
+            }
+        }
+
+    private:
+        std::vector<VuMemoryRange> freeRanges;
+    };
+}
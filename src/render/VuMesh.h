@@ -1,7 +1,13 @@
 #pragma once
 
+#include <memory>
+#include <span>
+
 #include "Common.h"
+#include "glm/common.hpp"
+#include "glm/geometric.hpp"
 #include "VuBuffer.h"
+#include "VuFile.h"
 #include "VuResourceManager.h"
 
 namespace std::filesystem {
@@ -10,17 +16,169 @@ namespace std::filesystem {
 
 namespace Vu {
 
+    //range of the index buffer drawn with a single vkCmdDrawIndexed,
+    //indices are relative to vertexOffset so 16 bit indices can address meshes with more than 65536 vertices
+    struct VuSubMesh {
+        uint32 firstIndex;
+        uint32 indexCount;
+        int32  vertexOffset;
+    };
+
+    //cpu side copy of the mesh streams, used by the importer before upload
+    struct VuMeshData {
+        std::vector<uint32> indices;
+        std::vector<float3> positions;
+        std::vector<float3> normals;
+        std::vector<float4> tangents;
+        std::vector<float2> uvs;
+
+        uint32 vertexCount() const {
+            return static_cast<uint32>(positions.size());
+        }
+    };
+
+    //the content of a mesh's gpu buffers, what a baked scene stores. the streams are either owned or views of a
+    //mapped bake, read them through getVertices and getIndices
+    struct VuMeshBytes {
+        uint32             vertexCount = 0U;
+        uint32             indexCount  = 0U;
+        float3             boundsCenter{0.0F};
+        float              boundsRadius = 0.0F;
+        std::vector<uint8> vertices;
+        std::vector<uint8> indices;
+        //set when the streams are read in place, the vectors then stay empty
+        std::shared_ptr<const VuMappedFile> mapping;
+        std::span<const uint8>              mappedVertices;
+        std::span<const uint8>              mappedIndices;
+
+        std::span<const uint8> getVertices() const {
+            return mapping != nullptr ? mappedVertices : std::span<const uint8>(vertices);
+        }
+
+        std::span<const uint8> getIndices() const {
+            return mapping != nullptr ? mappedIndices : std::span<const uint8>(indices);
+        }
+    };
+
     struct VuMesh {
         uint32 vertexCount;
         VuHandle<VuBuffer> indexBuffer;
         VuHandle<VuBuffer> vertexBuffer;
+        VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+        std::vector<VuSubMesh> subMeshes;
+        //object space bounding sphere
+        float3 boundsCenter;
+        float  boundsRadius;
 
         void uninit() {
             vertexBuffer.destroyHandle();
             indexBuffer.destroyHandle();
         }
 
-        VkDeviceSize totalAttributesSizePerVertex() {
+        //creates the gpu buffers and writes the streams, 16 bit indices are rebased to their submesh vertexOffset
+        void initFromData(const VuMeshData& data, std::span<const VuSubMesh> meshSubMeshes, VkIndexType meshIndexType) {
+            vertexCount = data.vertexCount();
+            indexType   = meshIndexType;
+            subMeshes.assign(meshSubMeshes.begin(), meshSubMeshes.end());
+            computeBounds(data.positions, boundsCenter, boundsRadius);
+
+            const VkDeviceSize indexCount = data.indices.size();
+            createBuffers(indexCount);
+
+            indexBuffer.get()->map();
+            writeIndices(data, subMeshes, indexType, indexBuffer.get()->getSpan(0, indexCount * indexStride(indexType)).data());
+            indexBuffer.get()->unmap();
+
+            vertexBuffer.get()->map();
+            writeVertexStreams(data, vertexBuffer.get()->getSpan(0, vertexCount * totalAttributesSizePerVertex()).data());
+            vertexBuffer.get()->unmap();
+        }
+
+        //bytes already in the buffer layout, e.g. a mapped baked file, one memcpy per buffer
+        void initFromBytes(const VuMeshBytes& bytes, std::span<const VuSubMesh> meshSubMeshes, VkIndexType meshIndexType) {
+            vertexCount  = bytes.vertexCount;
+            indexType    = meshIndexType;
+            boundsCenter = bytes.boundsCenter;
+            boundsRadius = bytes.boundsRadius;
+            subMeshes.assign(meshSubMeshes.begin(), meshSubMeshes.end());
+
+            createBuffers(bytes.indexCount);
+
+            const std::span<const uint8> indices  = bytes.getIndices();
+            const std::span<const uint8> vertices = bytes.getVertices();
+
+            indexBuffer.get()->map();
+            indexBuffer.get()->setData(indices.data(), indices.size(), 0U);
+            indexBuffer.get()->unmap();
+
+            vertexBuffer.get()->map();
+            vertexBuffer.get()->setData(vertices.data(), vertices.size(), 0U);
+            vertexBuffer.get()->unmap();
+        }
+
+        //what initFromData would write into the buffers
+        static VuMeshBytes toBytes(const VuMeshData& data, std::span<const VuSubMesh> meshSubMeshes, VkIndexType meshIndexType) {
+            VuMeshBytes bytes{};
+            bytes.vertexCount = data.vertexCount();
+            bytes.indexCount  = static_cast<uint32>(data.indices.size());
+            computeBounds(data.positions, bytes.boundsCenter, bytes.boundsRadius);
+            bytes.vertices.resize(bytes.vertexCount * totalAttributesSizePerVertex());
+            bytes.indices.resize(bytes.indexCount * indexStride(meshIndexType));
+            writeVertexStreams(data, bytes.vertices.data());
+            writeIndices(data, meshSubMeshes, meshIndexType, bytes.indices.data());
+            return bytes;
+        }
+
+        //positions, normals, tangents and uvs, each stream packed after the previous one
+        static void writeVertexStreams(const VuMeshData& data, uint8* dst) {
+            const size_t count = data.vertexCount();
+            std::memcpy(dst, data.positions.data(), sizeof(float3) * count);
+            dst += sizeof(float3) * count;
+            std::memcpy(dst, data.normals.data(), sizeof(float3) * count);
+            dst += sizeof(float3) * count;
+            std::memcpy(dst, data.tangents.data(), sizeof(float4) * count);
+            dst += sizeof(float4) * count;
+            std::memcpy(dst, data.uvs.data(), sizeof(float2) * count);
+        }
+
+        static void writeIndices(const VuMeshData& data, std::span<const VuSubMesh> meshSubMeshes, VkIndexType meshIndexType, uint8* dst) {
+            if (meshIndexType == VK_INDEX_TYPE_UINT16) {
+                auto* dst16 = reinterpret_cast<uint16 *>(dst);
+                for (const VuSubMesh& subMesh: meshSubMeshes) {
+                    for (uint32 i = subMesh.firstIndex; i < subMesh.firstIndex + subMesh.indexCount; i++) {
+                        dst16[i] = static_cast<uint16>(data.indices[i] - static_cast<uint32>(subMesh.vertexOffset));
+                    }
+                }
+            } else {
+                std::memcpy(dst, data.indices.data(), data.indices.size() * sizeof(uint32));
+            }
+        }
+
+        static VkDeviceSize indexStride(VkIndexType meshIndexType) {
+            return meshIndexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16) : sizeof(uint32);
+        }
+
+        //count 0 selects every submesh, a scene import keeps the primitives of a whole file in one mesh
+        std::span<const VuSubMesh> getSubMeshRange(uint32 first, uint32 count) const {
+            if (count == 0U) {
+                return subMeshes;
+            }
+            return std::span<const VuSubMesh>(subMeshes).subspan(first, count);
+        }
+
+        //sphere around the aabb, tight enough for screen size estimates
+        static void computeBounds(std::span<const float3> positions, float3& center, float& radius) {
+            float3 minPos{std::numeric_limits<float>::max()};
+            float3 maxPos{std::numeric_limits<float>::lowest()};
+            for (const float3& position: positions) {
+                minPos = glm::min(minPos, position);
+                maxPos = glm::max(maxPos, position);
+            }
+            center = positions.empty() ? float3{0.0F} : (minPos + maxPos) * 0.5F;
+            radius = positions.empty() ? 0.0F : glm::length(maxPos - minPos) * 0.5F;
+        }
+
+        static VkDeviceSize totalAttributesSizePerVertex() {
             //pos, norm, tan , uv
             return sizeof(float3) + sizeof(float3) + sizeof(float4) + sizeof(float2);
         }
@@ -37,6 +195,24 @@ namespace Vu {
             return (sizeof(float3) + sizeof(float3) + sizeof(float4)) * vertexCount;
         }
 
+        void createBuffers(VkDeviceSize indexCount) {
+            vertexBuffer.createHandle();
+            indexBuffer.createHandle();
+
+            indexBuffer.get()->init({
+                .length = indexCount,
+                .strideInBytes = indexStride(indexType),
+                .usageFlags = VK_BUFFER_USAGE_INDEX_BUFFER_BIT
+            });
+
+            vertexBuffer.get()->init({
+                .length = vertexCount * totalAttributesSizePerVertex(),
+                .strideInBytes = 1U,
+                .usageFlags = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
+            });
+            VuResourceManager::registerStorageBuffer(vertexBuffer.index, *vertexBuffer.get());
+        }
+
         // static std::array<VkVertexInputBindingDescription, 4> getBindingDescription() {
         //     std::array<VkVertexInputBindingDescription, 4> bindingDescriptions{};
         //     bindingDescriptions[0].binding = 0;
@@ -82,72 +258,5 @@ namespace Vu {
         //
         //     return attributeDescriptions;
         // }
-
-        static void calculateTangents(
-            const std::span<uint32> indices,
-            const std::span<float3> positions,
-            const std::span<float3> normals,
-            const std::span<float2> uvs,
-            std::span<float4> tangents) {
-
-            uint32 vertexCount = positions.size();
-            uint32 triangleCount = indices.size() / 3;
-
-            std::vector<float3> tan1(vertexCount);
-            std::vector<float3> tan2(vertexCount);
-
-            for (uint32 a = 0; a < triangleCount; a++) {
-                uint32 i1 = indices[a * 3 + 0];
-                uint32 i2 = indices[a * 3 + 1];
-                uint32 i3 = indices[a * 3 + 2];
-
-                const float3 v1 = positions[i1];
-                const float3 v2 = positions[i2];
-                const float3 v3 = positions[i3];
-
-                const float2 w1 = uvs[i1];
-                const float2 w2 = uvs[i2];
-                const float2 w3 = uvs[i3];
-
-                float x1 = v2.x - v1.x;
-                float x2 = v3.x - v1.x;
-                float y1 = v2.y - v1.y;
-                float y2 = v3.y - v1.y;
-                float z1 = v2.z - v1.z;
-                float z2 = v3.z - v1.z;
-
-                float s1 = w2.x - w1.x;
-                float s2 = w3.x - w1.x;
-                float t1 = w2.y - w1.y;
-                float t2 = w3.y - w1.y;
-
-                float r = 1.0f / (s1 * t2 - s2 * t1);
-
-                float3 sdir((t2 * x1 - t1 * x2) * r,
-                            (t2 * y1 - t1 * y2) * r,
-                            (t2 * z1 - t1 * z2) * r);
-
-                float3 tdir((s1 * x2 - s2 * x1) * r,
-                            (s1 * y2 - s2 * y1) * r,
-                            (s1 * z2 - s2 * z1) * r);
-
-                tan1[i1] += sdir;
-                tan1[i2] += sdir;
-                tan1[i3] += sdir;
-
-                tan2[i1] += tdir;
-                tan2[i2] += tdir;
-                tan2[i3] += tdir;
-            }
-
-            for (uint32 a = 0; a < vertexCount; a++) {
-                float3 n = normals[a];
-                float3 t = tan1[a];
-                // Gram-Schmidt orthogonalize
-                float3 vec = glm::normalize(t - n * glm::dot(n, t));
-                float sign = glm::dot(glm::cross(n, t), tan2[a]) < 0.0F ? -1.0F : 1.0F;
-                tangents[a] = float4(vec, sign);
-            }
-        }
     };
 }
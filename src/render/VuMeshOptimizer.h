@@ -0,0 +1,456 @@
+#pragma once
+
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+#include "Common.h"
+#include "VuMesh.h"
+
+namespace Vu {
+
+    struct VuMeshOptimizeStats {
+        uint32       vertexCountBefore;
+        uint32       vertexCountAfter;
+        float        acmrBefore;
+        float        acmrAfter;
+        VkDeviceSize indexBytesBefore;
+        VkDeviceSize indexBytesAfter;
+        uint32       subMeshCount;
+        VkIndexType  indexType;
+
+        void print(const std::string& assetName) const {
+            std::cout << std::format("[MESH] {0}: vertices {1} -> {2}, ACMR {3:.3f} -> {4:.3f}, index bytes {5} -> {6} ({7}, {8} submesh)",
+                                     assetName,
+                                     vertexCountBefore, vertexCountAfter,
+                                     acmrBefore, acmrAfter,
+                                     indexBytesBefore, indexBytesAfter,
+                                     indexType == VK_INDEX_TYPE_UINT16 ? "uint16" : "uint32",
+                                     subMeshCount) << std::endl;
+        }
+    };
+
+    //load time import stage: weld -> post transform cache order -> overdraw order -> fetch order -> index narrowing
+    struct VuMeshOptimizer {
+        static constexpr uint32 SIMULATED_CACHE_SIZE = 16;
+        static constexpr uint32 FORSYTH_CACHE_SIZE   = 32;
+        static constexpr float  OVERDRAW_THRESHOLD   = 1.05F;
+
+        static VuMeshOptimizeStats optimize(VuMeshData& mesh, std::vector<VuSubMesh>& outSubMeshes, VkIndexType& outIndexType) {
+            VuMeshOptimizeStats stats{};
+            stats.vertexCountBefore = mesh.vertexCount();
+            stats.acmrBefore        = computeACMR(mesh.indices, mesh.vertexCount(), SIMULATED_CACHE_SIZE);
+            stats.indexBytesBefore  = mesh.indices.size() * sizeof(uint32);
+
+            weldVertices(mesh);
+            optimizeVertexCache(mesh.indices, mesh.vertexCount());
+            optimizeOverdraw(mesh.indices, mesh.positions, OVERDRAW_THRESHOLD);
+            optimizeVertexFetch(mesh);
+            outIndexType = buildSubMeshes(mesh.indices, mesh.vertexCount(), outSubMeshes);
+
+            stats.vertexCountAfter = mesh.vertexCount();
+            stats.acmrAfter        = computeACMR(mesh.indices, mesh.vertexCount(), SIMULATED_CACHE_SIZE);
+            stats.indexBytesAfter  = mesh.indices.size() * (outIndexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16) : sizeof(uint32));
+            stats.subMeshCount     = static_cast<uint32>(outSubMeshes.size());
+            stats.indexType        = outIndexType;
+            return stats;
+        }
+
+        //average cache miss ratio, vertex transforms per triangle on a fifo cache
+        static float computeACMR(std::span<const uint32> indices, uint32 vertexCount, uint32 cacheSize) {
+            if (indices.size() < 3) {
+                return 0.0F;
+            }
+            std::vector<uint32> timestamps(vertexCount, 0U);
+            uint32              time   = cacheSize + 1U;
+            uint32              misses = 0U;
+
+            for (uint32 index: indices) {
+                if (time - timestamps[index] > cacheSize) {
+                    timestamps[index] = time++;
+                    misses++;
+                }
+            }
+            return static_cast<float>(misses) / static_cast<float>(indices.size() / 3);
+        }
+
+        //merges vertices whose attributes are bitwise identical
+        static void weldVertices(VuMeshData& mesh) {
+            const uint32 vertexCount = mesh.vertexCount();
+            if (vertexCount == 0U) {
+                return;
+            }
+
+            uint32 tableSize = 1U;
+            while (tableSize < vertexCount * 2U) {
+                tableSize <<= 1U;
+            }
+            std::vector<uint32> table(tableSize, UINT32_MAX);
+            std::vector<uint32> remap(vertexCount);
+
+            auto equals = [&mesh](uint32 a, uint32 b) {
+                return std::memcmp(&mesh.positions[a], &mesh.positions[b], sizeof(float3)) == 0
+                       && std::memcmp(&mesh.normals[a], &mesh.normals[b], sizeof(float3)) == 0
+                       && std::memcmp(&mesh.tangents[a], &mesh.tangents[b], sizeof(float4)) == 0
+                       && std::memcmp(&mesh.uvs[a], &mesh.uvs[b], sizeof(float2)) == 0;
+            };
+
+            uint32 uniqueCount = 0U;
+            for (uint32 v = 0U; v < vertexCount; v++) {
+                uint64 hash = hashBytes(&mesh.positions[v], sizeof(float3), 14695981039346656037ULL);
+                hash        = hashBytes(&mesh.normals[v], sizeof(float3), hash);
+                hash        = hashBytes(&mesh.tangents[v], sizeof(float4), hash);
+                hash        = hashBytes(&mesh.uvs[v], sizeof(float2), hash);
+
+                uint32 slot = static_cast<uint32>(hash) & (tableSize - 1U);
+                while (table[slot] != UINT32_MAX && !equals(table[slot], v)) {
+                    slot = (slot + 1U) & (tableSize - 1U);
+                }
+
+                if (table[slot] == UINT32_MAX) {
+                    remap[v] = uniqueCount;
+                    //compact in place, the unique vertex is never behind its first occurrence
+                    mesh.positions[uniqueCount] = mesh.positions[v];
+                    mesh.normals[uniqueCount]   = mesh.normals[v];
+                    mesh.tangents[uniqueCount]  = mesh.tangents[v];
+                    mesh.uvs[uniqueCount]       = mesh.uvs[v];
+                    table[slot] = uniqueCount;
+                    uniqueCount++;
+                } else {
+                    remap[v] = table[slot];
+                }
+            }
+
+            for (uint32& index: mesh.indices) {
+                index = remap[index];
+            }
+            mesh.positions.resize(uniqueCount);
+            mesh.normals.resize(uniqueCount);
+            mesh.tangents.resize(uniqueCount);
+            mesh.uvs.resize(uniqueCount);
+        }
+
+        //Tom Forsyth, Linear-Speed Vertex Cache Optimisation
+        static void optimizeVertexCache(std::vector<uint32>& indices, uint32 vertexCount) {
+            const uint32 triangleCount = static_cast<uint32>(indices.size() / 3);
+            if (triangleCount == 0U) {
+                return;
+            }
+
+            //vertex -> triangle adjacency, liveTriangles shrinks as triangles get emitted
+            std::vector<uint32> adjacencyOffsets(vertexCount + 1U, 0U);
+            for (uint32 index: indices) {
+                adjacencyOffsets[index + 1U]++;
+            }
+            std::partial_sum(adjacencyOffsets.begin(), adjacencyOffsets.end(), adjacencyOffsets.begin());
+
+            std::vector<uint32> adjacency(indices.size());
+            std::vector<uint32> liveTriangles(vertexCount, 0U);
+            for (uint32 t = 0U; t < triangleCount; t++) {
+                for (uint32 k = 0U; k < 3U; k++) {
+                    uint32 v = indices[t * 3U + k];
+                    adjacency[adjacencyOffsets[v] + liveTriangles[v]++] = t;
+                }
+            }
+
+            std::vector<int32> cachePosition(vertexCount, -1);
+            std::vector<float> vertexScores(vertexCount);
+            for (uint32 v = 0U; v < vertexCount; v++) {
+                vertexScores[v] = forsythVertexScore(-1, liveTriangles[v]);
+            }
+
+            std::vector<float> triangleScores(triangleCount);
+            std::vector<bool>  emitted(triangleCount, false);
+            uint32             bestTriangle = 0U;
+            for (uint32 t = 0U; t < triangleCount; t++) {
+                triangleScores[t] = vertexScores[indices[t * 3U]] + vertexScores[indices[t * 3U + 1U]] + vertexScores[indices[t * 3U + 2U]];
+                if (triangleScores[t] > triangleScores[bestTriangle]) {
+                    bestTriangle = t;
+                }
+            }
+
+            std::vector<uint32> result;
+            result.reserve(indices.size());
+
+            std::array<uint32, FORSYTH_CACHE_SIZE + 3U> cache{};
+            std::array<uint32, FORSYTH_CACHE_SIZE + 3U> nextCache{};
+            uint32                                      cacheCount = 0U;
+            uint32                                      scanCursor = 0U;
+
+            for (uint32 emittedCount = 0U; emittedCount < triangleCount; emittedCount++) {
+                if (bestTriangle == UINT32_MAX) {
+                    //nothing in cache touches a live triangle, continue from the first one not emitted
+                    while (emitted[scanCursor]) {
+                        scanCursor++;
+                    }
+                    bestTriangle = scanCursor;
+                }
+
+                const uint32 tri = bestTriangle;
+                emitted[tri]     = true;
+
+                uint32 nextCount = 0U;
+                for (uint32 k = 0U; k < 3U; k++) {
+                    uint32 v = indices[tri * 3U + k];
+                    result.push_back(v);
+                    nextCache[nextCount++] = v;
+
+                    //remove the triangle from the vertex adjacency
+                    uint32* begin = &adjacency[adjacencyOffsets[v]];
+                    uint32* end   = begin + liveTriangles[v];
+                    uint32* it    = std::find(begin, end, tri);
+                    *it           = *(end - 1);
+                    liveTriangles[v]--;
+                }
+
+                for (uint32 c = 0U; c < cacheCount; c++) {
+                    uint32 v = cache[c];
+                    if (v != nextCache[0] && v != nextCache[1] && v != nextCache[2]) {
+                        nextCache[nextCount++] = v;
+                    }
+                }
+
+                for (uint32 c = 0U; c < cacheCount; c++) {
+                    cachePosition[cache[c]] = -1;
+                }
+                for (uint32 c = 0U; c < nextCount; c++) {
+                    cachePosition[nextCache[c]] = c < FORSYTH_CACHE_SIZE ? static_cast<int32>(c) : -1;
+                }
+
+                //rescore every vertex that was or is in cache and pick the best triangle touching them
+                bestTriangle    = UINT32_MAX;
+                float bestScore = -1.0F;
+                for (uint32 c = 0U; c < nextCount; c++) {
+                    uint32 v       = nextCache[c];
+                    float  newScore = forsythVertexScore(cachePosition[v], liveTriangles[v]);
+                    float  delta    = newScore - vertexScores[v];
+                    vertexScores[v] = newScore;
+
+                    for (uint32 a = 0U; a < liveTriangles[v]; a++) {
+                        uint32 t = adjacency[adjacencyOffsets[v] + a];
+                        triangleScores[t] += delta;
+                        if (triangleScores[t] > bestScore) {
+                            bestScore    = triangleScores[t];
+                            bestTriangle = t;
+                        }
+                    }
+                }
+
+                cacheCount = std::min(nextCount, FORSYTH_CACHE_SIZE);
+                std::copy_n(nextCache.begin(), cacheCount, cache.begin());
+            }
+
+            indices = std::move(result);
+        }
+
+        //Sander et al., Fast Triangle Reordering for Vertex Locality and Reduced Overdraw
+        //clusters keep the cache friendly order, clusters facing away from the mesh center are drawn first
+        static void optimizeOverdraw(std::vector<uint32>& indices, std::span<const float3> positions, float threshold) {
+            const uint32 triangleCount = static_cast<uint32>(indices.size() / 3);
+            if (triangleCount < 2U) {
+                return;
+            }
+
+            std::vector<uint32> clusters = buildClusters(indices, static_cast<uint32>(positions.size()), threshold);
+            const uint32        clusterCount = static_cast<uint32>(clusters.size());
+            clusters.push_back(triangleCount);
+
+            float3 meshCentroid{0.0F};
+            float  meshArea = 0.0F;
+
+            std::vector<float3> clusterCentroids(clusterCount, float3{0.0F});
+            std::vector<float3> clusterNormals(clusterCount, float3{0.0F});
+
+            for (uint32 c = 0U; c < clusterCount; c++) {
+                float clusterArea = 0.0F;
+                for (uint32 t = clusters[c]; t < clusters[c + 1U]; t++) {
+                    const float3& p0 = positions[indices[t * 3U]];
+                    const float3& p1 = positions[indices[t * 3U + 1U]];
+                    const float3& p2 = positions[indices[t * 3U + 2U]];
+
+                    float3 n    = glm::cross(p1 - p0, p2 - p0);
+                    float  area = glm::length(n);
+                    float3 mid  = (p0 + p1 + p2) / 3.0F;
+
+                    clusterCentroids[c] += mid * area;
+                    clusterNormals[c] += n;
+                    clusterArea += area;
+                    meshCentroid += mid * area;
+                    meshArea += area;
+                }
+                clusterCentroids[c] /= clusterArea > 0.0F ? clusterArea : 1.0F;
+            }
+            meshCentroid /= meshArea > 0.0F ? meshArea : 1.0F;
+
+            std::vector<float> sortKeys(clusterCount);
+            for (uint32 c = 0U; c < clusterCount; c++) {
+                float normalLength = glm::length(clusterNormals[c]);
+                float3 normal      = normalLength > 0.0F ? clusterNormals[c] / normalLength : float3{0.0F};
+                sortKeys[c]        = glm::dot(clusterCentroids[c] - meshCentroid, normal);
+            }
+
+            std::vector<uint32> order(clusterCount);
+            std::iota(order.begin(), order.end(), 0U);
+            std::stable_sort(order.begin(), order.end(), [&sortKeys](uint32 a, uint32 b) { return sortKeys[a] > sortKeys[b]; });
+
+            std::vector<uint32> result;
+            result.reserve(indices.size());
+            for (uint32 c: order) {
+                result.insert(result.end(), indices.begin() + clusters[c] * 3U, indices.begin() + clusters[c + 1U] * 3U);
+            }
+            indices = std::move(result);
+        }
+
+        //renumbers vertices in first use order so vertex pulling reads memory linearly
+        static void optimizeVertexFetch(VuMeshData& mesh) {
+            std::vector<uint32> remap(mesh.vertexCount(), UINT32_MAX);
+            uint32              nextVertex = 0U;
+
+            VuMeshData fetchOrdered{};
+            fetchOrdered.positions.reserve(mesh.vertexCount());
+            fetchOrdered.normals.reserve(mesh.vertexCount());
+            fetchOrdered.tangents.reserve(mesh.vertexCount());
+            fetchOrdered.uvs.reserve(mesh.vertexCount());
+
+            for (uint32& index: mesh.indices) {
+                if (remap[index] == UINT32_MAX) {
+                    remap[index] = nextVertex++;
+                    fetchOrdered.positions.push_back(mesh.positions[index]);
+                    fetchOrdered.normals.push_back(mesh.normals[index]);
+                    fetchOrdered.tangents.push_back(mesh.tangents[index]);
+                    fetchOrdered.uvs.push_back(mesh.uvs[index]);
+                }
+                index = remap[index];
+            }
+
+            fetchOrdered.indices = std::move(mesh.indices);
+            mesh                 = std::move(fetchOrdered);
+        }
+
+        //splits the index stream into windows of at most 65536 vertices so each window can use 16 bit indices,
+        //falls back to a single 32 bit range if a triangle spans more than that
+        static VkIndexType buildSubMeshes(std::span<const uint32> indices, uint32 vertexCount, std::vector<VuSubMesh>& outSubMeshes) {
+            constexpr uint32 MAX_WINDOW = 65535U;
+            outSubMeshes.clear();
+
+            if (vertexCount <= MAX_WINDOW + 1U) {
+                outSubMeshes.push_back({0U, static_cast<uint32>(indices.size()), 0});
+                return VK_INDEX_TYPE_UINT16;
+            }
+
+            uint32 windowStart = 0U;
+            uint32 windowMin   = UINT32_MAX;
+            uint32 windowMax   = 0U;
+
+            for (uint32 i = 0U; i < indices.size(); i += 3U) {
+                uint32 triMin = std::min({indices[i], indices[i + 1U], indices[i + 2U]});
+                uint32 triMax = std::max({indices[i], indices[i + 1U], indices[i + 2U]});
+                if (triMax - triMin > MAX_WINDOW) {
+                    outSubMeshes.clear();
+                    outSubMeshes.push_back({0U, static_cast<uint32>(indices.size()), 0});
+                    return VK_INDEX_TYPE_UINT32;
+                }
+
+                uint32 newMin = std::min(windowMin, triMin);
+                uint32 newMax = std::max(windowMax, triMax);
+                if (newMax - newMin > MAX_WINDOW) {
+                    outSubMeshes.push_back({windowStart, i - windowStart, static_cast<int32>(windowMin)});
+                    windowStart = i;
+                    newMin      = triMin;
+                    newMax      = triMax;
+                }
+                windowMin = newMin;
+                windowMax = newMax;
+            }
+            outSubMeshes.push_back({windowStart, static_cast<uint32>(indices.size()) - windowStart, static_cast<int32>(windowMin)});
+            return VK_INDEX_TYPE_UINT16;
+        }
+
+    private:
+        static uint64 hashBytes(const void* data, size_t size, uint64 hash) {
+            const auto* bytes = static_cast<const uint8 *>(data);
+            for (size_t i = 0; i < size; i++) {
+                hash ^= bytes[i];
+                hash *= 1099511628211ULL;
+            }
+            return hash;
+        }
+
+        static float forsythVertexScore(int32 cachePosition, uint32 liveTriangleCount) {
+            if (liveTriangleCount == 0U) {
+                return -1.0F;
+            }
+            float score = 0.0F;
+            if (cachePosition >= 0) {
+                if (cachePosition < 3) {
+                    //the last triangle's vertices get a fixed score so the strip does not ping-pong
+                    score = 0.75F;
+                } else {
+                    const float scaler = 1.0F / static_cast<float>(FORSYTH_CACHE_SIZE - 3U);
+                    score              = std::pow(1.0F - static_cast<float>(cachePosition - 3) * scaler, 1.5F);
+                }
+            }
+            //boost vertices with few triangles left so lone triangles are not stranded
+            score += 2.0F / std::sqrt(static_cast<float>(liveTriangleCount));
+            return score;
+        }
+
+        //returns the first triangle of every cluster, clusters start at cache resets (hard boundaries)
+        //and are subdivided while the local ACMR stays within threshold of the hard cluster (soft boundaries)
+        static std::vector<uint32> buildClusters(std::span<const uint32> indices, uint32 vertexCount, float threshold) {
+            const uint32        triangleCount = static_cast<uint32>(indices.size() / 3);
+            std::vector<uint32> timestamps(vertexCount, 0U);
+            uint32              time = SIMULATED_CACHE_SIZE + 1U;
+
+            auto missCount = [&](uint32 t) {
+                uint32 misses = 0U;
+                for (uint32 k = 0U; k < 3U; k++) {
+                    uint32 v = indices[t * 3U + k];
+                    if (time - timestamps[v] > SIMULATED_CACHE_SIZE) {
+                        timestamps[v] = time++;
+                        misses++;
+                    }
+                }
+                return misses;
+            };
+
+            std::vector<uint32> hardClusters;
+            for (uint32 t = 0U; t < triangleCount; t++) {
+                if (missCount(t) == 3U || t == 0U) {
+                    hardClusters.push_back(t);
+                }
+            }
+            hardClusters.push_back(triangleCount);
+
+            std::vector<uint32> clusters;
+            for (uint32 h = 0U; h + 1U < hardClusters.size(); h++) {
+                const uint32 begin = hardClusters[h];
+                const uint32 end   = hardClusters[h + 1U];
+
+                //reset the cache, then measure the whole hard cluster
+                time += SIMULATED_CACHE_SIZE + 1U;
+                uint32 clusterMisses = 0U;
+                for (uint32 t = begin; t < end; t++) {
+                    clusterMisses += missCount(t);
+                }
+                const float clusterACMR = static_cast<float>(clusterMisses) / static_cast<float>(end - begin);
+
+                time += SIMULATED_CACHE_SIZE + 1U;
+                uint32 softStart  = begin;
+                uint32 softMisses = 0U;
+                clusters.push_back(begin);
+                for (uint32 t = begin; t < end; t++) {
+                    softMisses += missCount(t);
+                    const float softACMR = static_cast<float>(softMisses) / static_cast<float>(t - softStart + 1U);
+                    if (t + 1U < end && softACMR <= clusterACMR * threshold && t - softStart >= 8U) {
+                        clusters.push_back(t + 1U);
+                        softStart  = t + 1U;
+                        softMisses = 0U;
+                        time += SIMULATED_CACHE_SIZE + 1U;
+                    }
+                }
+            }
+            return clusters;
+        }
+    };
+}
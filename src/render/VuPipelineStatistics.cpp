@@ -0,0 +1,245 @@
+#include "VuPipelineStatistics.h"
+
+#include <algorithm>
+#include <format>
+#include <iostream>
+
+#include "VuCtx.h"
+#include "VuDevice.h"
+
+namespace Vu {
+
+    namespace {
+        //results come in bit order of the flags, vertex shader < clipping primitives < fragment shader
+        constexpr VkQueryPipelineStatisticFlags STATISTIC_FLAGS = VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT
+                                                                  | VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT
+                                                                  | VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+        //three counters and the availability word
+        constexpr uint32 STATISTIC_WORDS = 4U;
+    }
+
+    void VuPipelineStatistics::init(const VuPipelineStatisticsCreateInfo& info, VkExtent2D screenExtent) {
+        createInfo            = info;
+        createInfo.windowSize = std::max(info.windowSize, 1U);
+        extent                = screenExtent;
+        enabled               = false;
+        if (!info.enabled || info.maxGroupsPerFrame == 0U) {
+            return;
+        }
+
+        VkQueryPoolCreateInfo statisticsInfo{};
+        statisticsInfo.sType              = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        statisticsInfo.queryType          = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+        statisticsInfo.queryCount         = createInfo.maxGroupsPerFrame;
+        statisticsInfo.pipelineStatistics = STATISTIC_FLAGS;
+
+        VkQueryPoolCreateInfo occlusionInfo{};
+        occlusionInfo.sType      = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        occlusionInfo.queryType  = VK_QUERY_TYPE_OCCLUSION;
+        occlusionInfo.queryCount = createInfo.maxGroupsPerFrame;
+
+        for (FrameQueries& frame: frames) {
+            VkCheck(vkCreateQueryPool(ctx::vuDevice->device, &statisticsInfo, nullptr, &frame.statisticsPool));
+            if (createInfo.occlusion) {
+                VkCheck(vkCreateQueryPool(ctx::vuDevice->device, &occlusionInfo, nullptr, &frame.occlusionPool));
+            }
+            frame.groups.clear();
+        }
+        results.resize(static_cast<size_t>(createInfo.maxGroupsPerFrame) * STATISTIC_WORDS);
+        frameCount = 0U;
+        enabled    = true;
+    }
+
+    void VuPipelineStatistics::uninit() {
+        for (FrameQueries& frame: frames) {
+            if (frame.statisticsPool != VK_NULL_HANDLE) {
+                vkDestroyQueryPool(ctx::vuDevice->device, frame.statisticsPool, nullptr);
+                frame.statisticsPool = VK_NULL_HANDLE;
+            }
+            if (frame.occlusionPool != VK_NULL_HANDLE) {
+                vkDestroyQueryPool(ctx::vuDevice->device, frame.occlusionPool, nullptr);
+                frame.occlusionPool = VK_NULL_HANDLE;
+            }
+        }
+        enabled = false;
+    }
+
+    bool VuPipelineStatistics::isEnabled() const {
+        return enabled;
+    }
+
+    void VuPipelineStatistics::beginFrame(VkCommandBuffer commandBuffer, uint32 frameSlot) {
+        if (!enabled) {
+            return;
+        }
+
+        currentSlot         = frameSlot;
+        FrameQueries& frame = frames[frameSlot];
+        collect(frame);
+
+        frame.groups.clear();
+        groupDepth  = 0U;
+        groupActive = false;
+        vkCmdResetQueryPool(commandBuffer, frame.statisticsPool, 0U, createInfo.maxGroupsPerFrame);
+        if (frame.occlusionPool != VK_NULL_HANDLE) {
+            vkCmdResetQueryPool(commandBuffer, frame.occlusionPool, 0U, createInfo.maxGroupsPerFrame);
+        }
+
+        frameCount++;
+        if (createInfo.dumpInterval != 0U && frameCount % createInfo.dumpInterval == 0U) {
+            dump();
+        }
+    }
+
+    void VuPipelineStatistics::beginGroup(VkCommandBuffer commandBuffer, const std::string& name) {
+        if (!enabled) {
+            return;
+        }
+
+        FrameQueries& frame = frames[currentSlot];
+        if (groupDepth++ > 0U) {
+            if (!nestWarned) {
+                std::cerr << "[WARNING]: draw group '" << name << "' is nested, it is counted towards the outer group" << std::endl;
+                nestWarned = true;
+            }
+            return;
+        }
+        if (frame.groups.size() >= createInfo.maxGroupsPerFrame) {
+            return;
+        }
+
+        const uint32 query = static_cast<uint32>(frame.groups.size());
+        frame.groups.push_back(getOrAddGroup(name));
+        groupActive = true;
+
+        vkCmdBeginQuery(commandBuffer, frame.statisticsPool, query, 0U);
+        if (frame.occlusionPool != VK_NULL_HANDLE) {
+            vkCmdBeginQuery(commandBuffer, frame.occlusionPool, query, VK_QUERY_CONTROL_PRECISE_BIT);
+        }
+    }
+
+    void VuPipelineStatistics::endGroup(VkCommandBuffer commandBuffer) {
+        if (!enabled || groupDepth == 0U || --groupDepth > 0U || !groupActive) {
+            return;
+        }
+
+        FrameQueries& frame = frames[currentSlot];
+        const uint32  query = static_cast<uint32>(frame.groups.size()) - 1U;
+        groupActive         = false;
+
+        if (frame.occlusionPool != VK_NULL_HANDLE) {
+            vkCmdEndQuery(commandBuffer, frame.occlusionPool, query);
+        }
+        vkCmdEndQuery(commandBuffer, frame.statisticsPool, query);
+    }
+
+    void VuPipelineStatistics::collect(FrameQueries& frame) {
+        const uint32 count = static_cast<uint32>(frame.groups.size());
+        if (count == 0U) {
+            return;
+        }
+
+        //the frame's fence was signaled already, no wait flag
+        constexpr VkQueryResultFlags flags = VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT;
+        VkResult result = vkGetQueryPoolResults(ctx::vuDevice->device, frame.statisticsPool, 0U, count,
+                                                count * STATISTIC_WORDS * sizeof(uint64), results.data(),
+                                                STATISTIC_WORDS * sizeof(uint64), flags);
+        if (result != VK_SUCCESS && result != VK_NOT_READY) {
+            VkCheck(result);
+        }
+
+        //value and availability per query
+        std::vector<uint64> occlusion(static_cast<size_t>(count) * 2U, 0U);
+        if (frame.occlusionPool != VK_NULL_HANDLE) {
+            result = vkGetQueryPoolResults(ctx::vuDevice->device, frame.occlusionPool, 0U, count,
+                                           occlusion.size() * sizeof(uint64), occlusion.data(), 2U * sizeof(uint64), flags);
+            if (result != VK_SUCCESS && result != VK_NOT_READY) {
+                VkCheck(result);
+            }
+        }
+
+        for (uint32 query = 0; query < count; query++) {
+            const uint64* words = &results[query * STATISTIC_WORDS];
+            if (words[3] == 0U) {
+                continue;
+            }
+
+            const Sample sample{words[0], words[1], words[2], occlusion[query * 2U + 1U] != 0U ? occlusion[query * 2U] : 0U};
+            Group&       group = groups[frame.groups[query]];
+            if (group.samples.size() < createInfo.windowSize) {
+                group.samples.push_back(sample);
+            } else {
+                group.samples[group.head] = sample;
+                group.head                = (group.head + 1U) % createInfo.windowSize;
+            }
+        }
+    }
+
+    uint32 VuPipelineStatistics::getOrAddGroup(const std::string& name) {
+        const auto it = groupIndices.find(name);
+        if (it != groupIndices.end()) {
+            return it->second;
+        }
+
+        const uint32 index = static_cast<uint32>(groups.size());
+        groups.push_back({.name = name});
+        groups.back().samples.reserve(createInfo.windowSize);
+        groupIndices.emplace(name, index);
+        return index;
+    }
+
+    VuDrawGroupStats VuPipelineStatistics::computeStats(const Group& group) const {
+        VuDrawGroupStats stats{group.name, 0.0, 0.0, 0.0, 0.0, 0.0, static_cast<uint32>(group.samples.size())};
+        if (group.samples.empty()) {
+            return stats;
+        }
+
+        for (const Sample& sample: group.samples) {
+            stats.vertexInvocations += static_cast<double>(sample.vertexInvocations);
+            stats.clippingPrimitives += static_cast<double>(sample.clippingPrimitives);
+            stats.fragmentInvocations += static_cast<double>(sample.fragmentInvocations);
+            stats.samplesPassed += static_cast<double>(sample.samplesPassed);
+        }
+
+        const double count = static_cast<double>(group.samples.size());
+        const double pixels = static_cast<double>(extent.width) * static_cast<double>(extent.height);
+        stats.vertexInvocations /= count;
+        stats.clippingPrimitives /= count;
+        stats.fragmentInvocations /= count;
+        stats.samplesPassed /= count;
+        stats.overdraw = pixels > 0.0 ? stats.fragmentInvocations / pixels : 0.0;
+        return stats;
+    }
+
+    std::vector<VuDrawGroupStats> VuPipelineStatistics::getAllStats() const {
+        std::vector<VuDrawGroupStats> result;
+        result.reserve(groups.size());
+        for (const Group& group: groups) {
+            result.push_back(computeStats(group));
+        }
+        return result;
+    }
+
+    bool VuPipelineStatistics::getStats(const std::string& name, VuDrawGroupStats& outStats) const {
+        const auto it = groupIndices.find(name);
+        if (it == groupIndices.end()) {
+            return false;
+        }
+        outStats = computeStats(groups[it->second]);
+        return true;
+    }
+
+    void VuPipelineStatistics::dump() const {
+        //fragments per passed sample: well above 1 means most shading is thrown away by the depth test (overdraw),
+        //close to 1 with a high overdraw means the fragments are visible and the cost is the shading itself
+        std::cout << std::format("[INFO]: draw group statistics after {} frames, per frame averages\n", frameCount);
+        std::cout << std::format("    {:<16} {:>12} {:>12} {:>12} {:>12} {:>9}\n",
+                                 "group", "vs invoc", "clip prims", "fs invoc", "samples", "overdraw");
+        for (const Group& group: groups) {
+            const VuDrawGroupStats s = computeStats(group);
+            std::cout << std::format("    {:<16} {:>12.0f} {:>12.0f} {:>12.0f} {:>12.0f} {:>9.3f}\n",
+                                     s.name, s.vertexInvocations, s.clippingPrimitives, s.fragmentInvocations, s.samplesPassed, s.overdraw);
+        }
+        std::cout.flush();
+    }
+}
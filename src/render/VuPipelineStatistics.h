@@ -0,0 +1,106 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Common.h"
+#include "VuConfig.h"
+
+namespace Vu {
+
+    struct VuPipelineStatisticsCreateInfo {
+        //needs the pipelineStatisticsQuery device feature, occlusion counts also want occlusionQueryPrecise
+        bool   enabled   = false;
+        bool   occlusion = true;
+        //draw groups per frame, vulkan sc caps this with maxPipelineStatisticsQueriesPerPool
+        uint32 maxGroupsPerFrame = 32U;
+        //frames averaged per group
+        uint32 windowSize = 60U;
+        //print every group to the log every n frames, 0 never prints
+        uint32 dumpInterval = 0U;
+    };
+
+    //per frame averages of one draw group over the last windowSize frames it was drawn in
+    struct VuDrawGroupStats {
+        std::string name;
+        double      vertexInvocations;
+        double      clippingPrimitives;
+        double      fragmentInvocations;
+        //0 when occlusion queries are off
+        double      samplesPassed;
+        //fragment invocations per screen pixel, above 1 the group shades pixels more than once
+        double      overdraw;
+        uint32      sampleCount;
+    };
+
+    //pipeline statistics (and optionally occlusion) queries around named draw groups. like VuGpuProfiler every
+    //frame in flight owns its pools, which are read once the frame's fence was waited, so nothing ever waits.
+    //queries of one type can not nest, a group begun inside another one is measured as part of the outer one
+    struct VuPipelineStatistics {
+    public:
+        void init(const VuPipelineStatisticsCreateInfo& info, VkExtent2D screenExtent);
+
+        void uninit();
+
+        bool isEnabled() const;
+
+        //after the fence of frameSlot was waited, outside of a render pass
+        void beginFrame(VkCommandBuffer commandBuffer, uint32 frameSlot);
+
+        //inside the render pass, begin and end in the same subpass
+        void beginGroup(VkCommandBuffer commandBuffer, const std::string& name);
+
+        void endGroup(VkCommandBuffer commandBuffer);
+
+        std::vector<VuDrawGroupStats> getAllStats() const;
+
+        bool getStats(const std::string& name, VuDrawGroupStats& outStats) const;
+
+        void dump() const;
+
+    private:
+        struct Sample {
+            uint64 vertexInvocations;
+            uint64 clippingPrimitives;
+            uint64 fragmentInvocations;
+            uint64 samplesPassed;
+        };
+
+        struct Group {
+            std::string         name;
+            std::vector<Sample> samples;
+            uint32              head = 0U;
+        };
+
+        struct FrameQueries {
+            VkQueryPool         statisticsPool = VK_NULL_HANDLE;
+            VkQueryPool         occlusionPool  = VK_NULL_HANDLE;
+            //group index of every query used this frame
+            std::vector<uint32> groups;
+        };
+
+        VuPipelineStatisticsCreateInfo createInfo{};
+        VkExtent2D                     extent{};
+        bool                           enabled      = false;
+        //nested groups only count towards the outermost one
+        uint32                         groupDepth   = 0U;
+        bool                           groupActive  = false;
+        bool                           nestWarned   = false;
+        uint64                         frameCount   = 0U;
+        uint32                         currentSlot  = 0U;
+
+        std::array<FrameQueries, config::MAX_FRAMES_IN_FLIGHT> frames{};
+
+        std::vector<Group>                      groups;
+        std::unordered_map<std::string, uint32> groupIndices;
+        std::vector<uint64>                     results;
+
+        void collect(FrameQueries& frame);
+
+        uint32 getOrAddGroup(const std::string& name);
+
+        VuDrawGroupStats computeStats(const Group& group) const;
+    };
+}
@@ -0,0 +1,695 @@
+#include "VuRenderGraph.h"
+
+#include "VuCtx.h"
+#include "VuDevice.h"
+#include "VuGpuProfiler.h"
+#include "VuImage.h"
+
+namespace Vu {
+
+    namespace {
+        struct AccessInfo {
+            VkPipelineStageFlags2KHR stages;
+            VkAccessFlags2KHR        access;
+            VkImageLayout            layout;
+            VkImageUsageFlags        imageUsage;
+        };
+
+        constexpr VkPipelineStageFlags2KHR SHADER_STAGES = VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT_KHR
+                                                           | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT_KHR
+                                                           | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR;
+
+        constexpr VkPipelineStageFlags2KHR DEPTH_STAGES = VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT_KHR
+                                                          | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT_KHR;
+
+        constexpr VkAccessFlags2KHR WRITE_ACCESS = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT_KHR
+                                                   | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT_KHR
+                                                   | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT_KHR
+                                                   | VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR;
+
+        AccessInfo getAccessInfo(VuRGAccess access, bool isImage) {
+            switch (access) {
+                case VuRGAccess::ColorAttachmentWrite:
+                    return {
+                        VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT_KHR,
+                        VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT_KHR | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT_KHR,
+                        VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                        VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT
+                    };
+                case VuRGAccess::DepthAttachmentWrite:
+                    return {
+                        DEPTH_STAGES,
+                        VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT_KHR | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT_KHR,
+                        VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+                        VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT
+                    };
+                case VuRGAccess::DepthAttachmentRead:
+                    return {
+                        DEPTH_STAGES,
+                        VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT_KHR,
+                        VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+                        VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT
+                    };
+                case VuRGAccess::SampledRead:
+                    //buffers have no sampled form, for them this is a uniform read
+                    return {
+                        SHADER_STAGES,
+                        isImage ? VK_ACCESS_2_SHADER_SAMPLED_READ_BIT_KHR : VK_ACCESS_2_UNIFORM_READ_BIT_KHR,
+                        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                        VK_IMAGE_USAGE_SAMPLED_BIT
+                    };
+                case VuRGAccess::StorageRead:
+                    return {
+                        SHADER_STAGES,
+                        VK_ACCESS_2_SHADER_STORAGE_READ_BIT_KHR,
+                        VK_IMAGE_LAYOUT_GENERAL,
+                        VK_IMAGE_USAGE_STORAGE_BIT
+                    };
+                case VuRGAccess::StorageWrite:
+                    return {
+                        VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT_KHR | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR,
+                        VK_ACCESS_2_SHADER_STORAGE_READ_BIT_KHR | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT_KHR,
+                        VK_IMAGE_LAYOUT_GENERAL,
+                        VK_IMAGE_USAGE_STORAGE_BIT
+                    };
+                case VuRGAccess::TransferRead:
+                    return {
+                        VK_PIPELINE_STAGE_2_TRANSFER_BIT_KHR,
+                        VK_ACCESS_2_TRANSFER_READ_BIT_KHR,
+                        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                        VK_IMAGE_USAGE_TRANSFER_SRC_BIT
+                    };
+                case VuRGAccess::TransferWrite:
+                    return {
+                        VK_PIPELINE_STAGE_2_TRANSFER_BIT_KHR,
+                        VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR,
+                        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                        VK_IMAGE_USAGE_TRANSFER_DST_BIT
+                    };
+                case VuRGAccess::IndirectRead:
+                    if (isImage) {
+                        throw std::runtime_error("render graph: indirect read is only valid for buffers!");
+                    }
+                    return {
+                        VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT_KHR,
+                        VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT_KHR,
+                        VK_IMAGE_LAYOUT_UNDEFINED,
+                        0U
+                    };
+            }
+            throw std::runtime_error("render graph: unknown access!");
+        }
+    }
+
+    //PASS BUILDER//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    VuRGImage VuRGPassBuilder::read(VuRGImage image, VuRGAccess access) {
+        graph.addUse(passIndex, image.index, access, false);
+        return image;
+    }
+
+    VuRGImage VuRGPassBuilder::write(VuRGImage image, VuRGAccess access) {
+        graph.addUse(passIndex, image.index, access, true);
+        return image;
+    }
+
+    VuRGBuffer VuRGPassBuilder::read(VuRGBuffer buffer, VuRGAccess access) {
+        graph.addUse(passIndex, buffer.index, access, false);
+        return buffer;
+    }
+
+    VuRGBuffer VuRGPassBuilder::write(VuRGBuffer buffer, VuRGAccess access) {
+        graph.addUse(passIndex, buffer.index, access, true);
+        return buffer;
+    }
+
+    void VuRGPassBuilder::hasSideEffects() {
+        graph.passes[passIndex].sideEffects = true;
+    }
+
+    //BUILD/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    void VuRenderGraph::init(const VuRenderGraphCreateInfo& info) {
+        createInfo = info;
+    }
+
+    void VuRenderGraph::uninit() {
+        //expects the device to be idle, the transient block itself can not be freed on vulkan sc
+        releaseTransients();
+        passes.clear();
+        resources.clear();
+        liveOrder.clear();
+        batches.clear();
+        finalBatch = {};
+        compiled   = false;
+    }
+
+    void VuRenderGraph::reset() {
+        uninit();
+    }
+
+    VuRGImage VuRenderGraph::importImage(const std::string& name, const VuRGImportedImageInfo& info) {
+        Resource resource{};
+        resource.name         = name;
+        resource.isImage      = true;
+        resource.imported     = true;
+        resource.output       = info.output || info.finalState.layout != VK_IMAGE_LAYOUT_UNDEFINED;
+        resource.desc         = info.desc;
+        resource.image        = info.image;
+        resource.view         = info.view;
+        resource.initialState = info.initialState;
+        resource.finalState   = info.finalState;
+
+        if (hasDepth(info.desc.format)) {
+            resource.aspect = VK_IMAGE_ASPECT_DEPTH_BIT | (hasStencil(info.desc.format) ? VK_IMAGE_ASPECT_STENCIL_BIT : 0U);
+        } else {
+            resource.aspect = hasStencil(info.desc.format) ? VK_IMAGE_ASPECT_STENCIL_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
+        }
+
+        resources.push_back(resource);
+        compiled = false;
+        return {static_cast<uint32>(resources.size() - 1U)};
+    }
+
+    VuRGBuffer VuRenderGraph::importBuffer(const std::string& name, const VuRGImportedBufferInfo& info) {
+        Resource resource{};
+        resource.name         = name;
+        resource.isImage      = false;
+        resource.imported     = true;
+        resource.output       = info.output;
+        resource.buffer       = info.buffer;
+        resource.size         = info.size;
+        resource.initialState = info.initialState;
+        resource.finalState   = info.finalState;
+
+        resources.push_back(resource);
+        compiled = false;
+        return {static_cast<uint32>(resources.size() - 1U)};
+    }
+
+    VuRGImage VuRenderGraph::createImage(const std::string& name, const VuRGImageDesc& desc) {
+        VuRGImportedImageInfo info{};
+        info.desc   = desc;
+        info.output = false;
+
+        //transients are described like an import without handles, compile() creates them
+        VuRGImage image = importImage(name, info);
+        resources[image.index].imported = false;
+        return image;
+    }
+
+    VuRGPass VuRenderGraph::addPass(const std::string& name, const std::function<void(VuRGPassBuilder&)>& setup, ExecuteFunc execute) {
+        Pass pass{};
+        pass.name    = name;
+        pass.execute = std::move(execute);
+        passes.push_back(std::move(pass));
+
+        const uint32    passIndex = static_cast<uint32>(passes.size() - 1U);
+        VuRGPassBuilder builder{*this, passIndex};
+        setup(builder);
+
+        compiled = false;
+        return {passIndex};
+    }
+
+    void VuRenderGraph::addUse(uint32 passIndex, uint32 resource, VuRGAccess access, bool writes) {
+        if (resource >= resources.size()) {
+            throw std::runtime_error("render graph: pass '" + passes[passIndex].name + "' uses an invalid resource!");
+        }
+
+        Resource&        res  = resources[resource];
+        const AccessInfo info = getAccessInfo(access, res.isImage);
+        if (!res.imported) {
+            res.usage |= info.imageUsage;
+        }
+
+        Use use{};
+        use.resource   = resource;
+        use.stages     = info.stages;
+        use.access     = info.access;
+        use.layout     = res.isImage ? info.layout : VK_IMAGE_LAYOUT_UNDEFINED;
+        use.imageUsage = info.imageUsage;
+        use.reads      = !writes;
+        use.writes     = writes;
+
+        //a pass touches a resource once, read and write of the same resource become one use
+        for (Use& existing: passes[passIndex].uses) {
+            if (existing.resource != resource) {
+                continue;
+            }
+            if (existing.layout != use.layout) {
+                throw std::runtime_error("render graph: pass '" + passes[passIndex].name + "' needs '" + res.name + "' in two layouts!");
+            }
+            existing.stages |= use.stages;
+            existing.access |= use.access;
+            existing.imageUsage |= use.imageUsage;
+            existing.reads  = existing.reads || use.reads;
+            existing.writes = existing.writes || use.writes;
+            return;
+        }
+        passes[passIndex].uses.push_back(use);
+    }
+
+    void VuRenderGraph::compile() {
+        releaseTransients();
+        cullPasses();
+        computeLifetimes();
+        allocateTransients();
+
+        //the first run only finds where every resource ends up, the second uses that to
+        //order the first use of a transient after the previous frame or the previous occupant of its memory
+        std::vector<TrackedState> firstRunStates;
+        std::vector<TrackedState> endStates;
+        buildBarriers({}, firstRunStates);
+        buildBarriers(firstRunStates, endStates);
+
+        compiled = true;
+    }
+
+    void VuRenderGraph::cullPasses() {
+        std::vector<bool> needed(resources.size(), false);
+        for (uint32 i = 0U; i < resources.size(); i++) {
+            needed[i] = resources[i].output;
+        }
+
+        //walk back from the outputs, a pass survives when it writes something a later survivor reads
+        for (uint32 i = static_cast<uint32>(passes.size()); i-- > 0U;) {
+            Pass& pass = passes[i];
+            pass.live  = pass.sideEffects;
+            for (const Use& use: pass.uses) {
+                if (use.writes && needed[use.resource]) {
+                    pass.live = true;
+                }
+            }
+            if (!pass.live) {
+                continue;
+            }
+            //a plain write replaces the contents, so earlier writers are only needed if someone before reads it
+            for (const Use& use: pass.uses) {
+                if (use.writes && !use.reads && !resources[use.resource].imported) {
+                    needed[use.resource] = false;
+                }
+            }
+            for (const Use& use: pass.uses) {
+                if (use.reads) {
+                    needed[use.resource] = true;
+                }
+            }
+        }
+
+        liveOrder.clear();
+        for (uint32 i = 0U; i < passes.size(); i++) {
+            if (passes[i].live) {
+                liveOrder.push_back(i);
+            }
+        }
+    }
+
+    void VuRenderGraph::computeLifetimes() {
+        for (Resource& res: resources) {
+            res.firstUse = UINT32_MAX;
+            res.lastUse  = UINT32_MAX;
+        }
+
+        for (uint32 pos = 0U; pos < liveOrder.size(); pos++) {
+            const Pass& pass = passes[liveOrder[pos]];
+            for (const Use& use: pass.uses) {
+                Resource& res = resources[use.resource];
+                if (res.firstUse == UINT32_MAX) {
+                    if (!res.imported && !use.writes) {
+                        throw std::runtime_error("render graph: pass '" + pass.name + "' reads '" + res.name + "' before any pass writes it!");
+                    }
+                    res.firstUse = pos;
+                }
+                res.lastUse = pos;
+            }
+        }
+    }
+
+    void VuRenderGraph::allocateTransients() {
+        std::vector<uint32> transients;
+        for (uint32 i = 0U; i < resources.size(); i++) {
+            Resource& res = resources[i];
+            if (res.imported || res.firstUse == UINT32_MAX) {
+                continue;
+            }
+
+            VkImageCreateInfo imageInfo = fillImageCreateInfo(res.desc.format, res.usage, {res.desc.extent.width, res.desc.extent.height, 1U});
+            imageInfo.mipLevels         = res.desc.mipLevels;
+            imageInfo.initialLayout     = VK_IMAGE_LAYOUT_UNDEFINED;
+            imageInfo.sharingMode       = VK_SHARING_MODE_EXCLUSIVE;
+            VkCheck(vkCreateImage(ctx::vuDevice->device, &imageInfo, nullptr, &res.image));
+            vkGetImageMemoryRequirements(ctx::vuDevice->device, res.image, &res.requirements);
+            transients.push_back(i);
+        }
+
+        //biggest first, smaller images then fill the slots the big ones leave idle
+        std::stable_sort(transients.begin(), transients.end(), [this](uint32 a, uint32 b) {
+            return resources[a].requirements.size > resources[b].requirements.size;
+        });
+
+        for (uint32 index: transients) {
+            Resource&                   res          = resources[index];
+            const VkMemoryRequirements& requirements = res.requirements;
+
+            if (!arenaReady) {
+                arena.init(createInfo.transientBudget, requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+                arenaReady = true;
+            }
+            if (!arena.isCompatible(requirements)) {
+                throw std::runtime_error("render graph: transient '" + res.name + "' can not live in the transient memory type!");
+            }
+
+            for (uint32 s = 0U; s < slots.size() && res.slot == UINT32_MAX; s++) {
+                const MemorySlot&  slot = slots[s];
+                const VkDeviceSize end  = VuMemoryArena::alignedOffset(slot.range, requirements.alignment) + requirements.size;
+                if (end > slot.range.offset + slot.range.size) {
+                    continue;
+                }
+                const bool overlaps = std::any_of(slot.resources.begin(), slot.resources.end(), [&](uint32 other) {
+                    return resources[other].firstUse <= res.lastUse && res.firstUse <= resources[other].lastUse;
+                });
+                if (!overlaps) {
+                    res.slot = s;
+                }
+            }
+
+            if (res.slot == UINT32_MAX) {
+                MemorySlot slot{};
+                if (!arena.allocate(requirements, slot.range)) {
+                    throw std::runtime_error("render graph: transient budget exceeded, raise VuRenderGraphCreateInfo::transientBudget!");
+                }
+                slots.push_back(slot);
+                res.slot = static_cast<uint32>(slots.size() - 1U);
+            }
+            slots[res.slot].resources.push_back(index);
+
+            const VkDeviceSize offset = VuMemoryArena::alignedOffset(slots[res.slot].range, requirements.alignment);
+            VkCheck(vkBindImageMemory(ctx::vuDevice->device, res.image, arena.memory, offset));
+
+            //views of depth stencil formats only see depth, same as VuDepthStencil
+            const VkImageAspectFlags viewAspect = (res.aspect & VK_IMAGE_ASPECT_DEPTH_BIT) != 0U ? VK_IMAGE_ASPECT_DEPTH_BIT : res.aspect;
+            VuImage::createImageView(res.desc.format, res.image, viewAspect, res.view, res.desc.mipLevels);
+        }
+
+        //occupants in execution order, so the previous one of a slot is the one that must finish first
+        for (MemorySlot& slot: slots) {
+            std::sort(slot.resources.begin(), slot.resources.end(), [this](uint32 a, uint32 b) {
+                return resources[a].firstUse < resources[b].firstUse;
+            });
+        }
+    }
+
+    void VuRenderGraph::releaseTransients() {
+        for (Resource& res: resources) {
+            if (res.imported || res.image == VK_NULL_HANDLE) {
+                continue;
+            }
+            vkDestroyImageView(ctx::vuDevice->device, res.view, nullptr);
+            vkDestroyImage(ctx::vuDevice->device, res.image, nullptr);
+            res.view  = VK_NULL_HANDLE;
+            res.image = VK_NULL_HANDLE;
+            res.slot  = UINT32_MAX;
+        }
+        for (const MemorySlot& slot: slots) {
+            arena.free(slot.range);
+        }
+        slots.clear();
+    }
+
+    //BARRIERS//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    VuRenderGraph::TrackedState VuRenderGraph::startState(uint32 resource, const std::vector<TrackedState>& endStates) const {
+        const Resource& res = resources[resource];
+        if (res.imported) {
+            return {res.initialState.layout, res.initialState.stages, res.initialState.access, VK_PIPELINE_STAGE_2_NONE_KHR, VK_ACCESS_2_NONE_KHR};
+        }
+
+        TrackedState state{VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_2_NONE_KHR, VK_ACCESS_2_NONE_KHR, VK_PIPELINE_STAGE_2_NONE_KHR, VK_ACCESS_2_NONE_KHR};
+        if (endStates.empty()) {
+            return state;
+        }
+
+        //contents are never kept, but the memory is still in use by the previous occupant,
+        //or by this image itself in the previous frame when it is the first one in its slot
+        const std::vector<uint32>& occupants = slots[res.slot].resources;
+        const auto                 it        = std::find(occupants.begin(), occupants.end(), resource);
+        const uint32               previous  = it == occupants.begin() ? occupants.back() : *std::prev(it);
+        const TrackedState&        prevState = endStates[previous];
+        state.writeStages = prevState.writeStages | prevState.readStages;
+        state.writeAccess = prevState.writeAccess;
+        return state;
+    }
+
+    void VuRenderGraph::buildBarriers(const std::vector<TrackedState>& endStates, std::vector<TrackedState>& outEndStates) {
+        batches.assign(liveOrder.size(), {});
+        finalBatch = {};
+
+        std::vector<TrackedState> states(resources.size());
+        std::vector<bool>         started(resources.size(), false);
+
+        for (uint32 pos = 0U; pos < liveOrder.size(); pos++) {
+            BarrierBatch& batch = batches[pos];
+            for (const Use& use: passes[liveOrder[pos]].uses) {
+                TrackedState& state = states[use.resource];
+                if (!started[use.resource]) {
+                    state                 = startState(use.resource, endStates);
+                    started[use.resource] = true;
+                }
+
+                const bool layoutChange = resources[use.resource].isImage && state.layout != use.layout;
+                if (use.writes || layoutChange) {
+                    //write after write/read, or a layout transition which is a write as well
+                    const VkPipelineStageFlags2KHR srcStages = state.writeStages | state.readStages;
+                    if (srcStages != VK_PIPELINE_STAGE_2_NONE_KHR || layoutChange) {
+                        addBarrier(batch, use.resource, state, srcStages, state.writeAccess, use.stages, use.access, use.layout);
+                    }
+                    state.layout      = use.layout;
+                    state.writeStages = use.stages;
+                    state.writeAccess = use.writes ? (use.access & WRITE_ACCESS) : VK_ACCESS_2_NONE_KHR;
+                    state.readStages  = use.writes ? VK_PIPELINE_STAGE_2_NONE_KHR : use.stages;
+                    state.readAccess  = use.writes ? VK_ACCESS_2_NONE_KHR : use.access;
+                    continue;
+                }
+
+                //read after write, skipped when an earlier barrier already made the write visible to these stages
+                const bool unseen = (use.stages & ~state.readStages) != 0U || (use.access & ~state.readAccess) != 0U;
+                if (state.writeStages != VK_PIPELINE_STAGE_2_NONE_KHR && unseen) {
+                    addBarrier(batch, use.resource, state, state.writeStages, state.writeAccess, use.stages, use.access, state.layout);
+                }
+                state.readStages |= use.stages;
+                state.readAccess |= use.access;
+            }
+        }
+
+        //imported resources are handed back in the state the importer asked for
+        for (uint32 i = 0U; i < resources.size(); i++) {
+            const Resource& res = resources[i];
+            if (!res.imported) {
+                continue;
+            }
+            TrackedState& state = states[i];
+            if (!started[i]) {
+                state      = startState(i, endStates);
+                started[i] = true;
+            }
+
+            const VuRGResourceState& finalState = res.finalState;
+            if (finalState.layout == VK_IMAGE_LAYOUT_UNDEFINED && finalState.stages == VK_PIPELINE_STAGE_2_NONE_KHR) {
+                continue;
+            }
+            const VkImageLayout            newLayout    = finalState.layout == VK_IMAGE_LAYOUT_UNDEFINED ? state.layout : finalState.layout;
+            const bool                     layoutChange = res.isImage && newLayout != state.layout;
+            const VkPipelineStageFlags2KHR srcStages    = state.writeStages | state.readStages;
+            if (layoutChange || (finalState.stages != VK_PIPELINE_STAGE_2_NONE_KHR && srcStages != VK_PIPELINE_STAGE_2_NONE_KHR)) {
+                addBarrier(finalBatch, i, state, srcStages, state.writeAccess, finalState.stages, finalState.access, newLayout);
+            }
+        }
+
+        outEndStates = std::move(states);
+    }
+
+    void VuRenderGraph::addBarrier(BarrierBatch&            batch,
+                                   uint32                   resource,
+                                   const TrackedState&      state,
+                                   VkPipelineStageFlags2KHR srcStages,
+                                   VkAccessFlags2KHR        srcAccess,
+                                   VkPipelineStageFlags2KHR dstStages,
+                                   VkAccessFlags2KHR        dstAccess,
+                                   VkImageLayout            newLayout) const {
+        const Resource& res = resources[resource];
+        if (res.isImage) {
+            VkImageMemoryBarrier2KHR barrier = VuSync::ImageMemoryBarrier2();
+            barrier.srcStageMask             = srcStages;
+            barrier.srcAccessMask            = srcAccess;
+            barrier.dstStageMask             = dstStages;
+            barrier.dstAccessMask            = dstAccess;
+            barrier.oldLayout                = state.layout;
+            barrier.newLayout                = newLayout;
+            barrier.subresourceRange         = {res.aspect, 0U, VK_REMAINING_MIP_LEVELS, 0U, VK_REMAINING_ARRAY_LAYERS};
+            batch.imageBarriers.push_back(barrier);
+            batch.imageResources.push_back(resource);
+        } else {
+            VkBufferMemoryBarrier2KHR barrier = VuSync::BufferMemoryBarrier2();
+            barrier.srcStageMask              = srcStages;
+            barrier.srcAccessMask             = srcAccess;
+            barrier.dstStageMask              = dstStages;
+            barrier.dstAccessMask             = dstAccess;
+            barrier.offset                    = 0U;
+            barrier.size                      = res.size;
+            batch.bufferBarriers.push_back(barrier);
+            batch.bufferResources.push_back(resource);
+        }
+    }
+
+    //RECORD////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    void VuRenderGraph::setImportedImage(VuRGImage image, VkImage vkImage, VkImageView view) {
+        Resource& res = resources[image.index];
+        if (!res.imported || !res.isImage) {
+            throw std::runtime_error("render graph: '" + res.name + "' is not an imported image!");
+        }
+        res.image = vkImage;
+        res.view  = view;
+    }
+
+    void VuRenderGraph::setImportedBuffer(VuRGBuffer buffer, VkBuffer vkBuffer) {
+        Resource& res = resources[buffer.index];
+        if (!res.imported || res.isImage) {
+            throw std::runtime_error("render graph: '" + res.name + "' is not an imported buffer!");
+        }
+        res.buffer = vkBuffer;
+    }
+
+    void VuRenderGraph::recordBatch(VkCommandBuffer commandBuffer, BarrierBatch& batch) {
+        //handles are patched at record time since imported ones may change every frame
+        for (size_t i = 0U; i < batch.imageBarriers.size(); i++) {
+            batch.imageBarriers[i].image = resources[batch.imageResources[i]].image;
+        }
+        for (size_t i = 0U; i < batch.bufferBarriers.size(); i++) {
+            batch.bufferBarriers[i].buffer = resources[batch.bufferResources[i]].buffer;
+        }
+        VuSync::PipelineBarrier2(commandBuffer, batch.imageBarriers, batch.bufferBarriers);
+    }
+
+    void VuRenderGraph::recordRange(VkCommandBuffer commandBuffer, uint32 begin, uint32 end) {
+        if (!compiled) {
+            throw std::runtime_error("render graph: record called before compile!");
+        }
+        for (uint32 pos = begin; pos < end; pos++) {
+            recordBatch(commandBuffer, batches[pos]);
+            const Pass& pass = passes[liveOrder[pos]];
+            if (pass.execute) {
+                if (profiler != nullptr) {
+                    profiler->beginScope(commandBuffer, pass.name);
+                }
+                pass.execute(commandBuffer);
+                if (profiler != nullptr) {
+                    profiler->endScope(commandBuffer);
+                }
+            }
+        }
+    }
+
+    void VuRenderGraph::setProfiler(VuGpuProfiler* gpuProfiler) {
+        profiler = gpuProfiler;
+    }
+
+    void VuRenderGraph::record(VkCommandBuffer commandBuffer) {
+        recordRange(commandBuffer, 0U, static_cast<uint32>(liveOrder.size()));
+        recordBatch(commandBuffer, finalBatch);
+    }
+
+    void VuRenderGraph::recordUntil(VkCommandBuffer commandBuffer, VuRGPass pass) {
+        const uint32 pos = livePosition(pass);
+        recordRange(commandBuffer, 0U, pos);
+        recordBatch(commandBuffer, batches[pos]);
+    }
+
+    void VuRenderGraph::recordAfter(VkCommandBuffer commandBuffer, VuRGPass pass) {
+        const uint32 pos = livePosition(pass);
+        recordRange(commandBuffer, pos + 1U, static_cast<uint32>(liveOrder.size()));
+        recordBatch(commandBuffer, finalBatch);
+    }
+
+    uint32 VuRenderGraph::livePosition(VuRGPass pass) const {
+        const auto it = std::find(liveOrder.begin(), liveOrder.end(), pass.index);
+        if (it == liveOrder.end()) {
+            throw std::runtime_error("render graph: pass '" + passes[pass.index].name + "' was culled!");
+        }
+        return static_cast<uint32>(it - liveOrder.begin());
+    }
+
+    //QUERIES///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    VkImage VuRenderGraph::getImage(VuRGImage image) const {
+        return resources[image.index].image;
+    }
+
+    VkImageView VuRenderGraph::getImageView(VuRGImage image) const {
+        return resources[image.index].view;
+    }
+
+    VkBuffer VuRenderGraph::getBuffer(VuRGBuffer buffer) const {
+        return resources[buffer.index].buffer;
+    }
+
+    bool VuRenderGraph::isPassLive(VuRGPass pass) const {
+        return passes[pass.index].live;
+    }
+
+    VuRenderGraphStats VuRenderGraph::getStats() const {
+        VuRenderGraphStats stats{};
+        stats.passCount     = static_cast<uint32>(passes.size());
+        stats.livePassCount = static_cast<uint32>(liveOrder.size());
+
+        auto countBatch = [&stats](const BarrierBatch& batch) {
+            if (!batch.imageBarriers.empty() || !batch.bufferBarriers.empty()) {
+                stats.barrierBatchCount++;
+            }
+            stats.imageBarrierCount += static_cast<uint32>(batch.imageBarriers.size());
+            stats.bufferBarrierCount += static_cast<uint32>(batch.bufferBarriers.size());
+        };
+        for (const BarrierBatch& batch: batches) {
+            countBatch(batch);
+        }
+        countBatch(finalBatch);
+
+        for (const Resource& res: resources) {
+            if (!res.imported && res.image != VK_NULL_HANDLE) {
+                stats.transientImageCount++;
+                stats.transientRequestedBytes += res.requirements.size;
+            }
+        }
+        for (const MemorySlot& slot: slots) {
+            stats.transientBytes += slot.range.size;
+        }
+        return stats;
+    }
+
+    bool VuRenderGraph::hasDepth(VkFormat format) {
+        switch (format) {
+            case VK_FORMAT_D16_UNORM:
+            case VK_FORMAT_X8_D24_UNORM_PACK32:
+            case VK_FORMAT_D32_SFLOAT:
+            case VK_FORMAT_D16_UNORM_S8_UINT:
+            case VK_FORMAT_D24_UNORM_S8_UINT:
+            case VK_FORMAT_D32_SFLOAT_S8_UINT:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    bool VuRenderGraph::hasStencil(VkFormat format) {
+        switch (format) {
+            case VK_FORMAT_S8_UINT:
+            case VK_FORMAT_D16_UNORM_S8_UINT:
+            case VK_FORMAT_D24_UNORM_S8_UINT:
+            case VK_FORMAT_D32_SFLOAT_S8_UINT:
+                return true;
+            default:
+                return false;
+        }
+    }
+}
@@ -0,0 +1,282 @@
+#pragma once
+
+#include <functional>
+#include <string>
+
+#include "Common.h"
+#include "VuMemoryArena.h"
+#include "VuSync.h"
+
+namespace Vu {
+
+    //how a pass touches a resource, every value maps to fixed stages, access and image layout
+    enum class VuRGAccess : uint8 {
+        ColorAttachmentWrite,
+        DepthAttachmentWrite,
+        DepthAttachmentRead,
+        SampledRead,
+        StorageRead,
+        StorageWrite,
+        TransferRead,
+        TransferWrite,
+        IndirectRead,
+    };
+
+    //stages/access/layout a resource is in when the graph starts, or has to be left in when it ends
+    struct VuRGResourceState {
+        VkPipelineStageFlags2KHR stages = VK_PIPELINE_STAGE_2_NONE_KHR;
+        VkAccessFlags2KHR        access = VK_ACCESS_2_NONE_KHR;
+        VkImageLayout            layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    };
+
+    struct VuRGImage {
+        uint32 index = UINT32_MAX;
+    };
+
+    struct VuRGBuffer {
+        uint32 index = UINT32_MAX;
+    };
+
+    struct VuRGPass {
+        uint32 index = UINT32_MAX;
+    };
+
+    struct VuRGImageDesc {
+        VkExtent2D extent;
+        VkFormat   format;
+        uint32     mipLevels = 1U;
+    };
+
+    struct VuRGImportedImageInfo {
+        VkImage           image = VK_NULL_HANDLE;
+        VkImageView       view  = VK_NULL_HANDLE;
+        VuRGImageDesc     desc{};
+        VuRGResourceState initialState{};
+        //layout undefined means the graph leaves the image wherever its last pass put it
+        VuRGResourceState finalState{};
+        //outputs keep the passes writing them alive
+        bool output = true;
+    };
+
+    struct VuRGImportedBufferInfo {
+        VkBuffer          buffer = VK_NULL_HANDLE;
+        VkDeviceSize      size   = VK_WHOLE_SIZE;
+        VuRGResourceState initialState{};
+        VuRGResourceState finalState{};
+        bool              output = true;
+    };
+
+    struct VuRenderGraphCreateInfo {
+        //device local block every transient image is placed into, aliased images share ranges of it
+        VkDeviceSize transientBudget = 128U * 1024U * 1024U;
+    };
+
+    struct VuRenderGraphStats {
+        uint32       passCount;
+        uint32       livePassCount;
+        uint32       barrierBatchCount;
+        uint32       imageBarrierCount;
+        uint32       bufferBarrierCount;
+        uint32       transientImageCount;
+        VkDeviceSize transientBytes;
+        //what the transients would take without aliasing
+        VkDeviceSize transientRequestedBytes;
+    };
+
+    struct VuRenderGraph;
+    struct VuGpuProfiler;
+
+    //handed to the setup callback of addPass to declare what the pass reads and writes
+    struct VuRGPassBuilder {
+    public:
+        VuRGImage read(VuRGImage image, VuRGAccess access);
+
+        VuRGImage write(VuRGImage image, VuRGAccess access);
+
+        VuRGBuffer read(VuRGBuffer buffer, VuRGAccess access);
+
+        VuRGBuffer write(VuRGBuffer buffer, VuRGAccess access);
+
+        //the pass is never culled, e.g. it writes something the graph does not know about
+        void hasSideEffects();
+
+    private:
+        friend struct VuRenderGraph;
+
+        VuRGPassBuilder(VuRenderGraph& graph, uint32 passIndex) : graph(graph), passIndex(passIndex) {
+        }
+
+        VuRenderGraph& graph;
+        uint32         passIndex;
+    };
+
+    //passes declare their resources, compile() culls what does not reach an output, allocates and aliases the
+    //transient images and precomputes one sync2 barrier batch per pass. passes run in declaration order,
+    //which is already a valid topological order since a read always resolves to an earlier writer.
+    //the compiled graph is recorded every frame, only imported handles may change in between
+    struct VuRenderGraph {
+    public:
+        using ExecuteFunc = std::function<void(VkCommandBuffer)>;
+
+        void init(const VuRenderGraphCreateInfo& info);
+
+        void uninit();
+
+        //drops every pass and resource, the transient memory block is kept for the next build
+        void reset();
+
+        VuRGImage importImage(const std::string& name, const VuRGImportedImageInfo& info);
+
+        VuRGBuffer importBuffer(const std::string& name, const VuRGImportedBufferInfo& info);
+
+        VuRGImage createImage(const std::string& name, const VuRGImageDesc& desc);
+
+        VuRGPass addPass(const std::string& name, const std::function<void(VuRGPassBuilder&)>& setup, ExecuteFunc execute = {});
+
+        void compile();
+
+        //times every executed pass under its name, null turns it off
+        void setProfiler(VuGpuProfiler* gpuProfiler);
+
+        //imported handles can change per frame (swapchain images), layouts and usage must stay the same
+        void setImportedImage(VuRGImage image, VkImage vkImage, VkImageView view);
+
+        void setImportedBuffer(VuRGBuffer buffer, VkBuffer vkBuffer);
+
+        //all live passes and the final transitions
+        void record(VkCommandBuffer commandBuffer);
+
+        //the live passes before `pass` and the barriers of `pass`, the caller records the body of `pass` itself
+        void recordUntil(VkCommandBuffer commandBuffer, VuRGPass pass);
+
+        //the live passes after `pass` and the final transitions
+        void recordAfter(VkCommandBuffer commandBuffer, VuRGPass pass);
+
+        VkImage getImage(VuRGImage image) const;
+
+        VkImageView getImageView(VuRGImage image) const;
+
+        VkBuffer getBuffer(VuRGBuffer buffer) const;
+
+        bool isPassLive(VuRGPass pass) const;
+
+        VuRenderGraphStats getStats() const;
+
+    private:
+        friend struct VuRGPassBuilder;
+
+        struct Use {
+            uint32                   resource;
+            VkPipelineStageFlags2KHR stages;
+            VkAccessFlags2KHR        access;
+            VkImageLayout            layout;
+            VkImageUsageFlags        imageUsage;
+            bool                     reads;
+            bool                     writes;
+        };
+
+        struct Pass {
+            std::string      name;
+            std::vector<Use> uses;
+            ExecuteFunc      execute;
+            bool             sideEffects = false;
+            bool             live        = false;
+        };
+
+        struct Resource {
+            std::string name;
+            bool        isImage;
+            bool        imported;
+            bool        output;
+
+            VuRGImageDesc      desc{};
+            VkImageAspectFlags aspect = 0U;
+            VkImageUsageFlags  usage  = 0U;
+            VkImage            image  = VK_NULL_HANDLE;
+            VkImageView        view   = VK_NULL_HANDLE;
+            VkBuffer           buffer = VK_NULL_HANDLE;
+            VkDeviceSize       size   = VK_WHOLE_SIZE;
+
+            VuRGResourceState initialState{};
+            VuRGResourceState finalState{};
+
+            //first and last position in liveOrder, UINT32_MAX while unused
+            uint32 firstUse = UINT32_MAX;
+            uint32 lastUse  = UINT32_MAX;
+            //transients only
+            uint32               slot = UINT32_MAX;
+            VkMemoryRequirements requirements{};
+        };
+
+        //a range of the transient block, the images placed in it never live at the same time
+        struct MemorySlot {
+            VuMemoryRange       range;
+            std::vector<uint32> resources;
+        };
+
+        //the state a resource is left in by the previous use
+        struct TrackedState {
+            VkImageLayout            layout;
+            VkPipelineStageFlags2KHR writeStages;
+            VkAccessFlags2KHR        writeAccess;
+            //readers since the last write, they already see it
+            VkPipelineStageFlags2KHR readStages;
+            VkAccessFlags2KHR        readAccess;
+        };
+
+        struct BarrierBatch {
+            std::vector<VkImageMemoryBarrier2KHR>  imageBarriers;
+            std::vector<uint32>                    imageResources;
+            std::vector<VkBufferMemoryBarrier2KHR> bufferBarriers;
+            std::vector<uint32>                    bufferResources;
+        };
+
+        VuRenderGraphCreateInfo createInfo{};
+        VuMemoryArena           arena{};
+        bool                    arenaReady = false;
+        bool                    compiled   = false;
+        VuGpuProfiler*          profiler   = nullptr;
+
+        std::vector<Pass>       passes;
+        std::vector<Resource>   resources;
+        std::vector<MemorySlot> slots;
+
+        std::vector<uint32>       liveOrder;
+        std::vector<BarrierBatch> batches;
+        BarrierBatch              finalBatch;
+
+        void addUse(uint32 passIndex, uint32 resource, VuRGAccess access, bool writes);
+
+        void cullPasses();
+
+        void computeLifetimes();
+
+        void allocateTransients();
+
+        void releaseTransients();
+
+        //runs the whole graph once with the given start states and collects the barriers on the way
+        void buildBarriers(const std::vector<TrackedState>& endStates, std::vector<TrackedState>& outEndStates);
+
+        TrackedState startState(uint32 resource, const std::vector<TrackedState>& endStates) const;
+
+        void addBarrier(BarrierBatch&            batch,
+                        uint32                   resource,
+                        const TrackedState&      state,
+                        VkPipelineStageFlags2KHR srcStages,
+                        VkAccessFlags2KHR        srcAccess,
+                        VkPipelineStageFlags2KHR dstStages,
+                        VkAccessFlags2KHR        dstAccess,
+                        VkImageLayout            newLayout) const;
+
+        void recordBatch(VkCommandBuffer commandBuffer, BarrierBatch& batch);
+
+        void recordRange(VkCommandBuffer commandBuffer, uint32 begin, uint32 end);
+
+        uint32 livePosition(VuRGPass pass) const;
+
+        static bool hasDepth(VkFormat format);
+
+        static bool hasStencil(VkFormat format);
+    };
+}
@@ -6,9 +6,11 @@
 
 
 namespace Vu {
-    void VuRenderer::init(std::vector<char>&         pipelineCacheBinary,
+    void VuRenderer::init(std::span<const uint8>     pipelineCacheBinary,
                           VkPhysicalDeviceFeatures2& physicalDeviceFeatures2WithChain,
-                          VkPipelineCacheCreateInfo& pipelineCacheCreateInfo) {
+                          VkPipelineCacheCreateInfo& pipelineCacheCreateInfo,
+                          const VuRenderBackendInfo& backend) {
+        backendInfo = backend;
         initVulkanInstance();
         ctx::vuDevice->initPhysicalDevice();
         initSurface();
@@ -42,6 +44,13 @@ namespace Vu {
         initCommandBuffers();
         initSyncObjects();
 
+        gpuProfiler.init(backendInfo.gpuProfiler);
+        disposeStack.push([this] { gpuProfiler.uninit(); });
+        pipelineStatistics.init(backendInfo.pipelineStatistics, swapChain.swapChainExtent);
+        disposeStack.push([this] { pipelineStatistics.uninit(); });
+
+        initFrameGraph();
+
 
         //debug resources
         debugTexture0.createHandle()->init({std::filesystem::path("assets/textures/error.png"), VK_FORMAT_R8G8B8A8_UNORM});
@@ -52,31 +61,35 @@ namespace Vu {
         VuResourceManager::writeSampledImageToGlobalPool(debugTexture1.index, debugTexture1.get()->imageView);
         disposeStack.push([this] { auto noop = debugTexture1.destroyHandle(); });
 
-        debugSampler.createHandle()->init({});
-        VuResourceManager::writeSamplerToGlobalPool(debugSampler.index, debugSampler.get()->vkSampler);
-        disposeStack.push([this] { auto noop = debugSampler.destroyHandle(); });
+        defaultSampler = VuSamplerCache::getOrCreate({});
+        disposeStack.push([] { VuSamplerCache::uninit(); });
     }
 
 
     void VuRenderer::initVulkanInstance() {
-        ctx::vuDevice->initInstance(config::ENABLE_VALIDATION_LAYERS_LAYERS, config::VALIDATION_LAYERS, config::INSTANCE_EXTENSIONS);
+        ctx::vuDevice->initInstance(config::ENABLE_VALIDATION_LAYERS_LAYERS,
+                                    config::VALIDATION_LAYERS,
+                                    backendInfo.headless ? config::HEADLESS_INSTANCE_EXTENSIONS : config::INSTANCE_EXTENSIONS);
     }
 
-    void VuRenderer::initVulkanDevice(std::vector<char>& pipelineCacheBlob, VkPhysicalDeviceFeatures2& physicalDeviceFeaturesWithChain) {
+    void VuRenderer::initVulkanDevice(std::span<const uint8> pipelineCacheBlob, VkPhysicalDeviceFeatures2& physicalDeviceFeaturesWithChain) {
 
 
         ctx::vuDevice->initDevice({
             config::ENABLE_VALIDATION_LAYERS_LAYERS,
             physicalDeviceFeaturesWithChain,
             surface,
-            config::DEVICE_EXTENSIONS
+            backendInfo.headless ? config::HEADLESS_DEVICE_EXTENSIONS : config::DEVICE_EXTENSIONS
         });
 
 
     }
 
     void VuRenderer::initSurface() {
-
+        if (backendInfo.headless) {
+            surface = VK_NULL_HANDLE;
+            return;
+        }
 
         VkCheck(createDirectSurface(ctx::vuDevice->physicalDevice, ctx::vuDevice->instance, config::SCREEN_WIDTH, config::SCREEN_HEIGHT,
                                     surface));
@@ -84,7 +97,12 @@ namespace Vu {
 
     void VuRenderer::initSwapchain() {
         swapChain = VuSwapChain{};
-        swapChain.init(surface);
+        if (backendInfo.headless) {
+            swapChain.initHeadless(backendInfo.headlessExtent, config::HEADLESS_COLOR_FORMAT, backendInfo.headlessImageCount);
+            nextVsync = std::chrono::steady_clock::now();
+        } else {
+            swapChain.init(surface);
+        }
         disposeStack.push([&] { swapChain.uninit(); });
     }
 
@@ -116,12 +134,13 @@ namespace Vu {
             VkCheck(vkCreateFence(ctx::vuDevice->device, &fenceInfo, nullptr, &inFlightFences[i]));
         }
 
-        disposeStack.push([vr = *this] {
+        //copies of the handles, the renderer itself holds non copyable members
+        disposeStack.push([imageAvailable = imageAvailableSemaphores, renderFinished = renderFinishedSemaphores, fences = inFlightFences] {
             for (size_t i = 0; i < config::MAX_FRAMES_IN_FLIGHT; i++) {
 
-                vkDestroySemaphore(ctx::vuDevice->device, vr.imageAvailableSemaphores[i], nullptr);
-                vkDestroySemaphore(ctx::vuDevice->device, vr.renderFinishedSemaphores[i], nullptr);
-                vkDestroyFence(ctx::vuDevice->device, vr.inFlightFences[i], nullptr);
+                vkDestroySemaphore(ctx::vuDevice->device, imageAvailable[i], nullptr);
+                vkDestroySemaphore(ctx::vuDevice->device, renderFinished[i], nullptr);
+                vkDestroyFence(ctx::vuDevice->device, fences[i], nullptr);
             }
         });
 
@@ -144,26 +163,105 @@ namespace Vu {
             uniformBuffers[i].map();
         }
         for (size_t i = 0; i < config::MAX_FRAMES_IN_FLIGHT; i++) {
-            VuResourceManager::writeUBO_ToGlobalPool(0, i, uniformBuffers[i]);
+            VuResourceManager::writeFrameUBO(i, uniformBuffers[i]);
         }
 
 
-        disposeStack.push([vr = *this] {
+        disposeStack.push([buffers = uniformBuffers]() mutable {
             for (size_t i = 0; i < config::MAX_FRAMES_IN_FLIGHT; i++) {
-                auto v = vr.uniformBuffers;
-                v[i].uninit();
+                buffers[i].uninit();
             }
         });
     }
 
+    void VuRenderer::initFrameGraph() {
+        frameGraph.init({});
+        frameGraph.setProfiler(&gpuProfiler);
+        buildFrameGraph();
+        disposeStack.push([this] { frameGraph.uninit(); });
+    }
+
+    void VuRenderer::enableFrameReadback(const VuFrameReadbackCreateInfo& info) {
+        if (readbackEnabled) {
+            throw std::runtime_error("frame readback is already enabled!");
+        }
+        if ((swapChain.imageUsage & VK_IMAGE_USAGE_TRANSFER_SRC_BIT) == 0U) {
+            throw std::runtime_error("frame readback: the swapchain images can not be copied from!");
+        }
+
+        waitIdle();
+        frameReadback.init(info, swapChain.swapChainExtent, swapChain.swapChainImageFormat);
+        readbackEnabled = true;
+        disposeStack.push([this] { frameReadback.uninit(); });
+
+        frameGraph.reset();
+        buildFrameGraph();
+    }
+
+    void VuRenderer::buildFrameGraph() {
+        VuRGImportedImageInfo backbufferInfo{
+            .image = swapChain.swapChainImages[0],
+            .view = swapChain.swapChainImageViews[0],
+            .desc = {swapChain.swapChainExtent, swapChain.swapChainImageFormat},
+            //the acquire semaphore is waited at color output, the previous contents are not needed
+            .initialState = {VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT_KHR, VK_ACCESS_2_NONE_KHR, VK_IMAGE_LAYOUT_UNDEFINED},
+            .finalState = {VK_PIPELINE_STAGE_2_NONE_KHR, VK_ACCESS_2_NONE_KHR, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR},
+        };
+        if (backendInfo.headless) {
+            //no semaphore orders the ring images, the writes of the last frame that used the image have to finish.
+            //nothing presents them, the image stays in the layout of its last pass
+            backbufferInfo.initialState.access = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT_KHR;
+            backbufferInfo.finalState          = {};
+        }
+        backbufferImage = frameGraph.importImage("backbuffer", backbufferInfo);
+
+        depthImage = frameGraph.importImage("depth", {
+            .image = swapChain.depthStencil.image,
+            .view = swapChain.depthStencil.imageView,
+            .desc = {swapChain.swapChainExtent, swapChain.depthStencil.depthFormat},
+            //cleared every frame, only the depth writes of the previous frame have to be done
+            .initialState = {
+                VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT_KHR | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT_KHR,
+                VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT_KHR,
+                VK_IMAGE_LAYOUT_UNDEFINED
+            },
+            .output = false,
+        });
+
+        scenePass = frameGraph.addPass("scene", [this](VuRGPassBuilder& builder) {
+            builder.write(backbufferImage, VuRGAccess::ColorAttachmentWrite);
+            builder.write(depthImage, VuRGAccess::DepthAttachmentWrite);
+        });
+
+        if (readbackEnabled) {
+            //the host reads the buffer after the frame fence, the final barrier makes the copy visible to it
+            readbackBuffer = frameGraph.importBuffer("readback", {
+                .buffer = frameReadback.getBuffer(0),
+                .finalState = {VK_PIPELINE_STAGE_2_HOST_BIT_KHR, VK_ACCESS_2_HOST_READ_BIT_KHR, VK_IMAGE_LAYOUT_UNDEFINED},
+            });
+            frameGraph.addPass("readback",
+                               [this](VuRGPassBuilder& builder) {
+                                   builder.read(backbufferImage, VuRGAccess::TransferRead);
+                                   builder.write(readbackBuffer, VuRGAccess::TransferWrite);
+                               },
+                               [this](VkCommandBuffer commandBuffer) {
+                                   frameReadback.recordCopy(commandBuffer, frameGraph.getImage(backbufferImage), currentFrame, frameNumber);
+                               });
+        }
+
+        frameGraph.compile();
+    }
+
     void VuRenderer::bindGlobalBindlessSet(const VkCommandBuffer& commandBuffer) {
+        //set 0 is the shared bindless set, set 1 holds this frame's constants
+        std::array sets{ctx::vuDevice->globalDescriptorSet, ctx::vuDevice->frameDescriptorSets[currentFrame]};
         vkCmdBindDescriptorSets(
             commandBuffer,
             VK_PIPELINE_BIND_POINT_GRAPHICS,
             ctx::vuDevice->globalPipelineLayout,
             0,
-            1,
-            &ctx::vuDevice->globalDescriptorSets[currentFrame],
+            static_cast<uint32>(sets.size()),
+            sets.data(),
             0,
             nullptr
         );
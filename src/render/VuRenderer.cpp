@@ -1,10 +1,17 @@
 #include "VuRenderer.h"
 
+#include <thread>
+
 #include "VuConfig.h"
+#include "VuCpuProfiler.h"
 
 namespace Vu {
     bool VuRenderer::shouldWindowClose() {
-        return false;//ctx::sdlEvent.type == SDL_EVENT_QUIT;
+        return closeRequested;//ctx::sdlEvent.type == SDL_EVENT_QUIT;
+    }
+
+    void VuRenderer::requestClose() {
+        closeRequested = true;
     }
 
     void VuRenderer::waitIdle() {
@@ -12,11 +19,30 @@ namespace Vu {
     }
 
     void VuRenderer::beginFrame() {
+        VU_CPU_ZONE("beginFrame");
         //SDL_PollEvent(&ctx::sdlEvent);
         waitForFences();
-        VkResult result = vkAcquireNextImageKHR(
-            ctx::vuDevice->device, swapChain.swapChain, UINT64_MAX,
-            imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &currentFrameImageIndex);
+        //this frame's set is no longer used by the gpu, apply everything queued for it in one call
+        VuResourceManager::flushDescriptorWrites(currentFrame);
+        //the copy made MAX_FRAMES_IN_FLIGHT frames ago is complete now that its fence was waited
+        if (readbackEnabled) {
+            frameReadback.collect(currentFrame);
+        }
+
+        if (backendInfo.headless) {
+            currentFrameImageIndex = swapChain.acquireHeadlessImage();
+            vkResetFences(ctx::vuDevice->device, 1, &inFlightFences[currentFrame]);
+            vkResetCommandBuffer(commandBuffers[currentFrame], 0);
+            beginRecordCommandBuffer(commandBuffers[currentFrame], currentFrameImageIndex);
+            return;
+        }
+
+        VkResult result;
+        {
+            VU_CPU_ZONE("acquire");
+            result = vkAcquireNextImageKHR(ctx::vuDevice->device, swapChain.swapChain, UINT64_MAX,
+                                           imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &currentFrameImageIndex);
+        }
 
         if (result == VK_ERROR_OUT_OF_DATE_KHR) {
             //resetSwapChain();
@@ -31,14 +57,25 @@ namespace Vu {
     }
 
     void VuRenderer::waitForFences() {
+        VU_CPU_ZONE("fence wait");
         vkWaitForFences(ctx::vuDevice->device, 1, &inFlightFences[currentFrame], VK_TRUE, UINT64_MAX);
     }
 
     void VuRenderer::beginRecordCommandBuffer(const VkCommandBuffer& commandBuffer, uint32 imageIndex) {
+        VU_CPU_ZONE("record begin");
         VkCommandBufferBeginInfo beginInfo{};
         beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 
         VkCheck(vkBeginCommandBuffer(commandBuffer, &beginInfo));
+        gpuProfiler.beginFrame(commandBuffer, currentFrame);
+        pipelineStatistics.beginFrame(commandBuffer, currentFrame);
+        gpuProfiler.beginScope(commandBuffer, "frame");
+        frameGraph.setImportedImage(backbufferImage, swapChain.swapChainImages[imageIndex], swapChain.swapChainImageViews[imageIndex]);
+        if (readbackEnabled) {
+            frameGraph.setImportedBuffer(readbackBuffer, frameReadback.getBuffer(currentFrame));
+        }
+        frameGraph.recordUntil(commandBuffer, scenePass);
+        gpuProfiler.beginScope(commandBuffer, "scene");
         swapChain.beginRenderPass(commandBuffer, imageIndex);
 
         VkViewport viewport{};
@@ -58,7 +95,11 @@ namespace Vu {
     }
 
     void VuRenderer::endRecordCommandBuffer(const VkCommandBuffer& commandBuffer, uint32 imageIndex) {
+        VU_CPU_ZONE("record end");
         swapChain.endRenderPass(commandBuffer);
+        gpuProfiler.endScope(commandBuffer);
+        frameGraph.recordAfter(commandBuffer, scenePass);
+        gpuProfiler.endScope(commandBuffer);
         VkCheck(vkEndCommandBuffer(commandBuffer));
 
     }
@@ -66,17 +107,33 @@ namespace Vu {
     void VuRenderer::bindMesh(VuMesh& mesh) {
         //we are using vertex pulling, so only index buffers we need to bind
         auto commandBuffer = commandBuffers[currentFrame];
-        vkCmdBindIndexBuffer(commandBuffer, mesh.indexBuffer.get()->buffer, 0, VK_INDEX_TYPE_UINT32);
+        vkCmdBindIndexBuffer(commandBuffer, mesh.indexBuffer.get()->buffer, 0, mesh.indexType);
     }
 
-    void VuRenderer::bindMaterial(const VuMaterial& material) {
+    void VuRenderer::bindShader(const VuShader& shader) {
         auto commandBuffer = commandBuffers[currentFrame];
-        material.bindPipeline(commandBuffer);
+        shader.bindPipeline(commandBuffer);
     }
 
-    void VuRenderer::drawIndexed(uint32 indexCount) {
+    void VuRenderer::drawIndexed(uint32 indexCount, uint32 firstIndex, int32 vertexOffset) {
         auto commandBuffer = commandBuffers[currentFrame];
-        vkCmdDrawIndexed(commandBuffer, indexCount, 1, 0, 0, 0);
+        vkCmdDrawIndexed(commandBuffer, indexCount, 1, firstIndex, vertexOffset, 0);
+    }
+
+    void VuRenderer::beginGpuScope(const std::string& name) {
+        gpuProfiler.beginScope(commandBuffers[currentFrame], name);
+    }
+
+    void VuRenderer::endGpuScope() {
+        gpuProfiler.endScope(commandBuffers[currentFrame]);
+    }
+
+    void VuRenderer::beginDrawGroup(const std::string& name) {
+        pipelineStatistics.beginGroup(commandBuffers[currentFrame], name);
+    }
+
+    void VuRenderer::endDrawGroup() {
+        pipelineStatistics.endGroup(commandBuffers[currentFrame]);
     }
 
     void VuRenderer::pushConstants(const GPU_PushConstant& pushConstant) {
@@ -100,7 +157,13 @@ namespace Vu {
     // }
 
     void VuRenderer::endFrame() {
+        VU_CPU_ZONE("endFrame");
         endRecordCommandBuffer(commandBuffers[currentFrame], currentFrameImageIndex);
+        if (backendInfo.headless) {
+            submitHeadless();
+            return;
+        }
+
         VkSubmitInfo submitInfo{};
         submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
@@ -117,7 +180,10 @@ namespace Vu {
         submitInfo.signalSemaphoreCount = 1;
         submitInfo.pSignalSemaphores    = signalSemaphores;
 
-        VkCheck(vkQueueSubmit(ctx::vuDevice->graphicsQueue, 1, &submitInfo, inFlightFences[currentFrame]));
+        {
+            VU_CPU_ZONE("submit");
+            VkCheck(vkQueueSubmit(ctx::vuDevice->graphicsQueue, 1, &submitInfo, inFlightFences[currentFrame]));
+        }
 
         VkPresentInfoKHR presentInfo{};
         presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -131,7 +197,11 @@ namespace Vu {
 
         presentInfo.pImageIndices = &currentFrameImageIndex;
 
-        auto result = vkQueuePresentKHR(ctx::vuDevice->presentQueue, &presentInfo);
+        VkResult result;
+        {
+            VU_CPU_ZONE("present");
+            result = vkQueuePresentKHR(ctx::vuDevice->presentQueue, &presentInfo);
+        }
 
         if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
             //resetSwapChain();
@@ -139,9 +209,43 @@ namespace Vu {
             throw std::runtime_error("failed to present swap chain image!");
         }
         currentFrame = (currentFrame + 1) % config::MAX_FRAMES_IN_FLIGHT;
+        frameNumber++;
     }
 
 
+    void VuRenderer::submitHeadless() {
+        //nothing to acquire or present, the frame fence is the only synchronization with the host
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers    = &commandBuffers[currentFrame];
+        {
+            VU_CPU_ZONE("submit");
+            VkCheck(vkQueueSubmit(ctx::vuDevice->graphicsQueue, 1, &submitInfo, inFlightFences[currentFrame]));
+        }
+
+        if (backendInfo.pacing == VuFramePacing::SimulatedVsync) {
+            VU_CPU_ZONE("present");
+            waitSimulatedVsync();
+        }
+        currentFrame = (currentFrame + 1) % config::MAX_FRAMES_IN_FLIGHT;
+        frameNumber++;
+    }
+
+    void VuRenderer::waitSimulatedVsync() {
+        using namespace std::chrono;
+        const auto interval = duration_cast<steady_clock::duration>(duration<double>(backendInfo.vsyncIntervalSeconds));
+        const auto now      = steady_clock::now();
+
+        //a late frame misses its tick and waits for the next one, like a real fifo swapchain
+        nextVsync += interval;
+        if (nextVsync < now) {
+            const auto missed = (now - nextVsync) / interval + 1;
+            nextVsync += interval * missed;
+        }
+        std::this_thread::sleep_until(nextVsync);
+    }
+
     void VuRenderer::updateFrameConstantBuffer(GPU_FrameConst ubo) {
         uniformBuffers[currentFrame].setData(&ubo, sizeof(ubo));
     }
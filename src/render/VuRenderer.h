@@ -1,13 +1,19 @@
 #pragma once
 
+#include <chrono>
 #include <functional>
+#include <span>
 #include <stack>
 #include "Common.h"
 #include "VuMesh.h"
 #include "VuSwapChain.h"
 #include "VuBuffer.h"
-#include "VuMaterial.h"
-#include "VuSampler.h"
+#include "VuFrameReadback.h"
+#include "VuGpuProfiler.h"
+#include "VuShader.h"
+#include "VuPipelineStatistics.h"
+#include "VuRenderGraph.h"
+#include "VuSamplerCache.h"
 #include "VuTexture.h"
 #include "VuResourceManager.h"
 
@@ -15,6 +21,27 @@ namespace Vu {
     //constexpr uint32 WIDTH = 960;
     //constexpr uint32 HEIGHT = 540;
 
+    enum class VuFramePacing : uint8 {
+        //submit as fast as the gpu allows
+        Unthrottled,
+        //wait for the next tick of a fixed interval after every frame, like fifo presenting
+        SimulatedVsync,
+    };
+
+    struct VuRenderBackendInfo {
+        //render into a ring of offscreen images instead of a display swapchain, no surface is created
+        bool          headless             = false;
+        uint32        headlessImageCount   = 3U;
+        VkExtent2D    headlessExtent       = {config::SCREEN_WIDTH, config::SCREEN_HEIGHT};
+        //only used by headless, a display swapchain is paced by its present mode
+        VuFramePacing pacing               = VuFramePacing::Unthrottled;
+        double        vsyncIntervalSeconds = 1.0 / 60.0;
+        //timestamps around the frame, every graph pass and the scopes opened with beginGpuScope
+        VuGpuProfilerCreateInfo gpuProfiler{};
+        //vertex/clipping/fragment counts of the groups opened with beginDrawGroup, off by default
+        VuPipelineStatisticsCreateInfo pipelineStatistics{};
+    };
+
     struct VuRenderer {
     public:
         std::vector<VkCommandBuffer> commandBuffers;
@@ -25,27 +52,51 @@ namespace Vu {
 
         VkSurfaceKHR surface;
         VuSwapChain  swapChain;
+
+        //barriers and transient targets of every frame, the scene pass body is recorded between beginFrame and endFrame
+        VuRenderGraph frameGraph;
+        VuRGImage     backbufferImage;
+        VuRGImage     depthImage;
+        VuRGPass      scenePass;
+
+        VuFrameReadback frameReadback;
+        VuRGBuffer      readbackBuffer;
+        bool            readbackEnabled = false;
+
+        VuGpuProfiler        gpuProfiler;
+        VuPipelineStatistics pipelineStatistics;
         //ImGui_ImplVulkanH_Window imguiMainWindowData;
 
         uint32 currentFrame           = 0;
         uint32 currentFrameImageIndex = 0;
+        //frames submitted so far
+        uint64 frameNumber            = 0;
+        bool   closeRequested         = false;
+
+        VuRenderBackendInfo                   backendInfo{};
+        std::chrono::steady_clock::time_point nextVsync{};
 
         VuHandle<VuTexture> debugTexture0;
         VuHandle<VuTexture> debugTexture1;
-        VuHandle<VuSampler> debugSampler;
+        //bindless index of the default linear/repeat/anisotropic sampler, always slot 0
+        uint32              defaultSampler;
 
         std::stack<std::function<void()> > disposeStack;
 
         VkPipelineCache pipelineCache;
 
-        void init(std::vector<char>&         pipelineCache,
+        void init(std::span<const uint8>     pipelineCache,
                   VkPhysicalDeviceFeatures2& physicalDeviceFeatures2WithChain,
-                  VkPipelineCacheCreateInfo& pipelineCacheCreateInfo);
+                  VkPipelineCacheCreateInfo& pipelineCacheCreateInfo,
+                  const VuRenderBackendInfo& backend = {});
 
         void uninit();
 
         bool shouldWindowClose();
 
+        //makes shouldWindowClose return true, e.g. once a benchmark ran all its frames
+        void requestClose();
+
         void waitIdle();
 
         void beginFrame();
@@ -54,22 +105,39 @@ namespace Vu {
 
         void bindMesh(VuMesh& mesh);
 
-        void bindMaterial(const VuMaterial& material);
+        void bindShader(const VuShader& shader);
 
         void pushConstants(const GPU_PushConstant& pushConstant);
 
-        void drawIndexed(uint32 indexCount);
+        void drawIndexed(uint32 indexCount, uint32 firstIndex = 0U, int32 vertexOffset = 0);
 
         void updateFrameConstantBuffer(GPU_FrameConst ubo);
 
+        //copies every finished frame to the host, see VuFrameReadback. rebuilds the frame graph
+        void enableFrameReadback(const VuFrameReadbackCreateInfo& info);
+
+        //gpu timing of a range of draws between beginFrame and endFrame, scopes nest
+        void beginGpuScope(const std::string& name);
+
+        void endGpuScope();
+
+        //pipeline statistics of a range of draws inside the scene pass, groups with the same name are aggregated
+        void beginDrawGroup(const std::string& name);
+
+        void endDrawGroup();
+
     private:
         void waitForFences();
 
+        void submitHeadless();
+
+        void waitSimulatedVsync();
+
         void beginRecordCommandBuffer(const VkCommandBuffer& commandBuffer, uint32 imageIndex);
 
         void endRecordCommandBuffer(const VkCommandBuffer& commandBuffer, uint32 imageIndex);
 
-        void initVulkanDevice(std::vector<char>& pipelineCacheBlob, VkPhysicalDeviceFeatures2& physicalDeviceFeaturesWithChain);
+        void initVulkanDevice(std::span<const uint8> pipelineCacheBlob, VkPhysicalDeviceFeatures2& physicalDeviceFeaturesWithChain);
 
         void initVulkanInstance();
 
@@ -83,6 +151,10 @@ namespace Vu {
 
         void initUniformBuffers();
 
+        void initFrameGraph();
+
+        void buildFrameGraph();
+
         void bindGlobalBindlessSet(const VkCommandBuffer& commandBuffer);
 
     };
@@ -5,35 +5,85 @@
 
 namespace Vu {
 
+    //full description of a sampler, also the key of VuSamplerCache
     struct VuSamplerCreateInfo {
+        VkFilter             magFilter        = VK_FILTER_LINEAR;
+        VkFilter             minFilter        = VK_FILTER_LINEAR;
+        VkSamplerMipmapMode  mipmapMode       = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+        VkSamplerAddressMode addressModeU     = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        VkSamplerAddressMode addressModeV     = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        VkSamplerAddressMode addressModeW     = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        float                mipLodBias       = 0.0F;
+        float                minLod           = 0.0F;
+        float                maxLod           = VK_LOD_CLAMP_NONE;
+        VkBool32             anisotropyEnable = VK_TRUE;
+        //zero means the device limit
+        float                maxAnisotropy    = 0.0F;
+        VkBool32             compareEnable    = VK_FALSE;
+        VkCompareOp          compareOp        = VK_COMPARE_OP_ALWAYS;
+        VkBorderColor        borderColor      = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
 
+        bool operator==(const VuSamplerCreateInfo& other) const = default;
+
+        //fnv-1a over the fields one by one, padding bytes never take part
+        uint64 hash() const {
+            uint64 h       = 14695981039346656037ULL;
+            auto   combine = [&h](const auto& field) {
+                const auto* bytes = reinterpret_cast<const uint8 *>(&field);
+                for (size_t i = 0; i < sizeof(field); i++) {
+                    h ^= bytes[i];
+                    h *= 1099511628211ULL;
+                }
+            };
+            combine(magFilter);
+            combine(minFilter);
+            combine(mipmapMode);
+            combine(addressModeU);
+            combine(addressModeV);
+            combine(addressModeW);
+            combine(mipLodBias);
+            combine(minLod);
+            combine(maxLod);
+            combine(anisotropyEnable);
+            combine(maxAnisotropy);
+            combine(compareEnable);
+            combine(compareOp);
+            combine(borderColor);
+            return h;
+        }
+    };
+
+    struct VuSamplerCreateInfoHash {
+        size_t operator()(const VuSamplerCreateInfo& info) const {
+            return static_cast<size_t>(info.hash());
+        }
     };
 
     struct VuSampler {
         VkSampler vkSampler;
 
-        void init(VuSamplerCreateInfo createInfo) {
-
-            VkPhysicalDeviceProperties properties{};
-            vkGetPhysicalDeviceProperties(ctx::vuDevice->physicalDevice, &properties);
+        void init(const VuSamplerCreateInfo& createInfo) {
+            const float deviceMaxAnisotropy = ctx::vuDevice->physicalDeviceProperties.limits.maxSamplerAnisotropy;
 
             VkSamplerCreateInfo samplerInfo{};
             samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-            samplerInfo.magFilter = VK_FILTER_LINEAR;
-            samplerInfo.minFilter = VK_FILTER_LINEAR;
-            samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-            samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-            samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-            samplerInfo.anisotropyEnable = VK_TRUE;
-            samplerInfo.maxAnisotropy = properties.limits.maxSamplerAnisotropy;
-            samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+            samplerInfo.magFilter = createInfo.magFilter;
+            samplerInfo.minFilter = createInfo.minFilter;
+            samplerInfo.addressModeU = createInfo.addressModeU;
+            samplerInfo.addressModeV = createInfo.addressModeV;
+            samplerInfo.addressModeW = createInfo.addressModeW;
+            samplerInfo.anisotropyEnable = createInfo.anisotropyEnable;
+            samplerInfo.maxAnisotropy = createInfo.maxAnisotropy > 0.0F
+                                            ? std::min(createInfo.maxAnisotropy, deviceMaxAnisotropy)
+                                            : deviceMaxAnisotropy;
+            samplerInfo.borderColor = createInfo.borderColor;
             samplerInfo.unnormalizedCoordinates = VK_FALSE;
-            samplerInfo.compareEnable = VK_FALSE;
-            samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
-            samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-            samplerInfo.mipLodBias = 0.0f;
-            samplerInfo.minLod = 0.0f;
-            samplerInfo.maxLod = 0.0f;
+            samplerInfo.compareEnable = createInfo.compareEnable;
+            samplerInfo.compareOp = createInfo.compareOp;
+            samplerInfo.mipmapMode = createInfo.mipmapMode;
+            samplerInfo.mipLodBias = createInfo.mipLodBias;
+            samplerInfo.minLod = createInfo.minLod;
+            samplerInfo.maxLod = createInfo.maxLod;
 
             VkCheck(vkCreateSampler(ctx::vuDevice->device, &samplerInfo, nullptr, &vkSampler));
         }
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <unordered_map>
+
+#include "Common.h"
+#include "VuConfig.h"
+#include "VuResourceManager.h"
+#include "VuSampler.h"
+
+namespace Vu {
+
+    //one sampler per distinct description. the returned index is the pool slot and the bindless slot in the sampler binding,
+    //it stays valid until uninit(), so materials can store it directly
+    struct VuSamplerCache {
+    private:
+        inline static std::unordered_map<VuSamplerCreateInfo, VuHandle<VuSampler>, VuSamplerCreateInfoHash> samplers;
+
+    public:
+        static uint32 getOrCreate(const VuSamplerCreateInfo& info) {
+            const VuSamplerCreateInfo key = normalize(info);
+
+            if (auto it = samplers.find(key); it != samplers.end()) {
+                return it->second.index;
+            }
+
+            if (samplers.size() >= config::MAX_SAMPLER_COUNT) {
+                throw std::runtime_error("sampler cache is full, raise config::MAX_SAMPLER_COUNT!");
+            }
+
+            VuHandle<VuSampler> handle;
+            handle.createHandle()->init(key);
+            VuResourceManager::writeSamplerToGlobalPool(handle.index, handle.get()->vkSampler);
+            samplers.emplace(key, handle);
+            return handle.index;
+        }
+
+        static uint32 getSamplerCount() {
+            return static_cast<uint32>(samplers.size());
+        }
+
+        static void uninit() {
+            for (auto& [key, handle]: samplers) {
+                auto noop = handle.destroyHandle();
+            }
+            samplers.clear();
+        }
+
+    private:
+        //descriptions that end up as the same VkSampler must also hash the same
+        static VuSamplerCreateInfo normalize(const VuSamplerCreateInfo& info) {
+            VuSamplerCreateInfo result = info;
+
+            const float deviceMaxAnisotropy = ctx::vuDevice->physicalDeviceProperties.limits.maxSamplerAnisotropy;
+            if (result.anisotropyEnable == VK_FALSE) {
+                result.maxAnisotropy = 0.0F;
+            } else if (result.maxAnisotropy <= 0.0F || result.maxAnisotropy > deviceMaxAnisotropy) {
+                result.maxAnisotropy = deviceMaxAnisotropy;
+            }
+            if (result.compareEnable == VK_FALSE) {
+                result.compareOp = VK_COMPARE_OP_ALWAYS;
+            }
+
+            //-0.0 == 0.0 but their bytes differ
+            result.mipLodBias += 0.0F;
+            result.minLod += 0.0F;
+            result.maxLod += 0.0F;
+            return result;
+        }
+    };
+}
@@ -12,10 +12,31 @@ namespace Vu {
         createFramebuffers();
     }
 
+    void VuSwapChain::initHeadless(VkExtent2D extent, VkFormat format, uint32 ringSize) {
+        headless = true;
+        createHeadlessImages(extent, format, ringSize);
+        createImageViews(ctx::vuDevice->device);
+        depthStencil.init(swapChainExtent);
+        renderPass.Init(swapChainImageFormat, depthStencil.depthFormat);
+        createFramebuffers();
+    }
+
+    uint32 VuSwapChain::acquireHeadlessImage() {
+        const uint32 imageIndex = headlessFrame % imageCount;
+        headlessFrame++;
+        return imageIndex;
+    }
+
     void VuSwapChain::uninit() {
         for (auto imageView: swapChainImageViews) {
             vkDestroyImageView(ctx::vuDevice->device, imageView, nullptr);
         }
+        if (headless) {
+            //the memory itself can not be freed on vulkan sc
+            for (auto image: swapChainImages) {
+                vkDestroyImage(ctx::vuDevice->device, image, nullptr);
+            }
+        }
         for (auto framebuffer: framebuffers) {
             vkDestroyFramebuffer(ctx::vuDevice->device, framebuffer, nullptr);
         }
@@ -141,7 +162,10 @@ namespace Vu {
         createInfo.imageColorSpace = surfaceFormat.colorSpace;
         createInfo.imageExtent = extend;
         createInfo.imageArrayLayers = 1;
-        createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+        //transfer src when available, for frame readback
+        imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT
+                     | (swapChainSupport.capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
+        createInfo.imageUsage = imageUsage;
 
         QueueFamilyIndices indices = findQueueFamilies(ctx::vuDevice->physicalDevice, surfaceKHR);
         uint32 queueFamilyIndices[] = {indices.graphicsFamily.value(), indices.presentFamily.value()};
@@ -175,6 +199,29 @@ namespace Vu {
         swapChainExtent = extend;
     }
 
+    void VuSwapChain::createHeadlessImages(VkExtent2D extent, VkFormat format, uint32 ringSize) {
+        imageCount = ringSize;
+        swapChainImages.resize(imageCount);
+        headlessImageMemories.resize(imageCount);
+
+        for (uint32 i = 0; i < imageCount; i++) {
+            //transfer src so frames can be read back
+            VuImage::createImage(extent.width,
+                                 extent.height,
+                                 format,
+                                 VK_IMAGE_TILING_OPTIMAL,
+                                 VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+                                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                 swapChainImages[i],
+                                 headlessImageMemories[i]);
+        }
+
+        imageUsage           = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        colorFormat          = format;
+        swapChainImageFormat = format;
+        swapChainExtent      = extent;
+    }
+
     void VuSwapChain::createImageViews(VkDevice device) {
         swapChainImageViews.resize(swapChainImages.size());
 
@@ -21,9 +21,21 @@ namespace Vu {
         VkExtent2D swapChainExtent;
         uint32_t imageCount;
         uint32_t queueNodeIndex = UINT32_MAX;
+        VkImageUsageFlags imageUsage = 0;
+
+        //headless: swapChainImages are a ring of offscreen images, there is no VkSwapchainKHR
+        bool                        headless = false;
+        std::vector<VkDeviceMemory> headlessImageMemories;
+        uint32                      headlessFrame = 0;
 
         void init(VkSurfaceKHR surface);
 
+        //same render pass and framebuffers as init(), rendering into offscreen images
+        void initHeadless(VkExtent2D extent, VkFormat format, uint32 ringSize);
+
+        //next image of the headless ring, stands in for vkAcquireNextImageKHR
+        uint32 acquireHeadlessImage();
+
         void uninit();
 
         //void resetSwapChain(VkSurfaceKHR surface);
@@ -43,6 +55,8 @@ namespace Vu {
     private:
         void createSwapChain(VkSurfaceKHR surfaceKHR);
 
+        void createHeadlessImages(VkExtent2D extent, VkFormat format, uint32 ringSize);
+
         void createImageViews(VkDevice device);
 
         void createFramebuffers();
@@ -1,6 +1,10 @@
 #pragma once
 
+#include <span>
+
 #include "Common.h"
+#include "VuCtx.h"
+#include "VuDevice.h"
 
 namespace VuSync {
 
@@ -45,47 +49,60 @@ namespace VuSync {
         );
     }
 
-    //
-    // inline void InsertImageMemoryBarrier2(
-    //     VkCommandBuffer cmdbuffer,
-    //     VkImage image,
-    //     VkAccessFlags2 srcAccessMask,
-    //     VkAccessFlags2 dstAccessMask,
-    //     VkImageLayout oldImageLayout,
-    //     VkImageLayout newImageLayout,
-    //     VkPipelineStageFlags2 srcStageMask,
-    //     VkPipelineStageFlags2 dstStageMask,
-    //     VkImageSubresourceRange subresourceRange
-    //
-    // ) {
-    //
-    //     VkImageMemoryBarrier2 imageMemoryBarrier2{
-    //         .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
-    //         .srcStageMask = srcStageMask,
-    //         .srcAccessMask = srcAccessMask,
-    //         .dstStageMask = dstStageMask,
-    //         .dstAccessMask = dstAccessMask,
-    //         .oldLayout = oldImageLayout,
-    //         .newLayout = newImageLayout,
-    //         .srcQueueFamilyIndex = 0,
-    //         .dstQueueFamilyIndex = 0,
-    //         .image = image,
-    //         .subresourceRange = subresourceRange
-    //     };
-    //
-    //     VkDependencyFlags dependencyFlags = 0;
-    //
-    //     VkDependencyInfo dependInfo{
-    //         .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
-    //         .pNext = nullptr,
-    //         .dependencyFlags = dependencyFlags,
-    //         .memoryBarrierCount = 0,
-    //         .pMemoryBarriers = nullptr,
-    //         .bufferMemoryBarrierCount = 0,
-    //         .pBufferMemoryBarriers = nullptr,
-    //         .imageMemoryBarrierCount = 1,
-    //         .pImageMemoryBarriers = &imageMemoryBarrier2,
-    //     };
-    //     vkCmdPipelineBarrier2(cmdbuffer, &dependInfo);
-    // }
+    inline VkImageMemoryBarrier2KHR ImageMemoryBarrier2() {
+        VkImageMemoryBarrier2KHR imageMemoryBarrier2{};
+        imageMemoryBarrier2.sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR;
+        imageMemoryBarrier2.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        imageMemoryBarrier2.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        return imageMemoryBarrier2;
+    }
+
+    inline VkBufferMemoryBarrier2KHR BufferMemoryBarrier2() {
+        VkBufferMemoryBarrier2KHR bufferMemoryBarrier2{};
+        bufferMemoryBarrier2.sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2_KHR;
+        bufferMemoryBarrier2.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        bufferMemoryBarrier2.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        return bufferMemoryBarrier2;
+    }
+
+    //every barrier of a batch goes out with one vkCmdPipelineBarrier2KHR
+    inline void PipelineBarrier2(VkCommandBuffer                               cmdbuffer,
+                                 std::span<const VkImageMemoryBarrier2KHR>  imageBarriers,
+                                 std::span<const VkBufferMemoryBarrier2KHR> bufferBarriers) {
+        if (imageBarriers.empty() && bufferBarriers.empty()) {
+            return;
+        }
+        VkDependencyInfoKHR dependencyInfo{
+            .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR,
+            .bufferMemoryBarrierCount = static_cast<uint32_t>(bufferBarriers.size()),
+            .pBufferMemoryBarriers = bufferBarriers.data(),
+            .imageMemoryBarrierCount = static_cast<uint32_t>(imageBarriers.size()),
+            .pImageMemoryBarriers = imageBarriers.data(),
+        };
+        Vu::ctx::vuDevice->cmdPipelineBarrier2(cmdbuffer, &dependencyInfo);
+    }
+
+    inline void InsertImageMemoryBarrier2(
+        VkCommandBuffer          cmdbuffer,
+        VkImage                  image,
+        VkAccessFlags2KHR        srcAccessMask,
+        VkAccessFlags2KHR        dstAccessMask,
+        VkImageLayout            oldImageLayout,
+        VkImageLayout            newImageLayout,
+        VkPipelineStageFlags2KHR srcStageMask,
+        VkPipelineStageFlags2KHR dstStageMask,
+        VkImageSubresourceRange  subresourceRange) {
+
+        VkImageMemoryBarrier2KHR imageMemoryBarrier2 = ImageMemoryBarrier2();
+        imageMemoryBarrier2.srcStageMask     = srcStageMask;
+        imageMemoryBarrier2.srcAccessMask    = srcAccessMask;
+        imageMemoryBarrier2.dstStageMask     = dstStageMask;
+        imageMemoryBarrier2.dstAccessMask    = dstAccessMask;
+        imageMemoryBarrier2.oldLayout        = oldImageLayout;
+        imageMemoryBarrier2.newLayout        = newImageLayout;
+        imageMemoryBarrier2.image            = image;
+        imageMemoryBarrier2.subresourceRange = subresourceRange;
+
+        PipelineBarrier2(cmdbuffer, {&imageMemoryBarrier2, 1}, {});
+    }
 }
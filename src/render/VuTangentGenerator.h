@@ -0,0 +1,342 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <span>
+#include <vector>
+
+#include "Common.h"
+#include "VuParallel.h"
+#include "glm/geometric.hpp"
+
+#ifdef VU_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace Vu {
+
+    //MikkTSpace style tangent frames for an indexed mesh: per corner the triangle's uv gradients are projected
+    //onto the vertex normal, normalized and weighted by the corner angle, so the result does not depend on how
+    //a surface is tessellated. vertices are never split, glTF meshes already carry one uv per vertex.
+    //triangles are processed in chunks on worker threads, each chunk accumulates into its own partial that
+    //only spans the vertex range the chunk references, the partials are then summed per vertex block
+    struct VuTangentGenerator {
+        //below this many triangles per chunk the thread startup costs more than it saves
+        static constexpr uint32 MIN_TRIANGLES_PER_CHUNK = 32768U;
+        static constexpr uint32 VERTICES_PER_BLOCK      = 65536U;
+
+        //area weighted smooth normals, for primitives that come without NORMAL
+        static void generateNormals(std::span<const uint32> indices,
+                                    std::span<const float3> positions,
+                                    std::span<float3>       normals,
+                                    uint32                  threadCount = 0U) {
+            const uint32 vertexCount   = static_cast<uint32>(positions.size());
+            const uint32 triangleCount = static_cast<uint32>(indices.size() / 3U);
+
+            std::vector<Partial> partials(chunkCount(triangleCount, threadCount));
+            VuParallel::forEach(static_cast<uint32>(partials.size()), threadCount, [&](uint32 chunk) {
+                Partial&     partial = partials[chunk];
+                const uint32 first   = VuParallel::chunkBegin(chunk, triangleCount, static_cast<uint32>(partials.size()));
+                const uint32 last    = VuParallel::chunkBegin(chunk + 1U, triangleCount, static_cast<uint32>(partials.size()));
+                partial.reserve(indices, first, last, false);
+
+                for (uint32 t = first; t < last; t++) {
+                    const uint32 i0 = indices[t * 3U + 0U];
+                    const uint32 i1 = indices[t * 3U + 1U];
+                    const uint32 i2 = indices[t * 3U + 2U];
+
+                    //twice the area along the face normal
+                    const float3 faceNormal = glm::cross(positions[i1] - positions[i0], positions[i2] - positions[i0]);
+                    partial.a[i0 - partial.firstVertex] += faceNormal;
+                    partial.a[i1 - partial.firstVertex] += faceNormal;
+                    partial.a[i2 - partial.firstVertex] += faceNormal;
+                }
+            });
+
+            std::vector<float3> sums;
+            std::vector<float3> unused;
+            reduce(partials, vertexCount, threadCount, false, sums, unused);
+
+            VuParallel::forEach(blockCount(vertexCount), threadCount, [&](uint32 block) {
+                const uint32 first = block * VERTICES_PER_BLOCK;
+                const uint32 last  = std::min(first + VERTICES_PER_BLOCK, vertexCount);
+                finalizeNormals(sums, normals, first, last);
+            });
+        }
+
+        //tangents.xyz along increasing u, w is the handedness so that bitangent = cross(normal, tangent.xyz) * w
+        static void generateTangents(std::span<const uint32> indices,
+                                     std::span<const float3> positions,
+                                     std::span<const float3> normals,
+                                     std::span<const float2> uvs,
+                                     std::span<float4>       tangents,
+                                     uint32                  threadCount = 0U) {
+            const uint32 vertexCount   = static_cast<uint32>(positions.size());
+            const uint32 triangleCount = static_cast<uint32>(indices.size() / 3U);
+
+            std::vector<Partial> partials(chunkCount(triangleCount, threadCount));
+            VuParallel::forEach(static_cast<uint32>(partials.size()), threadCount, [&](uint32 chunk) {
+                Partial&     partial = partials[chunk];
+                const uint32 first   = VuParallel::chunkBegin(chunk, triangleCount, static_cast<uint32>(partials.size()));
+                const uint32 last    = VuParallel::chunkBegin(chunk + 1U, triangleCount, static_cast<uint32>(partials.size()));
+                partial.reserve(indices, first, last, true);
+
+                for (uint32 t = first; t < last; t++) {
+                    accumulateTriangle(partial, indices.subspan(t * 3U, 3U), positions, normals, uvs);
+                }
+            });
+
+            std::vector<float3> tangentSums;
+            std::vector<float3> bitangentSums;
+            reduce(partials, vertexCount, threadCount, true, tangentSums, bitangentSums);
+
+            VuParallel::forEach(blockCount(vertexCount), threadCount, [&](uint32 block) {
+                const uint32 first = block * VERTICES_PER_BLOCK;
+                const uint32 last  = std::min(first + VERTICES_PER_BLOCK, vertexCount);
+                finalizeTangents(normals, tangentSums, bitangentSums, tangents, first, last);
+            });
+        }
+
+    private:
+        struct Partial {
+            uint32              firstVertex = 0U;
+            uint32              endVertex   = 0U;
+            std::vector<float3> a;
+            std::vector<float3> b;
+
+            void reserve(std::span<const uint32> indices, uint32 firstTriangle, uint32 lastTriangle, bool withB) {
+                if (firstTriangle == lastTriangle) {
+                    return;
+                }
+                uint32 minIndex = UINT32_MAX;
+                uint32 maxIndex = 0U;
+                for (uint32 i = firstTriangle * 3U; i < lastTriangle * 3U; i++) {
+                    minIndex = std::min(minIndex, indices[i]);
+                    maxIndex = std::max(maxIndex, indices[i]);
+                }
+                firstVertex = minIndex;
+                endVertex   = maxIndex + 1U;
+                a.assign(endVertex - firstVertex, float3(0.0F));
+                if (withB) {
+                    b.assign(endVertex - firstVertex, float3(0.0F));
+                }
+            }
+        };
+
+        static uint32 chunkCount(uint32 triangleCount, uint32 threadCount) {
+            const uint32 bySize = std::max((triangleCount + MIN_TRIANGLES_PER_CHUNK - 1U) / MIN_TRIANGLES_PER_CHUNK, 1U);
+            return std::min(bySize, VuParallel::resolveThreadCount(threadCount));
+        }
+
+        static uint32 blockCount(uint32 vertexCount) {
+            return (vertexCount + VERTICES_PER_BLOCK - 1U) / VERTICES_PER_BLOCK;
+        }
+
+        //every vertex block is owned by one task, so summing the overlapping partials needs no atomics
+        static void reduce(std::vector<Partial>& partials,
+                           uint32                vertexCount,
+                           uint32                threadCount,
+                           bool                  withB,
+                           std::vector<float3>&  outA,
+                           std::vector<float3>&  outB) {
+            //a single chunk that references every vertex already is the sum
+            if (partials.size() == 1U && partials[0].firstVertex == 0U && partials[0].endVertex == vertexCount) {
+                outA = std::move(partials[0].a);
+                if (withB) {
+                    outB = std::move(partials[0].b);
+                }
+                return;
+            }
+
+            outA.assign(vertexCount, float3(0.0F));
+            if (withB) {
+                outB.assign(vertexCount, float3(0.0F));
+            }
+            VuParallel::forEach(blockCount(vertexCount), threadCount, [&](uint32 block) {
+                const uint32 blockFirst = block * VERTICES_PER_BLOCK;
+                const uint32 blockEnd   = std::min(blockFirst + VERTICES_PER_BLOCK, vertexCount);
+                for (const Partial& partial: partials) {
+                    const uint32 first = std::max(blockFirst, partial.firstVertex);
+                    const uint32 end   = std::min(blockEnd, partial.endVertex);
+                    for (uint32 v = first; v < end; v++) {
+                        outA[v] += partial.a[v - partial.firstVertex];
+                        if (withB) {
+                            outB[v] += partial.b[v - partial.firstVertex];
+                        }
+                    }
+                }
+            });
+        }
+
+        static float3 projectAndNormalize(const float3& v, const float3& n) {
+            const float3 projected = v - n * glm::dot(n, v);
+            const float  length2   = glm::dot(projected, projected);
+            return length2 > 1e-30F ? projected * (1.0F / std::sqrt(length2)) : float3(0.0F);
+        }
+
+        static void accumulateTriangle(Partial&                 partial,
+                                       std::span<const uint32>  triangle,
+                                       std::span<const float3>  positions,
+                                       std::span<const float3>  normals,
+                                       std::span<const float2>  uvs) {
+            const float3 p[3]  = {positions[triangle[0]], positions[triangle[1]], positions[triangle[2]]};
+            const float2 uv[3] = {uvs[triangle[0]], uvs[triangle[1]], uvs[triangle[2]]};
+
+            const float3 e1 = p[1] - p[0];
+            const float3 e2 = p[2] - p[0];
+            const float  s1 = uv[1].x - uv[0].x;
+            const float  s2 = uv[2].x - uv[0].x;
+            const float  t1 = uv[1].y - uv[0].y;
+            const float  t2 = uv[2].y - uv[0].y;
+
+            //degenerate uv mapping, the vertices get their frame from the neighbours or the fallback
+            const float det = s1 * t2 - s2 * t1;
+            if (std::abs(det) < 1e-20F) {
+                return;
+            }
+            const float  r    = 1.0F / det;
+            const float3 sdir = (e1 * t2 - e2 * t1) * r;
+            const float3 tdir = (e2 * s1 - e1 * s2) * r;
+
+            //unit edges once per triangle, the corner angles come from their dot products
+            float3 edges[3] = {p[1] - p[0], p[2] - p[1], p[0] - p[2]};
+            for (float3& edge: edges) {
+                const float length2 = glm::dot(edge, edge);
+                if (length2 <= 1e-30F) {
+                    return;
+                }
+                edge *= 1.0F / std::sqrt(length2);
+            }
+
+            for (uint32 k = 0U; k < 3U; k++) {
+                const float cosAngle = std::clamp(-glm::dot(edges[k], edges[(k + 2U) % 3U]), -1.0F, 1.0F);
+                const float angle    = std::acos(cosAngle);
+
+                const uint32 v = triangle[k] - partial.firstVertex;
+                const float3 n = normals[triangle[k]];
+                partial.a[v] += projectAndNormalize(sdir, n) * angle;
+                partial.b[v] += projectAndNormalize(tdir, n) * angle;
+            }
+        }
+
+        //any unit vector perpendicular to n, for vertices whose triangles all had degenerate uvs
+        static float3 perpendicular(const float3& n) {
+            const float3 axis = std::abs(n.x) < 0.9F ? float3(1.0F, 0.0F, 0.0F) : float3(0.0F, 1.0F, 0.0F);
+            return projectAndNormalize(axis, n);
+        }
+
+        static void finalizeTangent(const float3& n, const float3& t, const float3& b, float4& outTangent) {
+            float3 tangent = projectAndNormalize(t, n);
+            if (tangent == float3(0.0F)) {
+                tangent = perpendicular(n);
+            }
+            const float sign = glm::dot(glm::cross(n, tangent), b) < 0.0F ? -1.0F : 1.0F;
+            outTangent       = float4(tangent, sign);
+        }
+
+        static void finalizeNormal(const float3& sum, float3& outNormal) {
+            const float length2 = glm::dot(sum, sum);
+            outNormal           = length2 > 1e-30F ? sum / std::sqrt(length2) : float3(0.0F, 0.0F, 1.0F);
+        }
+
+#ifdef VU_SSE2
+        //four vertices at a time, the float3 streams are transposed into x/y/z registers
+        static void load4(const float3* v, __m128& x, __m128& y, __m128& z) {
+            x = _mm_set_ps(v[3].x, v[2].x, v[1].x, v[0].x);
+            y = _mm_set_ps(v[3].y, v[2].y, v[1].y, v[0].y);
+            z = _mm_set_ps(v[3].z, v[2].z, v[1].z, v[0].z);
+        }
+
+        static __m128 dot4(__m128 ax, __m128 ay, __m128 az, __m128 bx, __m128 by, __m128 bz) {
+            return _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_mul_ps(az, bz));
+        }
+#endif
+
+        static void finalizeTangents(std::span<const float3>    normals,
+                                     const std::vector<float3>& tangentSums,
+                                     const std::vector<float3>& bitangentSums,
+                                     std::span<float4>          tangents,
+                                     uint32                     first,
+                                     uint32                     last) {
+            uint32 v = first;
+#ifdef VU_SSE2
+            const __m128 epsilon = _mm_set1_ps(1e-30F);
+            const __m128 one     = _mm_set1_ps(1.0F);
+            const __m128 signBit = _mm_set1_ps(-0.0F);
+            for (; v + 4U <= last; v += 4U) {
+                __m128 nx, ny, nz, tx, ty, tz, bx, by, bz;
+                load4(&normals[v], nx, ny, nz);
+                load4(&tangentSums[v], tx, ty, tz);
+                load4(&bitangentSums[v], bx, by, bz);
+
+                //gram-schmidt against the normal, then normalize
+                const __m128 d = dot4(nx, ny, nz, tx, ty, tz);
+                tx             = _mm_sub_ps(tx, _mm_mul_ps(nx, d));
+                ty             = _mm_sub_ps(ty, _mm_mul_ps(ny, d));
+                tz             = _mm_sub_ps(tz, _mm_mul_ps(nz, d));
+
+                const __m128 length2 = dot4(tx, ty, tz, tx, ty, tz);
+                const int    valid   = _mm_movemask_ps(_mm_cmpgt_ps(length2, epsilon));
+                const __m128 inv     = _mm_div_ps(one, _mm_sqrt_ps(_mm_max_ps(length2, epsilon)));
+                tx                   = _mm_mul_ps(tx, inv);
+                ty                   = _mm_mul_ps(ty, inv);
+                tz                   = _mm_mul_ps(tz, inv);
+
+                //handedness: sign of dot(cross(n, t), b) moved onto 1.0
+                const __m128 cx   = _mm_sub_ps(_mm_mul_ps(ny, tz), _mm_mul_ps(nz, ty));
+                const __m128 cy   = _mm_sub_ps(_mm_mul_ps(nz, tx), _mm_mul_ps(nx, tz));
+                const __m128 cz   = _mm_sub_ps(_mm_mul_ps(nx, ty), _mm_mul_ps(ny, tx));
+                const __m128 side = dot4(cx, cy, cz, bx, by, bz);
+                const __m128 sign = _mm_or_ps(one, _mm_and_ps(_mm_cmplt_ps(side, _mm_setzero_ps()), signBit));
+
+                alignas(16) float x[4], y[4], z[4], w[4];
+                _mm_store_ps(x, tx);
+                _mm_store_ps(y, ty);
+                _mm_store_ps(z, tz);
+                _mm_store_ps(w, sign);
+                for (uint32 lane = 0U; lane < 4U; lane++) {
+                    if ((valid & (1 << lane)) != 0) {
+                        tangents[v + lane] = float4(x[lane], y[lane], z[lane], w[lane]);
+                    } else {
+                        finalizeTangent(normals[v + lane], tangentSums[v + lane], bitangentSums[v + lane], tangents[v + lane]);
+                    }
+                }
+            }
+#endif
+            for (; v < last; v++) {
+                finalizeTangent(normals[v], tangentSums[v], bitangentSums[v], tangents[v]);
+            }
+        }
+
+        static void finalizeNormals(const std::vector<float3>& sums, std::span<float3> normals, uint32 first, uint32 last) {
+            uint32 v = first;
+#ifdef VU_SSE2
+            const __m128 epsilon = _mm_set1_ps(1e-30F);
+            const __m128 one     = _mm_set1_ps(1.0F);
+            for (; v + 4U <= last; v += 4U) {
+                __m128 x, y, z;
+                load4(&sums[v], x, y, z);
+
+                const __m128 length2 = dot4(x, y, z, x, y, z);
+                const int    valid   = _mm_movemask_ps(_mm_cmpgt_ps(length2, epsilon));
+                const __m128 inv     = _mm_div_ps(one, _mm_sqrt_ps(_mm_max_ps(length2, epsilon)));
+
+                alignas(16) float nx[4], ny[4], nz[4];
+                _mm_store_ps(nx, _mm_mul_ps(x, inv));
+                _mm_store_ps(ny, _mm_mul_ps(y, inv));
+                _mm_store_ps(nz, _mm_mul_ps(z, inv));
+                for (uint32 lane = 0U; lane < 4U; lane++) {
+                    if ((valid & (1 << lane)) != 0) {
+                        normals[v + lane] = float3(nx[lane], ny[lane], nz[lane]);
+                    } else {
+                        finalizeNormal(sums[v + lane], normals[v + lane]);
+                    }
+                }
+            }
+#endif
+            for (; v < last; v++) {
+                finalizeNormal(sums[v], normals[v]);
+            }
+        }
+    };
+}
@@ -2,7 +2,10 @@
 
 #include "Common.h"
 #include "VuBuffer.h"
+#include "VuFile.h"
 #include "VuImage.h"
+#include "VuImageDecoder.h"
+#include "VuTextureContainer.h"
 
 namespace std::filesystem {
     class path;
@@ -13,6 +16,7 @@ namespace Vu {
     struct VuTextureCreateInfo {
         std::filesystem::path path;
         VkFormat              format = VK_FORMAT_R8G8B8A8_SRGB;
+        bool                  generateMipmaps = true;
     };
 
     struct VuTexture {
@@ -20,50 +24,60 @@ namespace Vu {
         VkImage        image;
         VkDeviceMemory imageMemory;
         VkImageView    imageView;
+        uint32         width;
+        uint32         height;
+        uint32         mipLevels;
 
         void init(const VuTextureCreateInfo& info) {
             std::cout << "VuTexture::init()" << std::endl;
-            //Image
-            int texWidth;
-            int texHeight;
-            int texChannels;
-
-            stbi_uc* pixels;
-            loadImageFile(info, texWidth, texHeight, texChannels, pixels);
-            const auto imageSize = static_cast<VkDeviceSize>(texWidth * texHeight * 4);
-
-            if (pixels == nullptr) {
+            if (info.path.extension() == ".vutex") {
+                initFromContainer(info.path);
+                return;
+            }
+            //Image, decoded straight into the staging buffer with the row pitch the copy wants
+            const VuMappedFile file(info.path, VuFileAccess::Sequential);
+            VuImageInfo        imageInfo{};
+            if (!VuImageDecoder::readInfo(file.bytes(), imageInfo)) {
                 throw std::runtime_error("failed to load texture image!");
             }
+            const VkDeviceSize rowPitch  = VuImage::stagingRowPitch(imageInfo.width);
+            const VkDeviceSize imageSize = VuImageDecoder::byteSizeOf(imageInfo, rowPitch);
+            if (imageSize > VuBuffer::globalStagingBuffer->getSizeInBytes()) {
+                throw std::runtime_error("texture image does not fit into the staging buffer!");
+            }
+            VuImageDecoder::decodeRGBA8(file.bytes(), imageInfo, {
+                                            VuBuffer::globalStagingBuffer->getSpan(0U, imageSize),
+                                            rowPitch,
+                                            VuBuffer::globalStagingBuffer->isHostCached()
+                                        });
+
+            width  = imageInfo.width;
+            height = imageInfo.height;
+
+            //blit based mip generation needs linear filtering support on the format
+            mipLevels = 1U;
+            if (info.generateMipmaps && VuImage::supportsLinearBlit(info.format)) {
+                mipLevels = VuImage::calculateMipLevels(width, height);
+            }
 
-            // VuBuffer staging{};
-            // VkDeviceSize size = texWidth * texHeight;
-            // staging.init({
-            //     .lenght = size,
-            //     .strideInBytes = 4,
-            //     .usageFlags = VK_BUFFER_USAGE_TRANSFER_SRC_BIT
-            // });
-            VuBuffer::globalStagingBuffer->setData(pixels, imageSize);
-            stbi_image_free(pixels);
-
-            VuImage::createImage(texWidth, texHeight, info.format, VK_IMAGE_TILING_OPTIMAL,
-                                 VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+            VuImage::createImage(width, height, info.format, VK_IMAGE_TILING_OPTIMAL,
+                                 VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
                                  VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
                                  image,
-                                 imageMemory);
+                                 imageMemory,
+                                 mipLevels);
 
             VuImage::transitionImageLayout(image,
                                            VK_IMAGE_LAYOUT_UNDEFINED,
-                                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+                                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                           mipLevels);
 
-            VuImage::copyBufferToImage(VuBuffer::globalStagingBuffer->buffer, image,
-                                       static_cast<uint32>(texWidth), static_cast<uint32>(texHeight));
+            VuImage::copyBufferToImage(VuBuffer::globalStagingBuffer->buffer, image, width, height, static_cast<uint32>(rowPitch / 4U));
 
-            VuImage::transitionImageLayout(image,
-                                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                                           VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+            //also transitions every level to SHADER_READ_ONLY_OPTIMAL
+            VuImage::generateMipmaps(image, width, height, mipLevels);
 
-            VuImage::createImageView(info.format, image,VK_IMAGE_ASPECT_COLOR_BIT, imageView);
+            VuImage::createImageView(info.format, image,VK_IMAGE_ASPECT_COLOR_BIT, imageView, mipLevels);
 
             //staging.uninit();
         }
@@ -75,9 +89,71 @@ namespace Vu {
             //vkDestroyImageView(ctx::vuDevice->device, imageView, nullptr);
         } //
 
+        //prefers an offline baked sibling (texture.png -> texture.vutex) when one exists
+        static std::filesystem::path resolveBakedPath(const std::filesystem::path& sourcePath) {
+            std::filesystem::path bakedPath = sourcePath;
+            bakedPath.replace_extension(".vutex");
+            if (std::filesystem::exists(bakedPath)) {
+                return bakedPath;
+            }
+            return sourcePath;
+        }
+
     private:
-        static void loadImageFile(const VuTextureCreateInfo& info, int& texWidth, int& texHeight, int& texChannels, stbi_uc*& pixels) {
-            pixels = stbi_load(info.path.string().c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
+        //the container already holds every level in its final (usually BC) format, no runtime work besides the copy
+        void initFromContainer(const std::filesystem::path& path) {
+            const VuMappedFile  mapped(path, VuFileAccess::Sequential);
+            const VuTextureFile file   = VuTextureContainer::readLayout(mapped.bytes(), path);
+            const auto          format = static_cast<VkFormat>(file.header.format);
+
+            width     = file.header.width;
+            height    = file.header.height;
+            mipLevels = file.header.mipCount;
+
+            std::vector<VkBufferImageCopy> regions(mipLevels);
+            VkDeviceSize                   stagingOffset = 0U;
+            for (uint32 mip = 0U; mip < mipLevels; mip++) {
+                const VuTextureFileMip& mipInfo = file.mips[mip];
+                if (stagingOffset + mipInfo.size > VuBuffer::globalStagingBuffer->getSizeInBytes()) {
+                    throw std::runtime_error("texture container does not fit into the staging buffer!");
+                }
+                VuBuffer::globalStagingBuffer->setData(VuTextureContainer::getMipData(mapped.bytes(), file, mip).data(), mipInfo.size, stagingOffset);
+
+                VkBufferImageCopy& region              = regions[mip];
+                region.bufferOffset                    = stagingOffset;
+                region.bufferRowLength                 = 0;
+                region.bufferImageHeight               = 0;
+                region.imageSubresource.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+                region.imageSubresource.mipLevel       = mip;
+                region.imageSubresource.baseArrayLayer = 0;
+                region.imageSubresource.layerCount     = 1;
+                region.imageOffset                     = {0, 0, 0};
+                region.imageExtent                     = {mipInfo.width, mipInfo.height, 1};
+
+                //bufferOffset must be a multiple of the texel block size
+                stagingOffset = (stagingOffset + mipInfo.size + 15U) & ~static_cast<VkDeviceSize>(15U);
+            }
+
+            VuImage::createImage(width, height, format, VK_IMAGE_TILING_OPTIMAL,
+                                 VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+                                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                 image,
+                                 imageMemory,
+                                 mipLevels);
+
+            VuImage::transitionImageLayout(image,
+                                           VK_IMAGE_LAYOUT_UNDEFINED,
+                                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                           mipLevels);
+
+            VuImage::copyBufferToImage(VuBuffer::globalStagingBuffer->buffer, image, regions);
+
+            VuImage::transitionImageLayout(image,
+                                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                           VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                                           mipLevels);
+
+            VuImage::createImageView(format, image, VK_IMAGE_ASPECT_COLOR_BIT, imageView, mipLevels);
         }
     };
 
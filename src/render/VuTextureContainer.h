@@ -0,0 +1,215 @@
+#pragma once
+
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "Common.h"
+#include "VuFile.h"
+
+namespace Vu {
+
+    //.vutex layout: VuTextureFileHeader, mipCount * VuTextureFileMip, then mip payloads (most detailed first)
+    struct VuTextureFileHeader {
+        static constexpr uint32 MAGIC   = 0x58545556U; //"VUTX"
+        static constexpr uint32 VERSION = 1U;
+
+        uint32 magic    = MAGIC;
+        uint32 version  = VERSION;
+        uint32 format   = VK_FORMAT_UNDEFINED;
+        uint32 width    = 0U;
+        uint32 height   = 0U;
+        uint32 mipCount = 0U;
+    };
+
+    struct VuTextureFileMip {
+        uint64 offset;
+        uint64 size;
+        uint32 width;
+        uint32 height;
+    };
+
+    //the layout only, level bytes are read in place from a mapping of the file with VuTextureContainer::getMipData
+    struct VuTextureFile {
+        VuTextureFileHeader           header;
+        std::vector<VuTextureFileMip> mips;
+    };
+
+    struct VuTextureContainer {
+
+        static bool isBlockCompressed(VkFormat format) {
+            return format >= VK_FORMAT_BC1_RGB_UNORM_BLOCK && format <= VK_FORMAT_BC7_SRGB_BLOCK;
+        }
+
+        //bytes per 4x4 block for BC formats, bytes per texel otherwise
+        static uint32 blockByteSize(VkFormat format) {
+            switch (format) {
+                case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+                case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+                case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+                case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+                case VK_FORMAT_BC4_UNORM_BLOCK:
+                case VK_FORMAT_BC4_SNORM_BLOCK:
+                    return 8U;
+                case VK_FORMAT_BC2_UNORM_BLOCK:
+                case VK_FORMAT_BC2_SRGB_BLOCK:
+                case VK_FORMAT_BC3_UNORM_BLOCK:
+                case VK_FORMAT_BC3_SRGB_BLOCK:
+                case VK_FORMAT_BC5_UNORM_BLOCK:
+                case VK_FORMAT_BC5_SNORM_BLOCK:
+                case VK_FORMAT_BC6H_UFLOAT_BLOCK:
+                case VK_FORMAT_BC6H_SFLOAT_BLOCK:
+                case VK_FORMAT_BC7_UNORM_BLOCK:
+                case VK_FORMAT_BC7_SRGB_BLOCK:
+                    return 16U;
+                case VK_FORMAT_R8_UNORM:
+                    return 1U;
+                case VK_FORMAT_R8G8_UNORM:
+                    return 2U;
+                case VK_FORMAT_R8G8B8A8_UNORM:
+                case VK_FORMAT_R8G8B8A8_SRGB:
+                case VK_FORMAT_B8G8R8A8_UNORM:
+                case VK_FORMAT_B8G8R8A8_SRGB:
+                    return 4U;
+                default:
+                    throw std::runtime_error("unsupported texture container format!");
+            }
+        }
+
+        static uint64 mipByteSize(VkFormat format, uint32 width, uint32 height) {
+            if (isBlockCompressed(format)) {
+                return static_cast<uint64>((width + 3U) / 4U) * ((height + 3U) / 4U) * blockByteSize(format);
+            }
+            return static_cast<uint64>(width) * height * blockByteSize(format);
+        }
+
+        //payload of every level starts after the header and the mip table
+        static uint64 payloadOffset(const VuTextureFileHeader& header) {
+            return sizeof(VuTextureFileHeader) + sizeof(VuTextureFileMip) * header.mipCount;
+        }
+
+        //header and mip table only, lets the streaming path read single levels later
+        static VuTextureFile readLayout(const std::filesystem::path& path) {
+            const VuMappedFile file(path, VuFileAccess::Random);
+            return readLayout(file.bytes(), path);
+        }
+
+        //fileBytes is the whole container, usually a VuMappedFile
+        static VuTextureFile readLayout(std::span<const uint8> fileBytes, const std::filesystem::path& path) {
+            VuTextureFile result{};
+            if (fileBytes.size() < sizeof(VuTextureFileHeader)) {
+                throw std::runtime_error("invalid texture container: " + path.string());
+            }
+            std::memcpy(&result.header, fileBytes.data(), sizeof(VuTextureFileHeader));
+            if (result.header.magic != VuTextureFileHeader::MAGIC || result.header.version != VuTextureFileHeader::VERSION) {
+                throw std::runtime_error("invalid texture container: " + path.string());
+            }
+
+            if (fileBytes.size() < payloadOffset(result.header)) {
+                throw std::runtime_error("truncated texture container: " + path.string());
+            }
+            result.mips.resize(result.header.mipCount);
+            std::memcpy(result.mips.data(), fileBytes.data() + sizeof(VuTextureFileHeader), sizeof(VuTextureFileMip) * result.header.mipCount);
+            return result;
+        }
+
+        //the level inside fileBytes, no copy
+        static std::span<const uint8> getMipData(std::span<const uint8> fileBytes, const VuTextureFile& layout, uint32 mip) {
+            const uint64 offset = payloadOffset(layout.header) + layout.mips[mip].offset;
+            if (offset > fileBytes.size() || layout.mips[mip].size > fileBytes.size() - offset) {
+                throw std::runtime_error("truncated texture container!");
+            }
+            return fileBytes.subspan(static_cast<size_t>(offset), static_cast<size_t>(layout.mips[mip].size));
+        }
+
+        //bytes of mips [firstMip, endMip) in the file, the levels are stored back to back
+        static std::pair<uint64, uint64> getMipRange(const VuTextureFile& layout, uint32 firstMip, uint32 endMip) {
+            const uint64 begin = payloadOffset(layout.header) + layout.mips[firstMip].offset;
+            const uint64 end   = payloadOffset(layout.header) + layout.mips[endMip - 1U].offset + layout.mips[endMip - 1U].size;
+            return {begin, end - begin};
+        }
+
+        //mipData holds every level back to back, most detailed first
+        static void write(const std::filesystem::path& path,
+                          VkFormat                     format,
+                          uint32                       width,
+                          uint32                       height,
+                          std::span<const std::vector<uint8>> mipData) {
+            VuTextureFileHeader header{};
+            header.format   = format;
+            header.width    = width;
+            header.height   = height;
+            header.mipCount = static_cast<uint32>(mipData.size());
+
+            std::vector<VuTextureFileMip> mips(mipData.size());
+            uint64                        offset = 0U;
+            for (uint32 i = 0U; i < mipData.size(); i++) {
+                mips[i].offset = offset;
+                mips[i].size   = mipData[i].size();
+                mips[i].width  = std::max(width >> i, 1U);
+                mips[i].height = std::max(height >> i, 1U);
+                offset += mipData[i].size();
+            }
+
+            std::ofstream file(path, std::ios::binary | std::ios::out);
+            if (!file.is_open()) {
+                throw std::runtime_error("Failed to open file: " + path.string());
+            }
+            file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char *>(mips.data()), static_cast<std::streamsize>(sizeof(VuTextureFileMip) * mips.size()));
+            for (const std::vector<uint8>& level: mipData) {
+                file.write(reinterpret_cast<const char *>(level.data()), static_cast<std::streamsize>(level.size()));
+            }
+            if (!file) {
+                throw std::runtime_error("Failed to write to file: " + path.string());
+            }
+        }
+
+        //2x2 box filter on RGBA8, sRGB data is averaged in linear space
+        static std::vector<uint8> downsampleRGBA8(std::span<const uint8> src, uint32 width, uint32 height, bool srgb) {
+            const uint32       dstWidth  = std::max(width / 2U, 1U);
+            const uint32       dstHeight = std::max(height / 2U, 1U);
+            std::vector<uint8> dst(static_cast<size_t>(dstWidth) * dstHeight * 4U);
+
+            for (uint32 y = 0U; y < dstHeight; y++) {
+                const uint32 y0 = std::min(y * 2U, height - 1U);
+                const uint32 y1 = std::min(y * 2U + 1U, height - 1U);
+                for (uint32 x = 0U; x < dstWidth; x++) {
+                    const uint32 x0 = std::min(x * 2U, width - 1U);
+                    const uint32 x1 = std::min(x * 2U + 1U, width - 1U);
+                    for (uint32 c = 0U; c < 4U; c++) {
+                        const bool  linearize = srgb && c < 3U;
+                        const float sum       = toLinear(src[(y0 * width + x0) * 4U + c], linearize)
+                                                + toLinear(src[(y0 * width + x1) * 4U + c], linearize)
+                                                + toLinear(src[(y1 * width + x0) * 4U + c], linearize)
+                                                + toLinear(src[(y1 * width + x1) * 4U + c], linearize);
+                        dst[(y * dstWidth + x) * 4U + c] = fromLinear(sum * 0.25F, linearize);
+                    }
+                }
+            }
+            return dst;
+        }
+
+    private:
+        static float toLinear(uint8 value, bool srgb) {
+            const float v = static_cast<float>(value) / 255.0F;
+            if (!srgb) {
+                return v;
+            }
+            return v <= 0.04045F ? v / 12.92F : std::pow((v + 0.055F) / 1.055F, 2.4F);
+        }
+
+        static uint8 fromLinear(float value, bool srgb) {
+            float v = value;
+            if (srgb) {
+                v = v <= 0.0031308F ? v * 12.92F : 1.055F * std::pow(v, 1.0F / 2.4F) - 0.055F;
+            }
+            return static_cast<uint8>(std::clamp(v * 255.0F + 0.5F, 0.0F, 255.0F));
+        }
+    };
+}
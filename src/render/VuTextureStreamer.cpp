@@ -0,0 +1,753 @@
+#include "VuTextureStreamer.h"
+
+#include "VuAssetCache.h"
+#include "VuConfig.h"
+#include "VuCpuProfiler.h"
+#include "VuCtx.h"
+#include "VuDevice.h"
+#include "VuImageDecoder.h"
+
+namespace Vu {
+
+    void VuTextureStreamer::init(const VuTextureStreamerCreateInfo& info) {
+        createInfo = info;
+        createPlaceholder();
+
+        std::array<VkCommandBuffer, config::MAX_FRAMES_IN_FLIGHT> commandBuffers{};
+        VkCommandBufferAllocateInfo                              allocInfo{};
+        allocInfo.sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool        = ctx::vuDevice->commandPool;
+        allocInfo.level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandBufferCount = static_cast<uint32>(commandBuffers.size());
+        VkCheck(vkAllocateCommandBuffers(ctx::vuDevice->device, &allocInfo, commandBuffers.data()));
+
+        //signaled, so the first update can record into any slot
+        VkFenceCreateInfo fenceInfo{};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+        for (uint32 i = 0U; i < uploadSlots.size(); i++) {
+            UploadSlot& slot   = uploadSlots[i];
+            slot.commandBuffer = commandBuffers[i];
+            VkCheck(vkCreateFence(ctx::vuDevice->device, &fenceInfo, nullptr, &slot.fence));
+            slot.staging.init({
+                .length = createInfo.stagingSize,
+                .strideInBytes = 1U,
+                .usageFlags = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                .memoryPropertyFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            });
+            slot.staging.map();
+        }
+    }
+
+    void VuTextureStreamer::uninit() {
+        //loads in flight write into results, they have to finish before this goes away
+        VuJobSystem::wait(loadCounter);
+        results.clear();
+
+        //expects the device to be idle, the arena memory itself can not be freed on vulkan sc
+        for (const PendingRepoint& repoint: pendingRepoints) {
+            pendingReleases.push_back(repoint.replaced);
+        }
+        pendingRepoints.clear();
+        for (const PendingRelease& release: pendingReleases) {
+            if (release.image != VK_NULL_HANDLE) {
+                vkDestroyImageView(ctx::vuDevice->device, release.view, nullptr);
+                vkDestroyImage(ctx::vuDevice->device, release.image, nullptr);
+            }
+        }
+        pendingReleases.clear();
+        slotOwners.clear();
+
+        for (auto& [index, texture]: textures) {
+            if (texture.image != VK_NULL_HANDLE) {
+                vkDestroyImageView(ctx::vuDevice->device, texture.view, nullptr);
+                vkDestroyImage(ctx::vuDevice->device, texture.image, nullptr);
+            }
+            if (texture.tailImage != VK_NULL_HANDLE) {
+                vkDestroyImageView(ctx::vuDevice->device, texture.tailView, nullptr);
+                vkDestroyImage(ctx::vuDevice->device, texture.tailImage, nullptr);
+            }
+        }
+        textures.clear();
+
+        for (UploadSlot& slot: uploadSlots) {
+            vkFreeCommandBuffers(ctx::vuDevice->device, ctx::vuDevice->commandPool, 1, &slot.commandBuffer);
+            vkDestroyFence(ctx::vuDevice->device, slot.fence, nullptr);
+            slot.staging.uninit();
+            slot = UploadSlot{};
+        }
+
+        vkDestroyImageView(ctx::vuDevice->device, placeholderView, nullptr);
+        vkDestroyImage(ctx::vuDevice->device, placeholderImage, nullptr);
+    }
+
+    VuHandle<VuTexture> VuTextureStreamer::registerTexture(const VuTextureCreateInfo& info) {
+        VuStreamedTexture texture{};
+        texture.path          = VuTexture::resolveBakedPath(info.path);
+        texture.fromContainer = texture.path.extension() == ".vutex";
+
+        //a source decoded on an earlier start comes back as an uncompressed container with its whole mip chain
+        if (!texture.fromContainer && VuAssetCache::isEnabled()) {
+            const std::filesystem::path sources[] = {texture.path};
+            const uint64                key       = VuAssetCache::keyOf(sources, "vutex rgba8 box mips " + std::to_string(info.format));
+            const std::filesystem::path cached    = VuAssetCache::find(key, ".vutex");
+            if (cached.empty()) {
+                texture.cacheKey = key;
+            } else {
+                texture.path          = cached;
+                texture.fromContainer = true;
+            }
+        }
+
+        if (texture.fromContainer) {
+            texture.layout = VuTextureContainer::readLayout(texture.path);
+            texture.format = static_cast<VkFormat>(texture.layout.header.format);
+        } else {
+            //only the dimensions are needed here, decoding happens in a job. the header sits in the first page,
+            //random access keeps the kernel from reading the rest of the file ahead
+            const VuMappedFile file(texture.path, VuFileAccess::Random);
+            VuImageInfo        imageInfo{};
+            if (!VuImageDecoder::readInfo(file.bytes(), imageInfo)) {
+                throw std::runtime_error("failed to load texture image!");
+            }
+            texture.format                 = info.format;
+            texture.layout.header.format   = info.format;
+            texture.layout.header.width    = imageInfo.width;
+            texture.layout.header.height   = imageInfo.height;
+            texture.layout.header.mipCount = VuImage::calculateMipLevels(texture.layout.header.width, texture.layout.header.height);
+            texture.layout.mips.resize(texture.layout.header.mipCount);
+            for (uint32 mip = 0U; mip < texture.layout.header.mipCount; mip++) {
+                VuTextureFileMip& mipInfo = texture.layout.mips[mip];
+                mipInfo.width             = std::max(texture.layout.header.width >> mip, 1U);
+                mipInfo.height            = std::max(texture.layout.header.height >> mip, 1U);
+                mipInfo.size              = static_cast<uint64>(mipInfo.width) * mipInfo.height * 4U;
+                mipInfo.offset            = 0U;
+            }
+        }
+
+        texture.tailMip = texture.mipCount() - 1U;
+        for (uint32 mip = 0U; mip < texture.mipCount(); mip++) {
+            if (std::max(texture.layout.mips[mip].width, texture.layout.mips[mip].height) <= createInfo.tailSize) {
+                texture.tailMip = mip;
+                break;
+            }
+        }
+
+        //the finest level a single load can carry through the staging buffer
+        texture.finestMip = 0U;
+        while (texture.finestMip < texture.tailMip && ((texture.layout.mips[texture.finestMip].size + 15U) & ~static_cast<VkDeviceSize>(15U)) > createInfo.stagingSize) {
+            texture.finestMip++;
+        }
+
+        texture.residentMip      = texture.mipCount();
+        texture.requestedMip     = texture.tailMip;
+        texture.lastRequestFrame = frameIndex;
+        texture.retryFrame       = 0U;
+        texture.loadPending      = false;
+
+        VuTexture* gpuTexture  = texture.handle.createHandle();
+        gpuTexture->image       = VK_NULL_HANDLE;
+        gpuTexture->imageMemory = VK_NULL_HANDLE;
+        gpuTexture->imageView   = placeholderView;
+        gpuTexture->width       = 1U;
+        gpuTexture->height      = 1U;
+        gpuTexture->mipLevels   = 1U;
+        VuResourceManager::writeSampledImageToGlobalPool(texture.handle.index, placeholderView);
+        texture.slot        = texture.handle;
+        texture.visibleSlot = texture.handle;
+
+        VuHandle<VuTexture> handle = texture.handle;
+        slotOwners[handle.index]   = handle.index;
+        VuStreamedTexture&  stored = textures.insert_or_assign(handle.index, std::move(texture)).first->second;
+        enqueueLoad(stored, stored.tailMip, stored.mipCount());
+        return handle;
+    }
+
+    void VuTextureStreamer::linkSlot(VuHandle<VuTexture> texture, uint32& slotField) {
+        auto it = textures.find(texture.index);
+        if (it == textures.end()) {
+            slotField = texture.index;
+            return;
+        }
+        slotField = it->second.visibleSlot.index;
+        it->second.slotLinks.push_back(&slotField);
+    }
+
+    void VuTextureStreamer::requestScreenSize(uint32 slotIndex, float screenPixels) {
+        auto owner = slotOwners.find(slotIndex);
+        if (owner == slotOwners.end()) {
+            return;
+        }
+        auto it = textures.find(owner->second);
+        if (it == textures.end()) {
+            return;
+        }
+        VuStreamedTexture& texture = it->second;
+
+        const float maxDimension = static_cast<float>(std::max(texture.layout.header.width, texture.layout.header.height));
+        uint32      desiredMip   = texture.tailMip;
+        if (screenPixels >= 1.0F) {
+            const float level = std::floor(std::log2(maxDimension / screenPixels));
+            desiredMip        = static_cast<uint32>(std::clamp(level, static_cast<float>(texture.finestMip), static_cast<float>(texture.tailMip)));
+        }
+
+        texture.requestedMip     = std::min(texture.requestedMip, desiredMip);
+        texture.lastRequestFrame = frameIndex;
+    }
+
+    void VuTextureStreamer::update() {
+        frameIndex++;
+
+        //views and slots swapped out earlier are no longer referenced by any frame in flight or upload
+        std::erase_if(pendingReleases, [this](PendingRelease& release) {
+            const bool uploaded = release.uploadFence == VK_NULL_HANDLE || vkGetFenceStatus(ctx::vuDevice->device, release.uploadFence) == VK_SUCCESS;
+            if (release.releaseFrame > frameIndex || !uploaded) {
+                return false;
+            }
+            if (release.image != VK_NULL_HANDLE) {
+                vkDestroyImageView(ctx::vuDevice->device, release.view, nullptr);
+                vkDestroyImage(ctx::vuDevice->device, release.image, nullptr);
+                arena.free(release.range);
+            }
+            if (release.slot.index != UINT32_MAX) {
+                slotOwners.erase(release.slot.index);
+                release.slot.destroyHandle();
+            }
+            return true;
+        });
+        applyRepoints();
+
+        //the slot was submitted MAX_FRAMES_IN_FLIGHT uploads ago. while the gpu is still copying out of its
+        //staging the finished loads wait for a later frame instead of the cpu waiting for the gpu
+        UploadSlot& slot = uploadSlots[uploadSlotIndex];
+        if (vkGetFenceStatus(ctx::vuDevice->device, slot.fence) == VK_SUCCESS) {
+            for (uint32 uploads = 0U; uploads < createInfo.maxUploadsPerFrame; uploads++) {
+                LoadResult result;
+                {
+                    std::lock_guard lock(resultMutex);
+                    //a result that does not fit behind the earlier uploads goes first into the next slot
+                    const bool fits = !results.empty()
+                                      && (slot.stagingOffset == 0U || slot.stagingOffset + stagingSizeOf(results.front()) <= createInfo.stagingSize);
+                    if (!fits) {
+                        break;
+                    }
+                    result = std::move(results.front());
+                    results.pop_front();
+                }
+                processResult(result, slot);
+            }
+            submitUploads(slot);
+        }
+
+        for (auto& [index, texture]: textures) {
+            if (!texture.loadPending && frameIndex >= texture.retryFrame) {
+                const bool requestedRecently = texture.lastRequestFrame + 1U >= frameIndex;
+                if (texture.residentMip == texture.mipCount()) {
+                    enqueueLoad(texture, texture.tailMip, texture.mipCount());
+                } else if (requestedRecently && texture.requestedMip < texture.residentMip) {
+                    enqueueLoad(texture, texture.requestedMip, texture.residentMip);
+                }
+            }
+            texture.requestedMip = texture.tailMip;
+        }
+    }
+
+    VuTextureStreamerStats VuTextureStreamer::getStats() const {
+        VuTextureStreamerStats stats{};
+        stats.residentBytes = arena.usedSize;
+        stats.budgetBytes   = createInfo.vramBudget;
+        stats.textureCount  = static_cast<uint32>(textures.size());
+        stats.evictions     = evictionCount;
+        for (const auto& [index, texture]: textures) {
+            if (texture.residentMip == 0U) {
+                stats.fullyResidentCount++;
+            }
+            if (texture.loadPending) {
+                stats.pendingLoads++;
+            }
+        }
+        return stats;
+    }
+
+    float VuTextureStreamer::projectedDiameter(const float3& worldCenter,
+                                               float         worldRadius,
+                                               const float3& cameraPos,
+                                               float         fovYRadians,
+                                               float         viewportHeight) {
+        const float distance = glm::length(worldCenter - cameraPos);
+        if (distance <= worldRadius) {
+            return viewportHeight;
+        }
+        return worldRadius / (distance * std::tan(fovYRadians * 0.5F)) * viewportHeight;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+    void VuTextureStreamer::runLoad(const LoadJob& job) {
+        VU_CPU_ZONE("load texture");
+        LoadResult result{job.textureIndex, job.firstMip, job.endMip, {}, {}, {}};
+        try {
+            loadLevels(job, result);
+        } catch (const std::exception& e) {
+            std::cout << "VuTextureStreamer: " << e.what() << std::endl;
+            result.levels.clear();
+        }
+
+        std::lock_guard lock(resultMutex);
+        results.push_back(std::move(result));
+    }
+
+    void VuTextureStreamer::loadLevels(const LoadJob& job, LoadResult& result) {
+        result.levels.reserve(job.endMip - job.firstMip);
+
+        if (job.fromContainer) {
+            //the upload copies straight out of the mapping. the levels are read here, on the worker, so the main
+            //thread never waits on a page fault
+            result.file.open(job.path, VuFileAccess::Random);
+            const auto [offset, size] = VuTextureContainer::getMipRange(job.layout, job.firstMip, job.endMip);
+            result.file.prefetch(offset, size);
+            result.file.touch(offset, size);
+            for (uint32 mip = job.firstMip; mip < job.endMip; mip++) {
+                result.levels.push_back(VuTextureContainer::getMipData(result.file.bytes(), job.layout, mip));
+            }
+            return;
+        }
+
+        //source images have no stored mips and stb only decodes at full resolution, so level 0 is decoded even
+        //for the tail. the chain is rebuilt from it down to the last requested level, a level above firstMip is
+        //dropped as soon as the next one is built unless the cache takes the whole chain
+        const bool storeChain = job.cacheKey != 0U && job.endMip == job.layout.header.mipCount;
+
+        std::vector<std::vector<uint8>> chain(job.endMip);
+        {
+            const VuMappedFile file(job.path, VuFileAccess::Sequential);
+            VuImageInfo        imageInfo{};
+            if (!VuImageDecoder::readInfo(file.bytes(), imageInfo)) {
+                throw std::runtime_error("failed to load texture image!");
+            }
+            std::vector<uint8>& level = chain[0];
+            level.resize(VuImageDecoder::byteSizeOf(imageInfo, 0U));
+            VuImageDecoder::decodeRGBA8(file.bytes(), imageInfo, {level, 0U, true});
+            level.resize(static_cast<size_t>(imageInfo.width) * imageInfo.height * 4U);
+        }
+
+        const bool srgb = job.layout.header.format == VK_FORMAT_R8G8B8A8_SRGB || job.layout.header.format == VK_FORMAT_B8G8R8A8_SRGB;
+        for (uint32 mip = 0U; mip + 1U < job.endMip; mip++) {
+            chain[mip + 1U] = VuTextureContainer::downsampleRGBA8(chain[mip], job.layout.mips[mip].width, job.layout.mips[mip].height, srgb);
+            if (!storeChain && mip < job.firstMip) {
+                chain[mip] = {};
+            }
+        }
+
+        //the tail load builds the whole chain anyway, the cache gets all of it. the texture then switches over to
+        //the bake, so detail loads read only their levels instead of decoding the source again
+        if (storeChain) {
+            VuAssetCache::store(job.cacheKey, ".vutex", [&](const std::filesystem::path& path) {
+                VuTextureContainer::write(path, static_cast<VkFormat>(job.layout.header.format), job.layout.header.width, job.layout.header.height, chain);
+            });
+            try {
+                const std::filesystem::path baked = VuAssetCache::find(job.cacheKey, ".vutex");
+                if (!baked.empty()) {
+                    result.bakedLayout = VuTextureContainer::readLayout(baked);
+                    result.bakedPath   = baked;
+                }
+            } catch (const std::exception& e) {
+                std::cout << "VuTextureStreamer: " << e.what() << std::endl;
+            }
+        }
+
+        for (uint32 mip = job.firstMip; mip < job.endMip; mip++) {
+            result.decoded.push_back(std::move(chain[mip]));
+        }
+        for (const std::vector<uint8>& level: result.decoded) {
+            result.levels.emplace_back(level);
+        }
+    }
+
+    void VuTextureStreamer::enqueueLoad(VuStreamedTexture& texture, uint32 firstMip, uint32 endMip) {
+        //a load has to fit into one upload's staging. larger requests stop at the finest level that fits, the
+        //next update() asks for the levels above it, so a big texture streams in over several frames
+        VkDeviceSize stagingBytes = 0U;
+        uint32       fittingMip   = endMip;
+        while (fittingMip > firstMip) {
+            const VkDeviceSize levelBytes = (texture.layout.mips[fittingMip - 1U].size + 15U) & ~static_cast<VkDeviceSize>(15U);
+            if (stagingBytes + levelBytes > createInfo.stagingSize) {
+                break;
+            }
+            stagingBytes += levelBytes;
+            fittingMip--;
+        }
+        //the tail is uploaded as one image, requests never go above finestMip
+        if (endMip == texture.mipCount() && fittingMip != firstMip) {
+            std::cout << "VuTextureStreamer: the mip tail of " << texture.path.string() << " is larger than the staging size, it is not streamed" << std::endl;
+            texture.retryFrame = UINT64_MAX;
+            return;
+        }
+        firstMip = fittingMip;
+
+        texture.loadPending = true;
+        //the job gets its own copy of the layout so it never touches the texture map
+        VuJobSystem::runBackground([this, job = LoadJob{texture.handle.index, firstMip, endMip, texture.path, texture.fromContainer, texture.layout, texture.cacheKey}] {
+            runLoad(job);
+        }, &loadCounter);
+        //stored by the first full decode only
+        if (endMip == texture.mipCount()) {
+            texture.cacheKey = 0U;
+        }
+    }
+
+    bool VuTextureStreamer::processResult(LoadResult& result, UploadSlot& slot) {
+        auto it = textures.find(result.textureIndex);
+        if (it == textures.end()) {
+            return false;
+        }
+        VuStreamedTexture& texture = it->second;
+        texture.loadPending        = false;
+        if (!result.bakedPath.empty()) {
+            texture.path          = result.bakedPath;
+            texture.fromContainer = true;
+            texture.layout        = std::move(result.bakedLayout);
+        }
+
+        if (result.levels.empty()) {
+            texture.retryFrame = frameIndex + 60U;
+            return false;
+        }
+        //evicted while the load was in flight, the loaded levels no longer connect to what is resident
+        if (result.endMip != texture.residentMip) {
+            return false;
+        }
+
+        VkImage       newImage;
+        VuMemoryRange newRange;
+        if (!allocateImage(texture, result.firstMip, newImage, newRange)) {
+            //evicted memory comes back once the frames in flight are done with it
+            texture.retryFrame = frameIndex + config::MAX_FRAMES_IN_FLIGHT + 1U;
+            return false;
+        }
+
+        const bool tailLoad    = texture.residentMip == texture.mipCount();
+        VkImage    srcImage    = VK_NULL_HANDLE;
+        uint32     srcFirstMip = texture.residentMip;
+        if (!tailLoad) {
+            srcImage = texture.image != VK_NULL_HANDLE ? texture.image : texture.tailImage;
+        }
+        uploadLevels(texture, newImage, result.firstMip, result, srcImage, srcFirstMip, slot);
+
+        const uint32 levelCount = texture.mipCount() - result.firstMip;
+        VkImageView  newView;
+        VuImage::createImageView(texture.format, newImage, VK_IMAGE_ASPECT_COLOR_BIT, newView, levelCount);
+
+        PendingRelease replaced{};
+        if (tailLoad) {
+            texture.tailImage = newImage;
+            texture.tailView  = newView;
+            texture.tailRange = newRange;
+        } else {
+            if (texture.image != VK_NULL_HANDLE) {
+                replaced = releaseOf(texture.image, texture.view, texture.range);
+            }
+            texture.image = newImage;
+            texture.view  = newView;
+            texture.range = newRange;
+        }
+        texture.residentMip = result.firstMip;
+
+        swapView(texture, newView, slot.fence, replaced);
+        VuTexture* gpuTexture = texture.handle.get();
+        gpuTexture->image     = newImage;
+        gpuTexture->imageView = newView;
+        gpuTexture->width     = texture.layout.mips[result.firstMip].width;
+        gpuTexture->height    = texture.layout.mips[result.firstMip].height;
+        gpuTexture->mipLevels = levelCount;
+        *texture.slot.get()   = *gpuTexture;
+        return true;
+    }
+
+    bool VuTextureStreamer::allocateImage(VuStreamedTexture& texture, uint32 firstMip, VkImage& outImage, VuMemoryRange& outRange) {
+        const VuTextureFileMip& mipInfo = texture.layout.mips[firstMip];
+
+        VkImageCreateInfo imageInfo{};
+        imageInfo.sType         = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType     = VK_IMAGE_TYPE_2D;
+        imageInfo.extent        = {mipInfo.width, mipInfo.height, 1U};
+        imageInfo.mipLevels     = texture.mipCount() - firstMip;
+        imageInfo.arrayLayers   = 1;
+        imageInfo.format        = texture.format;
+        imageInfo.tiling        = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        imageInfo.usage         = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+        imageInfo.samples       = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.sharingMode   = VK_SHARING_MODE_EXCLUSIVE;
+        VkCheck(vkCreateImage(ctx::vuDevice->device, &imageInfo, nullptr, &outImage));
+
+        VkMemoryRequirements memRequirements;
+        vkGetImageMemoryRequirements(ctx::vuDevice->device, outImage, &memRequirements);
+
+        if (!arenaReady) {
+            arena.init(createInfo.vramBudget, memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+            arenaReady = true;
+        }
+        if (!arena.isCompatible(memRequirements)) {
+            throw std::runtime_error("streamed texture needs a memory type outside of the streaming arena!");
+        }
+
+        if (!arena.allocate(memRequirements, outRange)) {
+            //make enough room for the next attempt, pending releases already count as free
+            VkDeviceSize reclaimable = arena.capacity - arena.usedSize;
+            for (const PendingRelease& release: pendingReleases) {
+                reclaimable += release.range.size;
+            }
+            for (const PendingRepoint& repoint: pendingRepoints) {
+                reclaimable += repoint.replaced.range.size;
+            }
+            while (reclaimable < memRequirements.size + memRequirements.alignment && evictLeastRecentlyUsed(texture.handle.index)) {
+                reclaimable += pendingRepoints.back().replaced.range.size;
+            }
+            vkDestroyImage(ctx::vuDevice->device, outImage, nullptr);
+            return false;
+        }
+
+        VkCheck(vkBindImageMemory(ctx::vuDevice->device,
+                                  outImage,
+                                  arena.memory,
+                                  VuMemoryArena::alignedOffset(outRange, memRequirements.alignment)));
+        return true;
+    }
+
+    bool VuTextureStreamer::evictLeastRecentlyUsed(uint32 exceptIndex) {
+        VuStreamedTexture* victim = nullptr;
+        for (auto& [index, texture]: textures) {
+            if (index == exceptIndex || texture.image == VK_NULL_HANDLE) {
+                continue;
+            }
+            if (texture.lastRequestFrame + createInfo.evictAfterFrames >= frameIndex) {
+                continue;
+            }
+            if (victim == nullptr || texture.lastRequestFrame < victim->lastRequestFrame) {
+                victim = &texture;
+            }
+        }
+        if (victim == nullptr) {
+            return false;
+        }
+
+        //back to the permanent tail, uploaded long ago, the detailed image is freed once no frame uses it
+        swapView(*victim, victim->tailView, VK_NULL_HANDLE, releaseOf(victim->image, victim->view, victim->range));
+        VuTexture* gpuTexture = victim->handle.get();
+        gpuTexture->image     = victim->tailImage;
+        gpuTexture->imageView = victim->tailView;
+        gpuTexture->width     = victim->layout.mips[victim->tailMip].width;
+        gpuTexture->height    = victim->layout.mips[victim->tailMip].height;
+        gpuTexture->mipLevels = victim->mipCount() - victim->tailMip;
+        *victim->slot.get()   = *gpuTexture;
+
+        victim->image       = VK_NULL_HANDLE;
+        victim->view        = VK_NULL_HANDLE;
+        victim->residentMip = victim->tailMip;
+        evictionCount++;
+        return true;
+    }
+
+    void VuTextureStreamer::uploadLevels(const VuStreamedTexture& texture,
+                                         VkImage                  dstImage,
+                                         uint32                   dstFirstMip,
+                                         const LoadResult&        result,
+                                         VkImage                  srcImage,
+                                         uint32                   srcFirstMip,
+                                         UploadSlot&              slot) {
+        //enqueueLoad keeps a load within the staging size, update() only hands over results that fit behind the
+        //earlier uploads of the slot
+
+        std::vector<VkBufferImageCopy> bufferCopies;
+        VkDeviceSize&                  stagingOffset = slot.stagingOffset;
+        for (uint32 mip = result.firstMip; mip < result.endMip; mip++) {
+            const std::span<const uint8> level = result.levels[mip - result.firstMip];
+            slot.staging.setData(level.data(), level.size(), stagingOffset);
+
+            VkBufferImageCopy region{};
+            region.bufferOffset                = stagingOffset;
+            region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            region.imageSubresource.mipLevel   = mip - dstFirstMip;
+            region.imageSubresource.layerCount = 1;
+            region.imageExtent                 = {texture.layout.mips[mip].width, texture.layout.mips[mip].height, 1};
+            bufferCopies.push_back(region);
+
+            stagingOffset = (stagingOffset + level.size() + 15U) & ~static_cast<VkDeviceSize>(15U);
+        }
+
+        //levels that are already resident move over on the gpu, no disk or staging traffic
+        std::vector<VkImageCopy> imageCopies;
+        if (srcImage != VK_NULL_HANDLE) {
+            for (uint32 mip = srcFirstMip; mip < texture.mipCount(); mip++) {
+                VkImageCopy region{};
+                region.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, mip - srcFirstMip, 0, 1};
+                region.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, mip - dstFirstMip, 0, 1};
+                region.extent         = {texture.layout.mips[mip].width, texture.layout.mips[mip].height, 1};
+                imageCopies.push_back(region);
+            }
+        }
+
+        VkImageMemoryBarrier barriers[2]{};
+        barriers[0].sType                           = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barriers[0].srcQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+        barriers[0].dstQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+        barriers[0].subresourceRange.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+        barriers[0].subresourceRange.levelCount     = VK_REMAINING_MIP_LEVELS;
+        barriers[0].subresourceRange.layerCount     = 1;
+        barriers[1]                                 = barriers[0];
+
+        barriers[0].image         = dstImage;
+        barriers[0].oldLayout     = VK_IMAGE_LAYOUT_UNDEFINED;
+        barriers[0].newLayout     = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barriers[0].srcAccessMask = 0;
+        barriers[0].dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+        barriers[1].image         = srcImage;
+        barriers[1].oldLayout     = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        barriers[1].newLayout     = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barriers[1].srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barriers[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+        const uint32 barrierCount = srcImage != VK_NULL_HANDLE ? 2U : 1U;
+
+        if (!slot.recording) {
+            VkCommandBufferBeginInfo beginInfo{};
+            beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+            beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+            VkCheck(vkBeginCommandBuffer(slot.commandBuffer, &beginInfo));
+            slot.recording = true;
+        }
+        VkCommandBuffer commandBuffer = slot.commandBuffer;
+        vkCmdPipelineBarrier(commandBuffer,
+                             VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             0, 0, nullptr, 0, nullptr,
+                             barrierCount, barriers);
+
+        vkCmdCopyBufferToImage(commandBuffer,
+                               slot.staging.buffer,
+                               dstImage,
+                               VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                               static_cast<uint32>(bufferCopies.size()),
+                               bufferCopies.data());
+        if (!imageCopies.empty()) {
+            vkCmdCopyImage(commandBuffer,
+                           srcImage,
+                           VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                           dstImage,
+                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                           static_cast<uint32>(imageCopies.size()),
+                           imageCopies.data());
+        }
+
+        for (VkImageMemoryBarrier& barrier: barriers) {
+            barrier.srcAccessMask = barrier.dstAccessMask;
+            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+            barrier.oldLayout     = barrier.newLayout;
+            barrier.newLayout     = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        }
+        vkCmdPipelineBarrier(commandBuffer,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                             0, 0, nullptr, 0, nullptr,
+                             barrierCount, barriers);
+    }
+
+    VkDeviceSize VuTextureStreamer::stagingSizeOf(const LoadResult& result) {
+        VkDeviceSize size = 0U;
+        for (const std::span<const uint8> level: result.levels) {
+            size = (size + level.size() + 15U) & ~static_cast<VkDeviceSize>(15U);
+        }
+        return size;
+    }
+
+    void VuTextureStreamer::submitUploads(UploadSlot& slot) {
+        if (!slot.recording) {
+            return;
+        }
+        VU_CPU_ZONE("submit texture uploads");
+        VkCheck(vkEndCommandBuffer(slot.commandBuffer));
+
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers    = &slot.commandBuffer;
+
+        //same queue as the frames and submitted ahead of this frame's, the barriers order the copies before sampling
+        VkCheck(vkResetFences(ctx::vuDevice->device, 1, &slot.fence));
+        VkCheck(vkQueueSubmit(ctx::vuDevice->graphicsQueue, 1, &submitInfo, slot.fence));
+
+        slot.recording     = false;
+        slot.stagingOffset = 0U;
+        uploadSlotIndex    = (uploadSlotIndex + 1U) % static_cast<uint32>(uploadSlots.size());
+    }
+
+    void VuTextureStreamer::swapView(VuStreamedTexture& texture, VkImageView view, VkFence uploadFence, const PendingRelease& replaced) {
+        //a fresh slot is not read by any frame in flight, so it can be written right away
+        VuHandle<VuTexture> slot{};
+        slot.createHandle()->imageView = view;
+        VuResourceManager::writeSampledImageToGlobalPool(slot.index, view);
+        slotOwners[slot.index] = texture.handle.index;
+
+        texture.slot = slot;
+        pendingRepoints.push_back({texture.handle.index, slot, frameIndex, uploadFence, replaced});
+    }
+
+    void VuTextureStreamer::applyRepoints() {
+        //in order, a texture swapped twice in a row repoints twice
+        while (!pendingRepoints.empty()) {
+            PendingRepoint& repoint = pendingRepoints.front();
+            //the beginFrame after the swap flushed the slot's descriptor
+            const bool flushed  = repoint.queuedFrame < frameIndex;
+            const bool uploaded = repoint.uploadFence == VK_NULL_HANDLE || vkGetFenceStatus(ctx::vuDevice->device, repoint.uploadFence) == VK_SUCCESS;
+            if (!flushed || !uploaded) {
+                break;
+            }
+
+            PendingRelease release = repoint.replaced;
+            auto           it      = textures.find(repoint.textureIndex);
+            if (it != textures.end()) {
+                VuStreamedTexture& texture = it->second;
+                for (uint32* link: texture.slotLinks) {
+                    *link = repoint.slot.index;
+                }
+                //the first slot is the texture's id and stays, it keeps showing the placeholder
+                if (texture.visibleSlot.index != texture.handle.index) {
+                    release.slot = texture.visibleSlot;
+                }
+                texture.visibleSlot = repoint.slot;
+            }
+            //frames recorded from here on read the new slot, the ones in flight may still read the old one
+            release.releaseFrame = frameIndex + config::MAX_FRAMES_IN_FLIGHT + 1U;
+            pendingReleases.push_back(release);
+            pendingRepoints.pop_front();
+        }
+    }
+
+    VuTextureStreamer::PendingRelease VuTextureStreamer::releaseOf(VkImage image, VkImageView view, const VuMemoryRange& range) {
+        //only the slot recorded by this update() copies from or into images it releases
+        PendingRelease release{};
+        release.image       = image;
+        release.view        = view;
+        release.range       = range;
+        release.uploadFence = uploadSlots[uploadSlotIndex].fence;
+        return release;
+    }
+
+    void VuTextureStreamer::createPlaceholder() {
+        //mid gray, its xy also decodes to a flat tangent space normal
+        constexpr uint8 texel[4] = {128U, 128U, 128U, 255U};
+        VuBuffer::globalStagingBuffer->setData(texel, sizeof(texel));
+
+        VuImage::createImage(1U, 1U, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_TILING_OPTIMAL,
+                             VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+                             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                             placeholderImage,
+                             placeholderMemory);
+        VuImage::transitionImageLayout(placeholderImage, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+        VuImage::copyBufferToImage(VuBuffer::globalStagingBuffer->buffer, placeholderImage, 1U, 1U);
+        VuImage::transitionImageLayout(placeholderImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        VuImage::createImageView(VK_FORMAT_R8G8B8A8_UNORM, placeholderImage, VK_IMAGE_ASPECT_COLOR_BIT, placeholderView);
+    }
+}
@@ -0,0 +1,235 @@
+#pragma once
+
+#include <array>
+#include <deque>
+#include <mutex>
+#include <span>
+#include <unordered_map>
+
+#include "Common.h"
+#include "VuConfig.h"
+#include "VuFile.h"
+#include "VuJobSystem.h"
+#include "VuMemoryArena.h"
+#include "VuResourceManager.h"
+#include "VuTexture.h"
+#include "VuTextureContainer.h"
+
+namespace Vu {
+
+    struct VuTextureStreamerCreateInfo {
+        //every streamed image is placed into this budget, the permanent mip tails included
+        VkDeviceSize vramBudget = 256U * 1024U * 1024U;
+        //levels whose larger side is at most this many texels are loaded first and never evicted
+        uint32 tailSize = 64U;
+        //completed disk loads turned into gpu uploads per update(), recorded into a single submission
+        uint32 maxUploadsPerFrame = 8U;
+        //staging memory of one such submission. a load takes at most this much, larger mip ranges stream in over
+        //several loads and a texture whose tail alone is larger is never streamed
+        VkDeviceSize stagingSize = 64U * 1024U * 1024U;
+        //a texture that was not requested for this many frames can be evicted down to its tail
+        uint32 evictAfterFrames = 2U;
+    };
+
+    struct VuTextureStreamerStats {
+        VkDeviceSize residentBytes;
+        VkDeviceSize budgetBytes;
+        uint32       textureCount;
+        uint32       fullyResidentCount;
+        uint32       pendingLoads;
+        uint32       evictions;
+    };
+
+    //residency state of a single texture, mip indices always refer to the full chain of the source
+    struct VuStreamedTexture {
+        std::filesystem::path path;
+        VkFormat              format;
+        bool                  fromContainer;
+        VuTextureFile         layout;
+        //VuAssetCache key the decoded mip chain is stored under, 0 when it is not stored
+        uint64                cacheKey = 0U;
+        VuHandle<VuTexture>   handle;
+        uint32                tailMip;
+        //levels above it do not fit into an upload's staging and are never requested
+        uint32                finestMip;
+
+        //bindless slots, handle.index is the first one. a view swap writes a fresh slot, slot is the newest and
+        //visibleSlot the one the linked material fields hold until the swap can be seen by the gpu
+        VuHandle<VuTexture>  slot;
+        VuHandle<VuTexture>  visibleSlot;
+        std::vector<uint32*> slotLinks;
+
+        //mip count means nothing is resident yet
+        uint32 residentMip;
+        uint32 requestedMip;
+        uint64 lastRequestFrame;
+        uint64 retryFrame;
+        bool   loadPending;
+
+        //permanent image holding tailMip..last
+        VkImage       tailImage = VK_NULL_HANDLE;
+        VkImageView   tailView  = VK_NULL_HANDLE;
+        VuMemoryRange tailRange{};
+
+        //streamed image holding residentMip..last, only exists while residentMip < tailMip
+        VkImage       image = VK_NULL_HANDLE;
+        VkImageView   view  = VK_NULL_HANDLE;
+        VuMemoryRange range{};
+
+        uint32 mipCount() const {
+            return layout.header.mipCount;
+        }
+    };
+
+    //loads the smallest mips of every texture first, then streams detail in the background
+    //based on the projected screen size, under a fixed vram budget with lru eviction.
+    //disk reads and decodes run as jobs, so a batch of registrations decodes on every worker at once.
+    //a live bindless slot is never rewritten: a new view goes into a fresh slot, the materials linked to the
+    //texture are pointed at it and the old slot is retired once no frame in flight can read it
+    struct VuTextureStreamer {
+    public:
+        void init(const VuTextureStreamerCreateInfo& info);
+
+        void uninit();
+
+        //returns immediately, the slot shows a placeholder until the tail is uploaded
+        VuHandle<VuTexture> registerTexture(const VuTextureCreateInfo& info);
+
+        //writes the texture's bindless slot into slotField and keeps it current across view swaps. slotField
+        //usually lives in a material data block and has to stay valid as long as the streamer
+        void linkSlot(VuHandle<VuTexture> texture, uint32& slotField);
+
+        //call for every visible use of a texture by any of its slots, the finest request of a frame wins
+        void requestScreenSize(uint32 slotIndex, float screenPixels);
+
+        //pick up finished loads, upload them, evict and queue new loads. call once per frame before recording
+        void update();
+
+        VuTextureStreamerStats getStats() const;
+
+        //diameter in pixels of a bounding sphere seen through a perspective camera
+        static float projectedDiameter(const float3& worldCenter,
+                                       float         worldRadius,
+                                       const float3& cameraPos,
+                                       float         fovYRadians,
+                                       float         viewportHeight);
+
+    private:
+        struct LoadJob {
+            uint32                textureIndex;
+            uint32                firstMip;
+            uint32                endMip;
+            std::filesystem::path path;
+            bool                  fromContainer;
+            VuTextureFile         layout;
+            uint64                cacheKey;
+        };
+
+        struct LoadResult {
+            uint32                              textureIndex;
+            uint32                              firstMip;
+            uint32                              endMip;
+            //firstMip..endMip, pointing into file for containers and into decoded for source images
+            std::vector<std::span<const uint8>> levels;
+            VuMappedFile                        file;
+            std::vector<std::vector<uint8>>     decoded;
+            //set when the decoded chain was stored in the asset cache, later loads read from there
+            std::filesystem::path               bakedPath;
+            VuTextureFile                       bakedLayout;
+        };
+
+        //uploads of one update() share a staging buffer and one submission. the slot is recorded again only once
+        //its fence signaled, until then finished loads stay queued and the cpu never waits on the copies
+        struct UploadSlot {
+            VuBuffer        staging{};
+            VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+            VkFence         fence         = VK_NULL_HANDLE;
+            VkDeviceSize    stagingOffset = 0U;
+            bool            recording     = false;
+        };
+
+        struct PendingRelease {
+            //null when only a slot is released
+            VkImage       image = VK_NULL_HANDLE;
+            VkImageView   view  = VK_NULL_HANDLE;
+            VuMemoryRange range{};
+            //index UINT32_MAX when no slot is released
+            VuHandle<VuTexture> slot{UINT32_MAX, 0U};
+            uint64              releaseFrame = 0U;
+            //the upload submission that last copied from or into the image, VK_NULL_HANDLE for none
+            VkFence             uploadFence = VK_NULL_HANDLE;
+        };
+
+        //a swapped in slot becomes visible to the materials once its descriptor was flushed by a beginFrame and
+        //its upload finished, the frames in flight read the material data as it is written
+        struct PendingRepoint {
+            uint32              textureIndex;
+            VuHandle<VuTexture> slot;
+            uint64              queuedFrame;
+            //VK_NULL_HANDLE for a view that was uploaded long ago
+            VkFence             uploadFence;
+            //the image the swap replaced, it stays in use until the repoint
+            PendingRelease      replaced;
+        };
+
+        VuTextureStreamerCreateInfo createInfo{};
+        VuMemoryArena               arena{};
+        bool                        arenaReady = false;
+
+        VkImage        placeholderImage  = VK_NULL_HANDLE;
+        VkDeviceMemory placeholderMemory = VK_NULL_HANDLE;
+        VkImageView    placeholderView   = VK_NULL_HANDLE;
+
+        std::array<UploadSlot, config::MAX_FRAMES_IN_FLIGHT> uploadSlots{};
+        uint32                                               uploadSlotIndex = 0U;
+
+        std::unordered_map<uint32, VuStreamedTexture> textures;
+        std::vector<PendingRelease>                   pendingReleases;
+        std::deque<PendingRepoint>                    pendingRepoints;
+        //bindless slot -> texture index, every slot of a texture until it is retired
+        std::unordered_map<uint32, uint32>            slotOwners;
+        uint64                                        frameIndex = 0U;
+        uint32                                        evictionCount = 0U;
+
+        VuJobCounter           loadCounter{};
+        std::mutex             resultMutex;
+        std::deque<LoadResult> results;
+
+        //runs as a background job
+        void runLoad(const LoadJob& job);
+
+        static void loadLevels(const LoadJob& job, LoadResult& result);
+
+        void enqueueLoad(VuStreamedTexture& texture, uint32 firstMip, uint32 endMip);
+
+        bool processResult(LoadResult& result, UploadSlot& slot);
+
+        bool allocateImage(VuStreamedTexture& texture, uint32 firstMip, VkImage& outImage, VuMemoryRange& outRange);
+
+        bool evictLeastRecentlyUsed(uint32 exceptIndex);
+
+        //writes view into a fresh slot of texture, the linked materials follow in a later update()
+        void swapView(VuStreamedTexture& texture, VkImageView view, VkFence uploadFence, const PendingRelease& replaced);
+
+        void applyRepoints();
+
+        void uploadLevels(const VuStreamedTexture& texture,
+                          VkImage                  dstImage,
+                          uint32                   dstFirstMip,
+                          const LoadResult&        result,
+                          VkImage                  srcImage,
+                          uint32                   srcFirstMip,
+                          UploadSlot&              slot);
+
+        //bytes of staging the levels of result take
+        static VkDeviceSize stagingSizeOf(const LoadResult& result);
+
+        //submits the recorded uploads without waiting, the next update() records into the next slot
+        void submitUploads(UploadSlot& slot);
+
+        //what replacing image needs to release, handed to swapView
+        PendingRelease releaseOf(VkImage image, VkImageView view, const VuMemoryRange& range);
+
+        void createPlaceholder();
+    };
+}
@@ -18,11 +18,14 @@ namespace Vu {
         uint32_t baseColorTexture;
         uint32_t normalTexture;
         float3   baseColorMul;
-        uint32_t padding[11];
+        uint32_t sampler;
+        uint32_t padding[10];
     };
 
+    //the model matrix is transformBuffer[transformIndex], see VuTransformSystem
     struct GPU_PushConstant {
-        float4x4 trs;
+        uint32   transformBufferIndex;
+        uint32   transformIndex;
         uint32   materialBlockIndex;
         GPU_Mesh mesh;
     };
@@ -79,8 +82,13 @@ namespace Vu {
                     indices.graphicsFamily = i;
                 }
 
+                //headless has no surface, the present queue is only a stand in for the graphics queue then
                 VkBool32 presentSupport = false;
-                vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
+                if (surface != VK_NULL_HANDLE) {
+                    vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
+                } else {
+                    presentSupport = (queuefamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0U;
+                }
 
                 if (presentSupport) {
                     indices.presentFamily = i;
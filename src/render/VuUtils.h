@@ -6,21 +6,6 @@
 namespace Vu {
 
 
-    inline std::vector<char> readFile(const std::filesystem::path& path) {
-        std::ifstream file(path, std::ios::ate | std::ios::binary);
-
-        if (!file.is_open()) {
-            throw std::runtime_error("failed to open file!");
-        }
-
-        size_t            fileSize = (size_t) file.tellg();
-        std::vector<char> buffer(fileSize);
-        file.seekg(0);
-        file.read(buffer.data(), fileSize);
-        file.close();
-        return buffer;
-    }
-
     inline void createFile(const std::filesystem::path& path, std::span<const uint8_t> data) {
         std::ofstream file(path, std::ios::binary | std::ios::out);
         if (!file.is_open()) {
@@ -0,0 +1,146 @@
+#include "VuScene.h"
+
+#include <cstring>
+
+namespace Vu {
+
+    void VuScene::init(const VuSceneCreateInfo& info) {
+        transformSystem.init(info.transformInfo);
+        archetypes.clear();
+        records.clear();
+        freeIndices = {};
+        //entities without components
+        getOrCreateArchetype(0U);
+    }
+
+    void VuScene::uninit() {
+        transformSystem.uninit();
+        archetypes.clear();
+        records.clear();
+    }
+
+    VuEntity VuScene::createEntity(const Transform& local, VuEntity parent) {
+        const uint32 parentTransform = parent.isNull() ? VuTransformSystem::NO_PARENT : getRecord(parent).transform;
+
+        uint32 index = 0U;
+        if (!freeIndices.empty()) {
+            index = freeIndices.top();
+            freeIndices.pop();
+        } else {
+            index = static_cast<uint32>(records.size());
+            records.emplace_back();
+        }
+
+        EntityRecord& record = records[index];
+        record.archetype     = 0U;
+        record.row           = archetypes[0].size();
+        record.transform     = transformSystem.create(local, parentTransform);
+        record.alive         = true;
+
+        const VuEntity entity{index, record.generation};
+        archetypes[0].entities.push_back(entity);
+        archetypes[0].transforms.push_back(record.transform);
+        return entity;
+    }
+
+    void VuScene::destroyEntity(VuEntity entity) {
+        const EntityRecord& record = getRecord(entity);
+        removeRow(record.archetype, record.row);
+        transformSystem.destroy(record.transform);
+
+        EntityRecord& dead = records[entity.index];
+        dead.alive = false;
+        dead.generation++;
+        freeIndices.push(entity.index);
+    }
+
+    bool VuScene::isAlive(VuEntity entity) const {
+        return entity.index < records.size() && records[entity.index].alive && records[entity.index].generation == entity.generation;
+    }
+
+    void VuScene::setParent(VuEntity entity, VuEntity parent) {
+        const uint32 parentTransform = parent.isNull() ? VuTransformSystem::NO_PARENT : getRecord(parent).transform;
+        transformSystem.setParent(getRecord(entity).transform, parentTransform);
+    }
+
+    uint32 VuScene::getTransformId(VuEntity entity) const {
+        return getRecord(entity).transform;
+    }
+
+    VuTransformSystem& VuScene::getTransformSystem() {
+        return transformSystem;
+    }
+
+    void VuScene::update(uint32 frameSlot) {
+        transformSystem.update(frameSlot);
+    }
+
+    const VuScene::EntityRecord& VuScene::getRecord(VuEntity entity) const {
+        if (!isAlive(entity)) {
+            throw std::runtime_error("entity is not alive!");
+        }
+        return records[entity.index];
+    }
+
+    uint32 VuScene::getOrCreateArchetype(uint32 mask) {
+        //a handful of component combinations exist at once, a linear search beats hashing here
+        for (uint32 i = 0U; i < archetypes.size(); i++) {
+            if (archetypes[i].mask == mask) {
+                return i;
+            }
+        }
+        archetypes.emplace_back().mask = mask;
+        return static_cast<uint32>(archetypes.size() - 1U);
+    }
+
+    void VuScene::moveEntity(uint32 index, uint32 mask) {
+        const uint32 dstIndex = getOrCreateArchetype(mask);
+        EntityRecord& record  = records[index];
+        VuArchetype&  src     = archetypes[record.archetype];
+        VuArchetype&  dst     = archetypes[dstIndex];
+
+        const uint32 dstRow = dst.size();
+        dst.entities.push_back(src.entities[record.row]);
+        dst.transforms.push_back(src.transforms[record.row]);
+        for (uint32 type = 0U; type < COMPONENT_TYPE_COUNT; type++) {
+            if ((dst.mask & (1U << type)) == 0U) {
+                continue;
+            }
+            const uint32 size = COMPONENT_SIZES[type];
+            dst.columns[type].resize(static_cast<size_t>(dst.size()) * size);
+            if ((src.mask & (1U << type)) != 0U) {
+                std::memcpy(dst.columns[type].data() + static_cast<size_t>(dstRow) * size,
+                            src.columns[type].data() + static_cast<size_t>(record.row) * size,
+                            size);
+            }
+        }
+
+        removeRow(record.archetype, record.row);
+        record.archetype = dstIndex;
+        record.row       = dstRow;
+    }
+
+    void VuScene::removeRow(uint32 archetypeIndex, uint32 row) {
+        VuArchetype& archetype = archetypes[archetypeIndex];
+        const uint32 last      = archetype.size() - 1U;
+        if (row != last) {
+            archetype.entities[row]   = archetype.entities[last];
+            archetype.transforms[row] = archetype.transforms[last];
+            records[archetype.entities[row].index].row = row;
+        }
+        archetype.entities.pop_back();
+        archetype.transforms.pop_back();
+
+        for (uint32 type = 0U; type < COMPONENT_TYPE_COUNT; type++) {
+            if ((archetype.mask & (1U << type)) == 0U) {
+                continue;
+            }
+            const uint32 size = COMPONENT_SIZES[type];
+            std::byte*   data = archetype.columns[type].data();
+            if (row != last) {
+                std::memcpy(data + static_cast<size_t>(row) * size, data + static_cast<size_t>(last) * size, size);
+            }
+            archetype.columns[type].resize(static_cast<size_t>(last) * size);
+        }
+    }
+}
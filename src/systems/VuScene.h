@@ -0,0 +1,177 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <stack>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "Common.h"
+#include "Components.h"
+#include "Transform.h"
+#include "VuTransformSystem.h"
+
+namespace Vu {
+
+    //bit of the component in an archetype mask, every component stored in a scene needs one
+    template<typename T>
+    struct VuComponentType;
+
+    template<>
+    struct VuComponentType<MeshRenderer> {
+        static constexpr uint32 id = 0U;
+    };
+
+    template<>
+    struct VuComponentType<Spinn> {
+        static constexpr uint32 id = 1U;
+    };
+
+    constexpr uint32                                   COMPONENT_TYPE_COUNT = 2U;
+    constexpr std::array<uint32, COMPONENT_TYPE_COUNT> COMPONENT_SIZES      = {sizeof(MeshRenderer), sizeof(Spinn)};
+
+    struct VuEntity {
+        uint32 index      = UINT32_MAX;
+        uint32 generation = 0U;
+
+        bool isNull() const { return index == UINT32_MAX; }
+
+        bool operator==(const VuEntity& other) const = default;
+    };
+
+    //every entity with exactly the components of mask, one packed column per component. rows move with
+    //memcpy, so components have to be trivially copyable
+    struct VuArchetype {
+        uint32                                                   mask = 0U;
+        std::vector<VuEntity>                                    entities;
+        std::vector<uint32>                                      transforms;
+        std::array<std::vector<std::byte>, COMPONENT_TYPE_COUNT> columns;
+
+        uint32 size() const { return static_cast<uint32>(entities.size()); }
+
+        template<typename T>
+        T* column() {
+            return reinterpret_cast<T *>(columns[VuComponentType<T>::id].data());
+        }
+    };
+
+    struct VuSceneCreateInfo {
+        VuTransformSystemCreateInfo transformInfo{};
+    };
+
+    //entities grouped by their component set into archetypes, so a pass over some components only touches
+    //tightly packed columns. every entity owns a transform of the scene's VuTransformSystem, the entity
+    //hierarchy is the transform hierarchy
+    struct VuScene {
+    public:
+        void init(const VuSceneCreateInfo& info);
+
+        void uninit();
+
+        //local is relative to the parent
+        VuEntity createEntity(const Transform& local = {}, VuEntity parent = {});
+
+        //children become roots
+        void destroyEntity(VuEntity entity);
+
+        bool isAlive(VuEntity entity) const;
+
+        //null parent makes entity a root
+        void setParent(VuEntity entity, VuEntity parent);
+
+        uint32 getTransformId(VuEntity entity) const;
+
+        VuTransformSystem& getTransformSystem();
+
+        //recomputes the changed world matrices into the buffer of frameSlot, see VuTransformSystem::update
+        void update(uint32 frameSlot);
+
+        //replaces the value when the entity already has a T
+        template<typename T>
+        T& add(VuEntity entity, const T& value = {}) {
+            static_assert(std::is_trivially_copyable_v<T>);
+            const uint32 bit  = 1U << VuComponentType<T>::id;
+            const uint32 mask = archetypes[getRecord(entity).archetype].mask;
+            if ((mask & bit) == 0U) {
+                moveEntity(entity.index, mask | bit);
+            }
+            const EntityRecord& record = records[entity.index];
+            T&                  slot   = archetypes[record.archetype].column<T>()[record.row];
+            slot = value;
+            return slot;
+        }
+
+        template<typename T>
+        void remove(VuEntity entity) {
+            const uint32 bit  = 1U << VuComponentType<T>::id;
+            const uint32 mask = archetypes[getRecord(entity).archetype].mask;
+            if ((mask & bit) != 0U) {
+                moveEntity(entity.index, mask & ~bit);
+            }
+        }
+
+        //nullptr when the entity has no T, invalidated by the next add, remove or destroy
+        template<typename T>
+        T* get(VuEntity entity) {
+            const EntityRecord& record    = getRecord(entity);
+            VuArchetype&        archetype = archetypes[record.archetype];
+            if ((archetype.mask & (1U << VuComponentType<T>::id)) == 0U) {
+                return nullptr;
+            }
+            return &archetype.column<T>()[record.row];
+        }
+
+        template<typename T>
+        bool has(VuEntity entity) const {
+            return (archetypes[getRecord(entity).archetype].mask & (1U << VuComponentType<T>::id)) != 0U;
+        }
+
+        //fn(VuEntity, uint32 transformId, Ts&...) for every entity with all of Ts, archetype by archetype.
+        //fn must not add, remove or destroy
+        template<typename... Ts, typename Fn>
+        void forEach(Fn&& fn) {
+            const uint32 required = ((1U << VuComponentType<Ts>::id) | ... | 0U);
+            for (VuArchetype& archetype: archetypes) {
+                if ((archetype.mask & required) != required) {
+                    continue;
+                }
+                forEachRow<Ts...>(archetype, fn);
+            }
+        }
+
+    private:
+        struct EntityRecord {
+            uint32 archetype  = 0U;
+            uint32 row        = 0U;
+            uint32 generation = 0U;
+            uint32 transform  = 0U;
+            bool   alive      = false;
+        };
+
+        VuTransformSystem         transformSystem{};
+        std::vector<VuArchetype>  archetypes;
+        std::vector<EntityRecord> records;
+        std::stack<uint32>        freeIndices;
+
+        const EntityRecord& getRecord(VuEntity entity) const;
+
+        uint32 getOrCreateArchetype(uint32 mask);
+
+        //appends the entity's row to the archetype of mask, components in both sets are copied over
+        void moveEntity(uint32 index, uint32 mask);
+
+        //swap with the last row, the record of the moved entity follows
+        void removeRow(uint32 archetypeIndex, uint32 row);
+
+        template<typename... Ts, typename Fn>
+        static void forEachRow(VuArchetype& archetype, Fn& fn) {
+            const uint32 rowCount = archetype.size();
+            std::tuple<Ts*...> columns{archetype.column<Ts>()...};
+            for (uint32 row = 0U; row < rowCount; row++) {
+                fn(archetype.entities[row], archetype.transforms[row], std::get<Ts *>(columns)[row]...);
+            }
+        }
+    };
+}
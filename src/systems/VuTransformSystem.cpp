@@ -0,0 +1,422 @@
+#include "VuTransformSystem.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#include "VuCpuProfiler.h"
+#include "VuParallel.h"
+
+#ifdef VU_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace Vu {
+
+    void VuTransformStreams::resize(uint32 count) {
+        for (std::vector<float>* stream: {&positionX, &positionY, &positionZ, &rotationX, &rotationY, &rotationZ, &rotationW, &scaleX, &scaleY, &scaleZ}) {
+            stream->resize(count, 0.0F);
+        }
+    }
+
+    void VuTransformStreams::set(uint32 index, const Transform& transform) {
+        positionX[index] = transform.Position.x;
+        positionY[index] = transform.Position.y;
+        positionZ[index] = transform.Position.z;
+        rotationX[index] = transform.Rotation.x;
+        rotationY[index] = transform.Rotation.y;
+        rotationZ[index] = transform.Rotation.z;
+        rotationW[index] = transform.Rotation.w;
+        scaleX[index]    = transform.Scale.x;
+        scaleY[index]    = transform.Scale.y;
+        scaleZ[index]    = transform.Scale.z;
+    }
+
+    Transform VuTransformStreams::get(uint32 index) const {
+        Transform transform{};
+        transform.Position = float3(positionX[index], positionY[index], positionZ[index]);
+        transform.Rotation = quat(rotationW[index], rotationX[index], rotationY[index], rotationZ[index]);
+        transform.Scale    = float3(scaleX[index], scaleY[index], scaleZ[index]);
+        return transform;
+    }
+
+    void VuTransformSystem::init(const VuTransformSystemCreateInfo& info) {
+        createInfo    = info;
+        count         = 0U;
+        freeList      = {};
+        levelsChanged = true;
+        streams.resize(0U);
+        parents.clear();
+        dirty.clear();
+        pendingWrites.clear();
+        localMatrices.clear();
+        worldMatrices.clear();
+
+        for (VuHandle<VuBuffer>& buffer: buffers) {
+            buffer.createHandle()->init({
+                .length = createInfo.capacity,
+                .strideInBytes = sizeof(float4x4),
+                .usageFlags = VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                .memoryPropertyFlags =
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            });
+            buffer.get()->map();
+            VuResourceManager::registerStorageBuffer(buffer.index, *buffer.get());
+        }
+    }
+
+    void VuTransformSystem::uninit() {
+        for (VuHandle<VuBuffer>& buffer: buffers) {
+            buffer.get()->unmap();
+            buffer.destroyHandle();
+        }
+    }
+
+    uint32 VuTransformSystem::create(const Transform& transform, uint32 parent) {
+        uint32 id = 0U;
+        if (!freeList.empty()) {
+            id = freeList.top();
+            freeList.pop();
+        } else {
+            if (count == createInfo.capacity) {
+                throw std::runtime_error("transform system is full!");
+            }
+            id = count++;
+            streams.resize(count);
+            parents.push_back(NO_PARENT);
+            dirty.push_back(0U);
+            pendingWrites.push_back(0U);
+            localMatrices.emplace_back(1.0F);
+            worldMatrices.emplace_back(1.0F);
+        }
+        streams.set(id, transform);
+        parents[id] = NO_PARENT;
+        markDirty(id);
+        levelsChanged = true;
+        if (parent != NO_PARENT) {
+            setParent(id, parent);
+        }
+        return id;
+    }
+
+    void VuTransformSystem::destroy(uint32 id) {
+        for (uint32 child = 0U; child < count; child++) {
+            if (parents[child] == id) {
+                parents[child] = NO_PARENT;
+                markDirty(child);
+            }
+        }
+        //a zero scale collapses the matrix, nothing drawn with a stale id shows up
+        streams.set(id, {float3(0.0F), glm::identity<quat>(), float3(0.0F)});
+        parents[id] = NO_PARENT;
+        markDirty(id);
+        levelsChanged = true;
+        freeList.push(id);
+    }
+
+    void VuTransformSystem::setParent(uint32 id, uint32 parent) {
+        for (uint32 ancestor = parent; ancestor != NO_PARENT; ancestor = parents[ancestor]) {
+            if (ancestor == id) {
+                throw std::runtime_error("transform can not be parented to itself or a descendant!");
+            }
+        }
+        parents[id] = parent;
+        markDirty(id);
+        levelsChanged = true;
+    }
+
+    uint32 VuTransformSystem::getParent(uint32 id) const {
+        return parents[id];
+    }
+
+    void VuTransformSystem::set(uint32 id, const Transform& transform) {
+        streams.set(id, transform);
+        markDirty(id);
+    }
+
+    Transform VuTransformSystem::get(uint32 id) const {
+        return streams.get(id);
+    }
+
+    void VuTransformSystem::setPosition(uint32 id, const float3& position) {
+        streams.positionX[id] = position.x;
+        streams.positionY[id] = position.y;
+        streams.positionZ[id] = position.z;
+        markDirty(id);
+    }
+
+    void VuTransformSystem::setRotation(uint32 id, const quat& rotation) {
+        streams.rotationX[id] = rotation.x;
+        streams.rotationY[id] = rotation.y;
+        streams.rotationZ[id] = rotation.z;
+        streams.rotationW[id] = rotation.w;
+        markDirty(id);
+    }
+
+    void VuTransformSystem::setScale(uint32 id, const float3& scale) {
+        streams.scaleX[id] = scale.x;
+        streams.scaleY[id] = scale.y;
+        streams.scaleZ[id] = scale.z;
+        markDirty(id);
+    }
+
+    float3 VuTransformSystem::getPosition(uint32 id) const {
+        return float3(streams.positionX[id], streams.positionY[id], streams.positionZ[id]);
+    }
+
+    const float4x4& VuTransformSystem::getWorldMatrix(uint32 id) const {
+        return worldMatrices[id];
+    }
+
+    void VuTransformSystem::update(uint32 frameSlot) {
+        VU_CPU_ZONE("transform update");
+        if (levelsChanged) {
+            rebuildLevels();
+        }
+
+        //local TRS of everything that changed, a root's local matrix is already its world matrix
+        computeMatricesParallel(streams, count, worldMatrices.data(), createInfo.threadCount, dirty.data());
+
+        //every level only reads the one above it, which is complete by then
+        for (uint32 level = 1U; level < levels.size(); level++) {
+            updateLevel(levels[level]);
+        }
+
+        writeBuffer(frameSlot);
+    }
+
+    uint32 VuTransformSystem::getBufferIndex(uint32 frameSlot) const {
+        return buffers[frameSlot].index;
+    }
+
+    uint32 VuTransformSystem::getCount() const {
+        return count;
+    }
+
+    uint32 VuTransformSystem::getLevelCount() const {
+        return static_cast<uint32>(levels.size());
+    }
+
+    void VuTransformSystem::markDirty(uint32 id) {
+        dirty[id] = LOCAL_DIRTY;
+    }
+
+    void VuTransformSystem::rebuildLevels() {
+        std::vector<uint32> depths(count, UINT32_MAX);
+        std::vector<uint32> chain;
+        for (auto& level: levels) {
+            level.clear();
+        }
+
+        for (uint32 id = 0U; id < count; id++) {
+            //walk up to the first ancestor with a known depth, then assign the depths back down
+            uint32 node = id;
+            while (node != NO_PARENT && depths[node] == UINT32_MAX) {
+                chain.push_back(node);
+                node = parents[node];
+            }
+            uint32 depth = node == NO_PARENT ? 0U : depths[node] + 1U;
+            while (!chain.empty()) {
+                depths[chain.back()] = depth++;
+                chain.pop_back();
+            }
+
+            if (depths[id] >= levels.size()) {
+                levels.resize(depths[id] + 1U);
+            }
+            levels[depths[id]].push_back(id);
+        }
+        while (!levels.empty() && levels.back().empty()) {
+            levels.pop_back();
+        }
+        levelsChanged = false;
+    }
+
+    //column c of parent * local, both affine
+    static void multiplyAffine(const float4x4& parent, const float4x4& local, float4x4& out) {
+#ifdef VU_SSE2
+        const __m128 p0 = _mm_loadu_ps(&parent[0][0]);
+        const __m128 p1 = _mm_loadu_ps(&parent[1][0]);
+        const __m128 p2 = _mm_loadu_ps(&parent[2][0]);
+        const __m128 p3 = _mm_loadu_ps(&parent[3][0]);
+        for (uint32 c = 0U; c < 4U; c++) {
+            const __m128 column = _mm_add_ps(_mm_add_ps(_mm_mul_ps(p0, _mm_set1_ps(local[c][0])), _mm_mul_ps(p1, _mm_set1_ps(local[c][1]))),
+                                             _mm_add_ps(_mm_mul_ps(p2, _mm_set1_ps(local[c][2])), _mm_mul_ps(p3, _mm_set1_ps(local[c][3]))));
+            _mm_storeu_ps(&out[c][0], column);
+        }
+#else
+        out = parent * local;
+#endif
+    }
+
+    void VuTransformSystem::updateLevel(const std::vector<uint32>& level) {
+        const uint32 levelSize  = static_cast<uint32>(level.size());
+        const uint32 chunkCount = std::min(std::max(levelSize / MIN_TRANSFORMS_PER_THREAD, 1U),
+                                           VuParallel::resolveThreadCount(createInfo.threadCount));
+
+        VuParallel::forEach(chunkCount, createInfo.threadCount, [&](uint32 chunk) {
+            const uint32 first = VuParallel::chunkBegin(chunk, levelSize, chunkCount);
+            const uint32 end   = VuParallel::chunkBegin(chunk + 1U, levelSize, chunkCount);
+            for (uint32 n = first; n < end; n++) {
+                const uint32 id     = level[n];
+                const uint32 parent = parents[id];
+                if (dirty[id] == LOCAL_DIRTY) {
+                    //the simd pass left the fresh local matrix in the world slot
+                    localMatrices[id] = worldMatrices[id];
+                } else if (dirty[parent] != 0U) {
+                    dirty[id] = PARENT_DIRTY;
+                } else {
+                    continue;
+                }
+                multiplyAffine(worldMatrices[parent], localMatrices[id], worldMatrices[id]);
+            }
+        });
+    }
+
+    void VuTransformSystem::writeBuffer(uint32 frameSlot) {
+        auto*        dst        = static_cast<float4x4 *>(buffers[frameSlot].get()->mapPtr);
+        const uint32 chunkCount = std::min(std::max(count / MIN_TRANSFORMS_PER_THREAD, 1U),
+                                           VuParallel::resolveThreadCount(createInfo.threadCount));
+
+        VuParallel::forEach(chunkCount, createInfo.threadCount, [&](uint32 chunk) {
+            const uint32 first = VuParallel::chunkBegin(chunk, count, chunkCount);
+            const uint32 end   = VuParallel::chunkBegin(chunk + 1U, count, chunkCount);
+            for (uint32 id = first; id < end; id++) {
+                if (dirty[id] != 0U) {
+                    pendingWrites[id] = static_cast<uint8>(config::MAX_FRAMES_IN_FLIGHT);
+                    dirty[id]         = 0U;
+                }
+                if (pendingWrites[id] == 0U) {
+                    continue;
+                }
+                pendingWrites[id]--;
+#ifdef VU_SSE2
+                //mapped device memory is write combined, streaming stores skip reading the lines back
+                const float* src = &worldMatrices[id][0][0];
+                float*       out = &dst[id][0][0];
+                for (uint32 c = 0U; c < 4U; c++) {
+                    _mm_stream_ps(out + c * 4U, _mm_loadu_ps(src + c * 4U));
+                }
+#else
+                dst[id] = worldMatrices[id];
+#endif
+            }
+        });
+#ifdef VU_SSE2
+        _mm_sfence();
+#endif
+    }
+
+    void VuTransformSystem::computeMatricesParallel(const VuTransformStreams& streams, uint32 count, float4x4* out, uint32 threadCount,
+                                                    const uint8* dirty) {
+        const uint32 bySize     = std::max(count / MIN_TRANSFORMS_PER_THREAD, 1U);
+        const uint32 chunkCount = std::min(bySize, VuParallel::resolveThreadCount(threadCount));
+
+        VuParallel::forEach(chunkCount, threadCount, [&](uint32 chunk) {
+            //chunks start on multiples of 4 so every simd batch loads whole 16 byte groups of the streams
+            const uint32 first = VuParallel::chunkBegin(chunk, count, chunkCount) & ~3U;
+            const uint32 end   = chunk + 1U == chunkCount ? count : VuParallel::chunkBegin(chunk + 1U, count, chunkCount) & ~3U;
+            computeMatrices(streams, first, end, out + first, dirty == nullptr ? nullptr : dirty + first);
+        });
+    }
+
+    //glm's column major TRS: columns 0..2 are the rotation columns times the axis scale, column 3 the position
+    static void computeMatrix(const VuTransformStreams& s, uint32 i, float4x4& out) {
+        const float x = s.rotationX[i];
+        const float y = s.rotationY[i];
+        const float z = s.rotationZ[i];
+        const float w = s.rotationW[i];
+
+        const float xx = x * x, yy = y * y, zz = z * z;
+        const float xy = x * y, xz = x * z, yz = y * z;
+        const float wx = w * x, wy = w * y, wz = w * z;
+
+        out[0] = float4((1.0F - 2.0F * (yy + zz)) * s.scaleX[i], 2.0F * (xy + wz) * s.scaleX[i], 2.0F * (xz - wy) * s.scaleX[i], 0.0F);
+        out[1] = float4(2.0F * (xy - wz) * s.scaleY[i], (1.0F - 2.0F * (xx + zz)) * s.scaleY[i], 2.0F * (yz + wx) * s.scaleY[i], 0.0F);
+        out[2] = float4(2.0F * (xz + wy) * s.scaleZ[i], 2.0F * (yz - wx) * s.scaleZ[i], (1.0F - 2.0F * (xx + yy)) * s.scaleZ[i], 0.0F);
+        out[3] = float4(s.positionX[i], s.positionY[i], s.positionZ[i], 1.0F);
+    }
+
+    void VuTransformSystem::computeMatrices(const VuTransformStreams& streams, uint32 first, uint32 end, float4x4* out,
+                                            const uint8* dirty) {
+        uint32 i = first;
+#ifdef VU_SSE2
+        const __m128 one  = _mm_set1_ps(1.0F);
+        const __m128 two  = _mm_set1_ps(2.0F);
+        const __m128 zero = _mm_setzero_ps();
+        for (; i + 4U <= end; i += 4U) {
+            //bit n set when transform i + n is written
+            uint32 lanes = 0xFU;
+            if (dirty != nullptr) {
+                lanes = 0U;
+                for (uint32 n = 0U; n < 4U; n++) {
+                    lanes |= dirty[i - first + n] != 0U ? 1U << n : 0U;
+                }
+                if (lanes == 0U) {
+                    continue;
+                }
+            }
+
+            const __m128 x = _mm_loadu_ps(&streams.rotationX[i]);
+            const __m128 y = _mm_loadu_ps(&streams.rotationY[i]);
+            const __m128 z = _mm_loadu_ps(&streams.rotationZ[i]);
+            const __m128 w = _mm_loadu_ps(&streams.rotationW[i]);
+
+            const __m128 xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y), zz = _mm_mul_ps(z, z);
+            const __m128 xy = _mm_mul_ps(x, y), xz = _mm_mul_ps(x, z), yz = _mm_mul_ps(y, z);
+            const __m128 wx = _mm_mul_ps(w, x), wy = _mm_mul_ps(w, y), wz = _mm_mul_ps(w, z);
+
+            const __m128 sx = _mm_loadu_ps(&streams.scaleX[i]);
+            const __m128 sy = _mm_loadu_ps(&streams.scaleY[i]);
+            const __m128 sz = _mm_loadu_ps(&streams.scaleZ[i]);
+
+            //one register per matrix element, lane n belongs to transform i + n
+            __m128 columns[4][4] = {
+                {
+                    _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx),
+                    _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sx),
+                    _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sx),
+                    zero
+                },
+                {
+                    _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sy),
+                    _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy),
+                    _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sy),
+                    zero
+                },
+                {
+                    _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sz),
+                    _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sz),
+                    _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz),
+                    zero
+                },
+                {
+                    _mm_loadu_ps(&streams.positionX[i]),
+                    _mm_loadu_ps(&streams.positionY[i]),
+                    _mm_loadu_ps(&streams.positionZ[i]),
+                    one
+                },
+            };
+
+            //after the transpose columns[c][n] is column c of transform i + n
+            for (auto& column: columns) {
+                _MM_TRANSPOSE4_PS(column[0], column[1], column[2], column[3]);
+            }
+
+            auto* dst = reinterpret_cast<float *>(out + (i - first));
+            for (uint32 n = 0U; n < 4U; n++) {
+                if ((lanes & (1U << n)) == 0U) {
+                    continue;
+                }
+                for (uint32 c = 0U; c < 4U; c++) {
+                    _mm_storeu_ps(dst + n * 16U + c * 4U, columns[c][n]);
+                }
+            }
+        }
+#endif
+        for (; i < end; i++) {
+            if (dirty == nullptr || dirty[i - first] != 0U) {
+                computeMatrix(streams, i, out[i - first]);
+            }
+        }
+    }
+}
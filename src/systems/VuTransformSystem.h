@@ -0,0 +1,130 @@
+#pragma once
+
+#include <array>
+#include <stack>
+#include <vector>
+
+#include "Common.h"
+#include "Transform.h"
+#include "VuBuffer.h"
+#include "VuConfig.h"
+#include "VuResourceManager.h"
+
+namespace Vu {
+
+    struct VuTransformSystemCreateInfo {
+        //transforms alive at once, every frame in flight owns a buffer of capacity matrices
+        uint32 capacity = 4096U;
+        //0 uses every hardware thread once there are enough transforms to split
+        uint32 threadCount = 0U;
+    };
+
+    //one float stream per component, the simd batch loads four transforms of a component at once
+    struct VuTransformStreams {
+        std::vector<float> positionX, positionY, positionZ;
+        std::vector<float> rotationX, rotationY, rotationZ, rotationW;
+        std::vector<float> scaleX, scaleY, scaleZ;
+
+        void resize(uint32 count);
+
+        void set(uint32 index, const Transform& transform);
+
+        Transform get(uint32 index) const;
+    };
+
+    //local transforms as structure of arrays with an optional parent each. update() rebuilds the local TRS
+    //matrix of every changed transform in simd batches, rotation to 3x3 with the scale folded into the columns,
+    //then walks the hierarchy one depth level at a time, every level split over threads, and multiplies
+    //world = parent world * local only below something that changed. changed world matrices are streamed into
+    //the mapped storage buffer of the frame, and into the other frames' buffers on their next updates.
+    //shaders read the matrix with the bindless buffer index from getBufferIndex() and the transform id
+    struct VuTransformSystem {
+    public:
+        static constexpr uint32 NO_PARENT = UINT32_MAX;
+        //below this many transforms per thread a pass stays on the calling thread
+        static constexpr uint32 MIN_TRANSFORMS_PER_THREAD = 16384U;
+
+        void init(const VuTransformSystemCreateInfo& info);
+
+        void uninit();
+
+        //returns the id, ids of destroyed transforms are reused. transform is relative to the parent
+        uint32 create(const Transform& transform = {}, uint32 parent = NO_PARENT);
+
+        //children become roots and keep their local transform
+        void destroy(uint32 id);
+
+        //the local transform stays, so the child moves with its new parent. throws on cycles
+        void setParent(uint32 id, uint32 parent);
+
+        uint32 getParent(uint32 id) const;
+
+        void set(uint32 id, const Transform& transform);
+
+        Transform get(uint32 id) const;
+
+        void setPosition(uint32 id, const float3& position);
+
+        void setRotation(uint32 id, const quat& rotation);
+
+        void setScale(uint32 id, const float3& scale);
+
+        float3 getPosition(uint32 id) const;
+
+        //as of the last update
+        const float4x4& getWorldMatrix(uint32 id) const;
+
+        //after the fence of frameSlot was waited, before any draw of the frame reads the buffer
+        void update(uint32 frameSlot);
+
+        //bindless storage buffer index of the matrices frameSlot reads
+        uint32 getBufferIndex(uint32 frameSlot) const;
+
+        //ids handed out so far, destroyed ones included
+        uint32 getCount() const;
+
+        //depth levels of the hierarchy, 1 when nothing has a parent
+        uint32 getLevelCount() const;
+
+        //TRS matrices of [first, end) into out, out[0] belongs to first. with dirty only the transforms whose
+        //flag is set are written
+        static void computeMatrices(const VuTransformStreams& streams, uint32 first, uint32 end, float4x4* out,
+                                    const uint8* dirty = nullptr);
+
+        //computeMatrices split over threads
+        static void computeMatricesParallel(const VuTransformStreams& streams, uint32 count, float4x4* out, uint32 threadCount,
+                                            const uint8* dirty = nullptr);
+
+    private:
+        //dirty values, a changed local transform or only a changed ancestor
+        static constexpr uint8 LOCAL_DIRTY  = 1U;
+        static constexpr uint8 PARENT_DIRTY = 2U;
+
+        VuTransformSystemCreateInfo createInfo{};
+        VuTransformStreams          streams{};
+        uint32                      count = 0U;
+        std::stack<uint32>          freeList;
+
+        std::vector<uint32>   parents;
+        std::vector<uint8>    dirty;
+        //buffers of frames in flight that still hold an older matrix
+        std::vector<uint8>    pendingWrites;
+        //cached for children whose parent moved while they did not
+        std::vector<float4x4> localMatrices;
+        std::vector<float4x4> worldMatrices;
+
+        //ids by depth, levels[0] are the roots
+        std::vector<std::vector<uint32>> levels;
+        bool                             levelsChanged = true;
+
+        std::array<VuHandle<VuBuffer>, config::MAX_FRAMES_IN_FLIGHT> buffers{};
+
+        void markDirty(uint32 id);
+
+        void rebuildLevels();
+
+        void updateLevel(const std::vector<uint32>& level);
+
+        void writeBuffer(uint32 frameSlot);
+    };
+}
@@ -0,0 +1,96 @@
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#define GLM_ENABLE_EXPERIMENTAL
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "Common.h"
+#include "VuBenchScene.h"
+#include "VuJobSystem.h"
+
+using namespace Vu;
+
+static void printUsage() {
+    std::cout << "usage: vumake_bench [options]\n"
+            << "  --objects <n>        drawn objects (256)\n"
+            << "  --materials <n>      materials the objects cycle through (16)\n"
+            << "  --textures <n>       streamed textures the materials cycle through (8)\n"
+            << "  --width <n>          headless resolution (960)\n"
+            << "  --height <n>         (540)\n"
+            << "  --warmup <n>         frames before measuring (120)\n"
+            << "  --frames <n>         measured frames (600)\n"
+            << "  --display            present to the display instead of rendering headless\n"
+            << "  --vsync-interval-ms  pace headless frames like a fifo swapchain\n"
+            << "  --out <file>         write the json report to a file instead of stdout\n"
+            << "  --job-workers <n>    job threads besides the main thread (hardware threads - 1)\n"
+            << "  --single-thread      run every job inline on the main thread\n"
+            << "frames in flight are fixed per build, see VUMAKE_BENCH_FRAMES_IN_FLIGHT\n";
+}
+
+int main(int argc, char* argv[]) {
+    VuBenchScene          bench{};
+    VuJobSystemCreateInfo jobInfo{};
+    std::filesystem::path outPath;
+
+    for (int i = 1; i < argc; i++) {
+        const bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--objects") == 0 && hasValue) {
+            bench.info.objectCount = static_cast<uint32>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--materials") == 0 && hasValue) {
+            bench.info.materialCount = static_cast<uint32>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--textures") == 0 && hasValue) {
+            bench.info.textureCount = static_cast<uint32>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--width") == 0 && hasValue) {
+            bench.info.extent.width = static_cast<uint32>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--height") == 0 && hasValue) {
+            bench.info.extent.height = static_cast<uint32>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--warmup") == 0 && hasValue) {
+            bench.info.warmupFrames = static_cast<uint32>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--frames") == 0 && hasValue) {
+            bench.info.measuredFrames = static_cast<uint32>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--display") == 0) {
+            bench.info.headless = false;
+        } else if (std::strcmp(argv[i], "--vsync-interval-ms") == 0 && hasValue) {
+            bench.backendInfo.pacing               = VuFramePacing::SimulatedVsync;
+            bench.backendInfo.vsyncIntervalSeconds = std::atof(argv[++i]) / 1000.0;
+        } else if (std::strcmp(argv[i], "--out") == 0 && hasValue) {
+            outPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--job-workers") == 0 && hasValue) {
+            jobInfo.workerCount = static_cast<uint32>(std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--single-thread") == 0) {
+            jobInfo.singleThreaded = true;
+        } else {
+            printUsage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (bench.info.extent.width == 0U || bench.info.extent.height == 0U || bench.info.measuredFrames == 0U) {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
+    try {
+        VuJobSystem::init(jobInfo);
+        const VuBenchResult result = bench.Run();
+        VuJobSystem::uninit();
+        if (outPath.empty()) {
+            bench.writeJson(result, std::cout);
+        } else {
+            std::ofstream file(outPath);
+            if (!file.is_open()) {
+                std::cerr << "[ERROR]: failed to open " << outPath.string() << std::endl;
+                return EXIT_FAILURE;
+            }
+            bench.writeJson(result, file);
+            std::cout << "[INFO]: wrote " << outPath.string() << std::endl;
+        }
+    } catch (const std::exception& e) {
+        VuJobSystem::uninit();
+        std::cerr << "[ERROR]: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
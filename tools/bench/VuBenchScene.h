@@ -0,0 +1,312 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <string_view>
+#include <vector>
+
+#include "Camera.h"
+#include "Components.h"
+#include "Transform.h"
+#include "VuAssetLoader.h"
+#include "VuDeviceSetup.h"
+#include "VuMesh.h"
+#include "VuRenderer.h"
+#include "VuShader.h"
+#include "VuTextureStreamer.h"
+#include "VuScene.h"
+
+namespace Vu {
+
+    struct VuBenchSceneInfo {
+        uint32     objectCount    = 256U;
+        //blocks of the material data pool, every material draws with the one pipeline of the pbr shader
+        uint32     materialCount  = 16U;
+        uint32     textureCount   = 8U;
+        uint32     warmupFrames   = 120U;
+        uint32     measuredFrames = 600U;
+        VkExtent2D extent         = {config::SCREEN_WIDTH, config::SCREEN_HEIGHT};
+        //the display swapchain ignores extent and always uses the configured screen size
+        bool       headless       = true;
+    };
+
+    struct VuBenchPercentiles {
+        double min;
+        double avg;
+        double p50;
+        double p90;
+        double p95;
+        double p99;
+        double max;
+    };
+
+    struct VuBenchResult {
+        std::string        deviceName;
+        VkExtent2D         extent;
+        uint32             framesInFlight;
+        VuBenchPercentiles cpuFrameMs;
+        //zero when the queue has no timestamps
+        VuBenchPercentiles gpuFrameMs;
+        uint32             gpuSampleCount;
+        double             seconds;
+    };
+
+    //draws objectCount jets with materialCount materials spread over textureCount streamed textures,
+    //then measures measuredFrames frames after warmupFrames frames and closes the renderer
+    struct VuBenchScene {
+    public:
+        VuBenchSceneInfo    info{};
+        VuRenderBackendInfo backendInfo{};
+
+        VuBenchResult Run() {
+            backendInfo.headless                = info.headless;
+            backendInfo.headlessExtent          = info.extent;
+            //the whole measured run fits into the window, see resetStats below
+            backendInfo.gpuProfiler.windowSize  = std::max(info.measuredFrames, 1U);
+            backendInfo.gpuProfiler.dumpInterval = 0U;
+
+            VuDeviceSetup deviceSetup{};
+            deviceSetup.init(backendInfo);
+            auto device   = VuDevice{};
+            ctx::vuDevice = &device;
+
+            vuRenderer.init(deviceSetup.pipelineCacheBinary.bytes(), deviceSetup.deviceFeatures2, deviceSetup.pipelineCacheCreateInfo, backendInfo);
+            ctx::vuRenderer = &vuRenderer;
+            textureStreamer.init({});
+            scene.init({.transformInfo = {.capacity = std::max(info.objectCount, 1U)}});
+
+            VuMesh       mesh{};
+            VuAssetBatch assets{};
+            assets.addMesh("assets/gltf/jet/jet.gltf", mesh);
+            assets.start();
+            createMaterials();
+            assets.wait();
+            placeObjects(mesh);
+
+            std::vector<double> cpuFrameMs;
+            cpuFrameMs.reserve(info.measuredFrames);
+
+            const uint32 totalFrames = info.warmupFrames + info.measuredFrames;
+            const uint64 start       = VuCpuProfiler::now();
+            uint64       measureStart = start;
+            for (uint32 frame = 0; frame < totalFrames && !vuRenderer.shouldWindowClose(); frame++) {
+                const uint64 frameStart = VuCpuProfiler::now();
+                const bool   measured   = frame >= info.warmupFrames;
+                if (frame == info.warmupFrames) {
+                    measureStart = frameStart;
+                }
+
+                ctx::PreUpdate();
+                updateFrameConstant();
+                textureStreamer.update();
+                vuRenderer.beginFrame();
+                //beginFrame just collected the gpu results of frame - MAX_FRAMES_IN_FLIGHT, from here on only measured frames arrive
+                if (frame + 1U == info.warmupFrames + config::MAX_FRAMES_IN_FLIGHT) {
+                    vuRenderer.gpuProfiler.resetStats();
+                }
+                scene.update(vuRenderer.currentFrame);
+                //the materials only differ in their data block, the pipeline is bound once
+                vuRenderer.bindShader(pbrShader);
+                scene.forEach<MeshRenderer>([&](VuEntity, uint32 transform, MeshRenderer& renderer) {
+                    renderObject(renderer, transform);
+                });
+                vuRenderer.endFrame();
+
+                if (measured) {
+                    cpuFrameMs.push_back(static_cast<double>(VuCpuProfiler::now() - frameStart) / 1000000.0);
+                }
+            }
+            vuRenderer.requestClose();
+            vuRenderer.waitIdle();
+            vuRenderer.gpuProfiler.collectPending();
+
+            VuBenchResult result{};
+            result.deviceName     = ctx::vuDevice->physicalDeviceProperties.deviceName;
+            result.extent         = vuRenderer.swapChain.swapChainExtent;
+            result.framesInFlight = config::MAX_FRAMES_IN_FLIGHT;
+            result.seconds        = static_cast<double>(VuCpuProfiler::now() - measureStart) / 1000000000.0;
+            result.cpuFrameMs     = computePercentiles(cpuFrameMs);
+
+            std::vector<double> gpuFrameMs;
+            vuRenderer.gpuProfiler.getSamples("frame", gpuFrameMs);
+            result.gpuFrameMs     = computePercentiles(gpuFrameMs);
+            result.gpuSampleCount = static_cast<uint32>(gpuFrameMs.size());
+
+            textureStreamer.uninit();
+            scene.uninit();
+            mesh.uninit();
+            vuRenderer.uninit();
+            return result;
+        }
+
+        void writeJson(const VuBenchResult& result, std::ostream& out) const {
+            out << "{\n";
+            out << std::format("  \"device\": \"{}\",\n", escapeJson(result.deviceName));
+            out << std::format("  \"scene\": {{\"objects\": {}, \"materials\": {}, \"textures\": {}, \"width\": {}, \"height\": {}, "
+                               "\"framesInFlight\": {}, \"headless\": {}}},\n",
+                               info.objectCount, info.materialCount, info.textureCount, result.extent.width, result.extent.height,
+                               result.framesInFlight, info.headless ? "true" : "false");
+            out << std::format("  \"warmupFrames\": {},\n  \"measuredFrames\": {},\n  \"seconds\": {:.3f},\n",
+                               info.warmupFrames, info.measuredFrames, result.seconds);
+            out << "  \"cpuFrameMs\": " << formatPercentiles(result.cpuFrameMs) << ",\n";
+            out << "  \"gpuFrameMs\": " << formatPercentiles(result.gpuFrameMs) << ",\n";
+            out << std::format("  \"gpuSamples\": {}\n", result.gpuSampleCount);
+            out << "}\n";
+        }
+
+        //nearest rank, an empty set gives zeros
+        static VuBenchPercentiles computePercentiles(std::vector<double> samples) {
+            VuBenchPercentiles result{};
+            if (samples.empty()) {
+                return result;
+            }
+            std::sort(samples.begin(), samples.end());
+
+            double sum = 0.0;
+            for (double sample: samples) {
+                sum += sample;
+            }
+            auto rank = [&samples](uint32 percent) {
+                const size_t index = (samples.size() * percent + 99U) / 100U;
+                return samples[std::clamp<size_t>(index, 1U, samples.size()) - 1U];
+            };
+
+            result.min = samples.front();
+            result.avg = sum / static_cast<double>(samples.size());
+            result.p50 = rank(50U);
+            result.p90 = rank(90U);
+            result.p95 = rank(95U);
+            result.p99 = rank(99U);
+            result.max = samples.back();
+            return result;
+        }
+
+    private:
+        VuRenderer        vuRenderer{};
+        VuTextureStreamer textureStreamer{};
+        VuShader          pbrShader{};
+        VuScene           scene{};
+
+        Camera    cam{};
+        Transform camTransform = {{0, 20, -40.0F}, glm::quat(glm::vec3{-0.3F, 3.1415F, 0}), {1, 1, 1}};
+
+        std::vector<uint32> materials;
+
+        void createMaterials() {
+            //the texture count is reached by registering the few images of the repo more than once,
+            //every registration is its own streamed texture with its own residency
+            static constexpr std::array<const char *, 4> COLOR_IMAGES{
+                "assets/gltf/jet/textures/texture_baseColor.png",
+                "assets/gltf/mountain/textures/texture_baseColor.png",
+                "assets/textures/UV_Checker.png",
+                "assets/textures/error.png",
+            };
+            static constexpr std::array<const char *, 2> NORMAL_IMAGES{
+                "assets/gltf/jet/textures/texture_normal.png",
+                "assets/textures/debug_normal.png",
+            };
+
+            //half color, half normal maps, at least one of each
+            const uint32 colorCount  = std::max(info.textureCount / 2U, 1U);
+            const uint32 normalCount = std::max(info.textureCount - colorCount, 1U);
+
+            std::vector<VuHandle<VuTexture>> colorTextures;
+            for (uint32 i = 0; i < colorCount; i++) {
+                colorTextures.push_back(textureStreamer.registerTexture({COLOR_IMAGES[i % COLOR_IMAGES.size()]}));
+            }
+            std::vector<VuHandle<VuTexture>> normalTextures;
+            for (uint32 i = 0; i < normalCount; i++) {
+                normalTextures.push_back(textureStreamer.registerTexture({NORMAL_IMAGES[i % NORMAL_IMAGES.size()], VK_FORMAT_R8G8B8A8_UNORM}));
+            }
+
+            pbrShader.initAsGraphicsShader({vuRenderer.pipelineCache, vuRenderer.swapChain.renderPass.renderPass});
+
+            const uint32 materialCount = std::clamp(info.materialCount, 1U, config::MATERIAL_COUNT);
+            for (uint32 i = 0; i < materialCount; i++) {
+                const uint32          material = pbrShader.createMaterial();
+                GPU_PBR_MaterialData* data     = pbrShader.materials[material].getPbrMaterialData();
+                textureStreamer.linkSlot(colorTextures[i % colorTextures.size()], data->baseColorTexture);
+                textureStreamer.linkSlot(normalTextures[i % normalTextures.size()], data->normalTexture);
+                data->baseColorMul             = {1, 1, 1};
+                data->sampler                  = vuRenderer.defaultSampler;
+                materials.push_back(material);
+            }
+        }
+
+        //a square grid in front of the camera
+        void placeObjects(VuMesh& mesh) {
+            const uint32 columns = std::max(static_cast<uint32>(std::ceil(std::sqrt(static_cast<float>(info.objectCount)))), 1U);
+            const float  spacing = std::max(mesh.boundsRadius * 2.2F, 1.0F);
+            for (uint32 i = 0; i < info.objectCount; i++) {
+                const float x = (static_cast<float>(i % columns) - static_cast<float>(columns - 1U) * 0.5F) * spacing;
+                const float z = static_cast<float>(i / columns) * spacing;
+                const VuEntity object = scene.createEntity({{x, 0, z}, glm::quat(glm::vec3{0, 0, 0}), {1, 1, 1}});
+                scene.add<MeshRenderer>(object, {&mesh, &pbrShader, materials[i % materials.size()]});
+            }
+        }
+
+        void renderObject(const MeshRenderer& renderer, uint32 transform) {
+            VuMesh&         mesh     = *renderer.mesh;
+            VuMaterial&     material = renderer.shader->materials[renderer.materialIndex];
+            const float4x4& world    = scene.getTransformSystem().getWorldMatrix(transform);
+
+            const float3 worldCenter = float3(world * float4(mesh.boundsCenter, 1.0F));
+            const float  screenSize  = VuTextureStreamer::projectedDiameter(
+                worldCenter, mesh.boundsRadius, camTransform.Position, glm::radians(cam.fov),
+                static_cast<float>(vuRenderer.swapChain.swapChainExtent.height));
+            const GPU_PBR_MaterialData* data = material.getPbrMaterialData();
+            textureStreamer.requestScreenSize(data->baseColorTexture, screenSize);
+            textureStreamer.requestScreenSize(data->normalTexture, screenSize);
+
+            vuRenderer.pushConstants({
+                scene.getTransformSystem().getBufferIndex(vuRenderer.currentFrame),
+                transform,
+                material.index,
+                {mesh.vertexBuffer.index, mesh.vertexCount, 0}
+            });
+            vuRenderer.bindMesh(mesh);
+            for (const VuSubMesh& subMesh: mesh.getSubMeshRange(renderer.firstSubMesh, renderer.subMeshCount)) {
+                vuRenderer.drawIndexed(subMesh.indexCount, subMesh.firstIndex, subMesh.vertexOffset);
+            }
+        }
+
+        void updateFrameConstant() {
+            const VkExtent2D extent = vuRenderer.swapChain.swapChainExtent;
+            ctx::frameConst.view      = glm::inverse(camTransform.ToTRS());
+            ctx::frameConst.proj      = glm::perspective(glm::radians(cam.fov),
+                                                         static_cast<float>(extent.width) / static_cast<float>(extent.height),
+                                                         cam.near,
+                                                         cam.far);
+            ctx::frameConst.cameraPos = glm::vec4(camTransform.Position, 0);
+            ctx::frameConst.cameraDir = glm::vec4(float3(cam.yaw, cam.pitch, cam.roll), 0);
+            ctx::frameConst.time      = ctx::time();
+            vuRenderer.updateFrameConstantBuffer(ctx::frameConst);
+        }
+
+        //the device name comes from the driver, quotes, backslashes and control characters must not end the string
+        static std::string escapeJson(std::string_view text) {
+            std::string result;
+            result.reserve(text.size());
+            for (const char c: text) {
+                if (c == '"' || c == '\\') {
+                    result.push_back('\\');
+                    result.push_back(c);
+                } else if (static_cast<unsigned char>(c) < 0x20U) {
+                    result += std::format("\\u{:04x}", static_cast<unsigned char>(c));
+                } else {
+                    result.push_back(c);
+                }
+            }
+            return result;
+        }
+
+        static std::string formatPercentiles(const VuBenchPercentiles& p) {
+            return std::format("{{\"min\": {:.4f}, \"avg\": {:.4f}, \"p50\": {:.4f}, \"p90\": {:.4f}, \"p95\": {:.4f}, \"p99\": {:.4f}, \"max\": {:.4f}}}",
+                               p.min, p.avg, p.p50, p.p90, p.p95, p.p99, p.max);
+        }
+    };
+}
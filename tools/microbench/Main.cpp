@@ -0,0 +1,380 @@
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#define GLM_ENABLE_EXPERIMENTAL
+
+#include <cstring>
+#include <random>
+#include <thread>
+
+#include <fastgltf/core.hpp>
+#include <fastgltf/glm_element_traits.hpp>
+#include <fastgltf/tools.hpp>
+
+#include "Common.h"
+#include "Transform.h"
+#include "VuAssetLoader.h"
+#include "VuFile.h"
+#include "VuImageDecoder.h"
+#include "VuMath.h"
+#include "VuMesh.h"
+#include "VuMicroBench.h"
+#include "VuResourceManager.h"
+#include "VuMaterialDataPool.h"
+#include "VuJobSystem.h"
+#include "VuTangentGenerator.h"
+#include "VuTransformSystem.h"
+
+using namespace Vu;
+
+//a flat grid of side x side vertices, two triangles per cell, uvs stretched over the grid
+static VuMeshData makeGrid(uint32 side) {
+    VuMeshData   mesh{};
+    const uint32 vertexCount = side * side;
+    mesh.positions.resize(vertexCount);
+    mesh.normals.resize(vertexCount);
+    mesh.uvs.resize(vertexCount);
+    mesh.tangents.resize(vertexCount);
+
+    std::mt19937                          rng(7U);
+    std::uniform_real_distribution<float> jitter(-0.1F, 0.1F);
+    const float                           inv = 1.0F / static_cast<float>(side - 1U);
+    for (uint32 y = 0; y < side; y++) {
+        for (uint32 x = 0; x < side; x++) {
+            const uint32 i    = y * side + x;
+            mesh.positions[i] = float3(static_cast<float>(x), jitter(rng), static_cast<float>(y));
+            mesh.normals[i]   = float3(0.0F, 1.0F, 0.0F);
+            mesh.uvs[i]       = float2(static_cast<float>(x) * inv, static_cast<float>(y) * inv);
+        }
+    }
+
+    mesh.indices.reserve(static_cast<size_t>(side - 1U) * (side - 1U) * 6U);
+    for (uint32 y = 0; y + 1U < side; y++) {
+        for (uint32 x = 0; x + 1U < side; x++) {
+            const uint32 i = y * side + x;
+            mesh.indices.insert(mesh.indices.end(), {i, i + side, i + 1U, i + 1U, i + side, i + side + 1U});
+        }
+    }
+    return mesh;
+}
+
+static std::vector<Transform> makeTransforms(uint32 count) {
+    std::mt19937                          rng(11U);
+    std::uniform_real_distribution<float> position(-1000.0F, 1000.0F);
+    std::uniform_real_distribution<float> angle(-3.14F, 3.14F);
+    std::uniform_real_distribution<float> scale(0.5F, 2.0F);
+
+    std::vector<Transform> transforms(count);
+    for (Transform& t: transforms) {
+        t.Position = float3(position(rng), position(rng), position(rng));
+        t.Rotation = glm::quat(float3(angle(rng), angle(rng), angle(rng)));
+        t.Scale    = float3(scale(rng), scale(rng), scale(rng));
+    }
+    return transforms;
+}
+
+//single threaded against every hardware thread, multi million vertex meshes show the scaling
+static void benchTangents(VuMicroBench& bench, bool large) {
+    std::vector<uint32> sides{32U, 317U, 1000U, 2000U};
+    if (large) {
+        sides.push_back(3163U);
+    }
+    const uint32 hardwareThreads = std::max(std::thread::hardware_concurrency(), 1U);
+    for (uint32 side: sides) {
+        VuMeshData   mesh        = makeGrid(side);
+        const uint32 vertexCount = mesh.vertexCount();
+        for (uint32 threads: {1U, hardwareThreads}) {
+            bench.run(std::format("generateTangents/{}t/{}", threads, vertexCount), vertexCount, [&mesh, threads] {
+                VuTangentGenerator::generateTangents(mesh.indices, mesh.positions, mesh.normals, mesh.uvs, mesh.tangents, threads);
+                VuMicroBench::doNotOptimize(mesh.tangents.back());
+            });
+            if (threads == hardwareThreads) {
+                break;
+            }
+        }
+        bench.run(std::format("generateNormals/{}t/{}", hardwareThreads, vertexCount), vertexCount, [&mesh, hardwareThreads] {
+            VuTangentGenerator::generateNormals(mesh.indices, mesh.positions, mesh.normals, hardwareThreads);
+            VuMicroBench::doNotOptimize(mesh.normals.back());
+        });
+    }
+}
+
+static void benchTransforms(VuMicroBench& bench) {
+    constexpr uint32       COUNT      = 100000U;
+    std::vector<Transform> transforms = makeTransforms(COUNT);
+    std::vector<float4x4>  matrices(COUNT);
+
+    bench.run("Transform::ToTRS/100000", COUNT, [&] {
+        for (uint32 i = 0; i < COUNT; i++) {
+            matrices[i] = transforms[i].ToTRS();
+        }
+        VuMicroBench::doNotOptimize(matrices.back());
+    });
+
+    //the same matrices from the structure of arrays streams, single threaded and over every hardware thread
+    const uint32 hardwareThreads = std::max(std::thread::hardware_concurrency(), 1U);
+    for (uint32 count: {100000U, 1000000U}) {
+        const std::vector<Transform> source = makeTransforms(count);
+        VuTransformStreams           streams{};
+        streams.resize(count);
+        for (uint32 i = 0; i < count; i++) {
+            streams.set(i, source[i]);
+        }
+        std::vector<float4x4> out(count);
+        for (uint32 threads: {1U, hardwareThreads}) {
+            bench.run(std::format("VuTransformSystem::computeMatrices/{}t/{}", threads, count), count, [&, threads] {
+                VuTransformSystem::computeMatricesParallel(streams, count, out.data(), threads);
+                VuMicroBench::doNotOptimize(out.back());
+            });
+            if (threads == hardwareThreads) {
+                break;
+            }
+        }
+
+        //a frame where every 10th transform moved, the rest of the batches is skipped
+        std::vector<uint8> dirty(count, 0U);
+        for (uint32 i = 0; i < count; i += 10U) {
+            dirty[i] = 1U;
+        }
+        bench.run(std::format("VuTransformSystem::computeMatrices/dirty10%/{}", count), count, [&] {
+            VuTransformSystem::computeMatricesParallel(streams, count, out.data(), 1U, dirty.data());
+            VuMicroBench::doNotOptimize(out.back());
+        });
+    }
+
+    for (uint32 count: {100000U, 1000000U}) {
+        std::vector<Transform> rotations = makeTransforms(count);
+        std::vector<float3>    vectors(count, float3(1.0F, 2.0F, 3.0F));
+        std::vector<float3>    rotated(count);
+        bench.run(std::format("QuatMul/{}", count), count, [&] {
+            for (uint32 i = 0; i < count; i++) {
+                rotated[i] = QuatMul(rotations[i].Rotation, vectors[i]);
+            }
+            VuMicroBench::doNotOptimize(rotated.back());
+        });
+    }
+}
+
+namespace {
+    struct BenchPoolObject {
+        uint64 payload[4];
+
+        void uninit() {
+        }
+    };
+}
+
+static void benchPools(VuMicroBench& bench) {
+    //same shape as a frame worth of resource churn: allocate a batch, look every slot up, release it again
+    constexpr uint32 COUNT = 10000U;
+
+    std::vector<uint32> indices(COUNT);
+    std::vector<uint32> generations(COUNT);
+    bench.run("VuPool::allocate+get+release/10000", COUNT, [&] {
+        uint64 sum = 0U;
+        for (uint32 i = 0; i < COUNT; i++) {
+            VuPool<BenchPoolObject>::allocate(indices[i], generations[i]);
+        }
+        for (uint32 i = 0; i < COUNT; i++) {
+            sum += VuPool<BenchPoolObject>::get(indices[i], generations[i])->payload[0];
+        }
+        for (uint32 i = 0; i < COUNT; i++) {
+            VuPool<BenchPoolObject>::decreaseRefCount(indices[i]);
+        }
+        VuMicroBench::doNotOptimize(sum);
+    });
+
+    //only the block bookkeeping, the mapped buffer behind it needs a device.
+    //the batch stays within the pool's BLOCK_COUNT, allocBlock throws once it is full
+    constexpr uint32    BLOCK_BATCH = 1000U;
+    std::vector<uint32> blocks(BLOCK_BATCH);
+    bench.run("VuMaterialDataPool::allocBlock+freeBlock/1000", BLOCK_BATCH, [&] {
+        for (uint32 i = 0; i < BLOCK_BATCH; i++) {
+            blocks[i] = VuMaterialDataPool::allocBlock();
+        }
+        for (uint32 i = 0; i < BLOCK_BATCH; i++) {
+            VuMaterialDataPool::freeBlock(blocks[i]);
+        }
+        VuMicroBench::doNotOptimize(blocks.back());
+    });
+}
+
+//the accessor copies LoadGltf does for one primitive, without the optimizer and the gpu upload
+static void benchGltfAccessors(VuMicroBench& bench, const std::filesystem::path& path) {
+    //the buffers are read from their mappings, like the importer does
+    VuGltfAsset gltf{};
+    try {
+        gltf = VuAssetLoader::LoadAsset(path);
+    } catch (const std::exception& e) {
+        std::cerr << "[WARNING]: skipping gltf accessor benchmarks, " << e.what() << std::endl;
+        return;
+    }
+    const fastgltf::Asset& asset = gltf.asset;
+
+    const fastgltf::Primitive& primitive        = asset.meshes.at(0).primitives.at(0);
+    const fastgltf::Accessor&  indexAccessor    = asset.accessors[primitive.indicesAccessor.value()];
+    const fastgltf::Accessor&  positionAccessor = asset.accessors[primitive.findAttribute("POSITION")->accessorIndex];
+    const fastgltf::Accessor&  normalAccessor   = asset.accessors[primitive.findAttribute("NORMAL")->accessorIndex];
+    const fastgltf::Accessor&  uvAccessor       = asset.accessors[primitive.findAttribute("TEXCOORD_0")->accessorIndex];
+
+    VuMeshData mesh{};
+    mesh.indices.resize(indexAccessor.count);
+    mesh.positions.resize(positionAccessor.count);
+    mesh.normals.resize(positionAccessor.count);
+    mesh.uvs.resize(positionAccessor.count);
+
+    const std::string name = path.stem().string();
+    bench.run(std::format("gltf/indices/{}/{}", name, indexAccessor.count), indexAccessor.count, [&] {
+        fastgltf::iterateAccessorWithIndex<uint32>(asset, indexAccessor,
+                                                   [&](uint32 index, std::size_t idx) { mesh.indices[idx] = index; });
+        VuMicroBench::doNotOptimize(mesh.indices.back());
+    });
+    bench.run(std::format("gltf/attributes/{}/{}", name, positionAccessor.count), positionAccessor.count, [&] {
+        fastgltf::iterateAccessorWithIndex<glm::vec3>(asset, positionAccessor,
+                                                      [&](const glm::vec3 pos, std::size_t idx) { mesh.positions[idx] = pos; });
+        fastgltf::iterateAccessorWithIndex<glm::vec3>(asset, normalAccessor,
+                                                      [&](const glm::vec3 normal, std::size_t idx) { mesh.normals[idx] = normal; });
+        fastgltf::iterateAccessorWithIndex<glm::vec2>(asset, uvAccessor,
+                                                      [&](const glm::vec2 uv, std::size_t idx) { mesh.uvs[idx] = uv; });
+        VuMicroBench::doNotOptimize(mesh.uvs.back());
+    });
+}
+
+//decoding into a destination in place against the copy out of stb's own buffer, which write combined staging
+//memory and padded rows of a non readable destination still take
+static void benchImageDecode(VuMicroBench& bench, const std::filesystem::path& path) {
+    VuMappedFile file{};
+    VuImageInfo  info{};
+    try {
+        file.open(path);
+    } catch (const std::exception& e) {
+        std::cerr << "[WARNING]: skipping image decode benchmarks, " << e.what() << std::endl;
+        return;
+    }
+    if (!VuImageDecoder::readInfo(file.bytes(), info)) {
+        std::cerr << "[WARNING]: skipping image decode benchmarks, " << path.string() << " is not an image" << std::endl;
+        return;
+    }
+
+    const uint64       rowPitch = VuImageDecoder::rowPitchOf(info.width, 256U);
+    std::vector<uint8> pixels(VuImageDecoder::byteSizeOf(info, rowPitch));
+    const uint64       count = static_cast<uint64>(info.width) * info.height;
+    const std::string  name  = path.stem().string();
+    bench.run(std::format("image/decode/inPlace/{}/{}", name, count), count, [&] {
+        VuImageDecoder::decodeRGBA8(file.bytes(), info, {pixels, rowPitch, true});
+        VuMicroBench::doNotOptimize(pixels.back());
+    });
+    bench.run(std::format("image/decode/copy/{}/{}", name, count), count, [&] {
+        VuImageDecoder::decodeRGBA8(file.bytes(), info, {pixels, rowPitch, false});
+        VuMicroBench::doNotOptimize(pixels.back());
+    });
+}
+
+//the same load time and per frame work with the job system restarted at 1, 2, 4 .. N threads. 1 thread runs
+//single threaded, the difference to 1t of the benchmarks above is the job system's own cost
+static void benchJobScaling(VuMicroBench& bench) {
+    const uint32 hardwareThreads = std::max(std::thread::hardware_concurrency(), 1U);
+    std::vector<uint32> threadCounts;
+    for (uint32 threads = 1U; threads < hardwareThreads; threads *= 2U) {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(hardwareThreads);
+
+    VuMeshData   mesh        = makeGrid(1000U);
+    const uint32 vertexCount = mesh.vertexCount();
+
+    constexpr uint32             TRANSFORM_COUNT = 1000000U;
+    const std::vector<Transform> source          = makeTransforms(TRANSFORM_COUNT);
+    VuTransformStreams           streams{};
+    streams.resize(TRANSFORM_COUNT);
+    for (uint32 i = 0; i < TRANSFORM_COUNT; i++) {
+        streams.set(i, source[i]);
+    }
+    std::vector<float4x4> matrices(TRANSFORM_COUNT);
+
+    constexpr uint32 JOB_COUNT = 4096U;
+    for (uint32 threads: threadCounts) {
+        VuJobSystem::init({.workerCount = threads - 1U, .singleThreaded = threads == 1U});
+        bench.run(std::format("VuJobSystem/generateTangents/{}t/{}", threads, vertexCount), vertexCount, [&mesh] {
+            VuTangentGenerator::generateTangents(mesh.indices, mesh.positions, mesh.normals, mesh.uvs, mesh.tangents);
+            VuMicroBench::doNotOptimize(mesh.tangents.back());
+        });
+        bench.run(std::format("VuJobSystem/computeMatrices/{}t/{}", threads, TRANSFORM_COUNT), TRANSFORM_COUNT, [&] {
+            VuTransformSystem::computeMatricesParallel(streams, TRANSFORM_COUNT, matrices.data(), 0U);
+            VuMicroBench::doNotOptimize(matrices.back());
+        });
+        //cost of one job from submission to the counter reaching zero
+        bench.run(std::format("VuJobSystem/emptyJobs/{}t/{}", threads, JOB_COUNT), JOB_COUNT, [] {
+            VuJobCounter counter{};
+            for (uint32 i = 0; i < JOB_COUNT; i++) {
+                VuJobSystem::run([] {}, &counter);
+            }
+            VuJobSystem::wait(counter);
+        });
+    }
+    VuJobSystem::init({});
+}
+
+static void printUsage() {
+    std::cout << "usage: vumake_microbench [options]\n"
+            << "  --filter <text>              only run benchmarks whose name contains text\n"
+            << "  --large                      add the 10M vertex tangent benchmarks (~2 GB of memory)\n"
+            << "  --min-time <seconds>         minimum duration of one sample (0.05)\n"
+            << "  --samples <n>                timed samples per benchmark, the median is reported (7)\n"
+            << "  --json <file>                write the results\n"
+            << "  --baseline <file>            compare with an earlier --json, exits with 1 on a regression\n"
+            << "  --threshold <percent>        allowed slowdown against the baseline (10)\n";
+}
+
+int main(int argc, char* argv[]) {
+    VuMicroBench          bench{};
+    bool                  large     = false;
+    double                threshold = 10.0;
+    std::filesystem::path jsonPath;
+    std::filesystem::path baselinePath;
+
+    for (int i = 1; i < argc; i++) {
+        const bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--filter") == 0 && hasValue) {
+            bench.filter = argv[++i];
+        } else if (std::strcmp(argv[i], "--large") == 0) {
+            large = true;
+        } else if (std::strcmp(argv[i], "--min-time") == 0 && hasValue) {
+            bench.minSampleSeconds = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--samples") == 0 && hasValue) {
+            bench.sampleCount = std::max(std::atoi(argv[++i]), 1);
+        } else if (std::strcmp(argv[i], "--json") == 0 && hasValue) {
+            jsonPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--baseline") == 0 && hasValue) {
+            baselinePath = argv[++i];
+        } else if (std::strcmp(argv[i], "--threshold") == 0 && hasValue) {
+            threshold = std::atof(argv[++i]);
+        } else {
+            printUsage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    try {
+        VuJobSystem::init({});
+        benchTangents(bench, large);
+        benchTransforms(bench);
+        benchPools(bench);
+        benchGltfAccessors(bench, "assets/gltf/jet/jet.gltf");
+        benchGltfAccessors(bench, "assets/gltf/mountain/mountain.gltf");
+        benchImageDecode(bench, "assets/textures/UV_Checker.png");
+        benchJobScaling(bench);
+        VuJobSystem::uninit();
+
+        if (!jsonPath.empty()) {
+            bench.writeJson(jsonPath);
+        }
+        if (!baselinePath.empty() && bench.compareWithBaseline(baselinePath, threshold) > 0U) {
+            return EXIT_FAILURE;
+        }
+    } catch (const std::exception& e) {
+        VuJobSystem::uninit();
+        std::cerr << "[ERROR]: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
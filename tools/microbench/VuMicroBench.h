@@ -0,0 +1,148 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Common.h"
+
+namespace Vu {
+
+    struct VuMicroBenchResult {
+        std::string name;
+        //work items (vertices, transforms, allocations...) processed by one iteration
+        uint64      itemsPerIteration;
+        uint64      iterationsPerSample;
+        double      medianNsPerItem;
+        double      minNsPerItem;
+    };
+
+    //in-tree micro benchmark harness. every benchmark is calibrated until one sample takes at least
+    //minSampleSeconds, then sampleCount samples are timed and the median and minimum per item reported
+    struct VuMicroBench {
+        double                          minSampleSeconds = 0.05;
+        uint32                          sampleCount      = 7U;
+        std::string                     filter;
+        std::vector<VuMicroBenchResult> results;
+
+        //keeps the compiler from dropping a computation whose result is otherwise unused
+        template<typename T>
+        static void doNotOptimize(const T& value) {
+            static volatile const void* sink = nullptr;
+            sink                             = &value;
+            std::atomic_signal_fence(std::memory_order_seq_cst);
+        }
+
+        //run is called iterations times per sample, setup once before every sample and is not timed
+        void run(const std::string&                   name,
+                 uint64                               itemsPerIteration,
+                 const std::function<void()>&         body,
+                 const std::function<void()>&         setup = {}) {
+            if (!filter.empty() && name.find(filter) == std::string::npos) {
+                return;
+            }
+
+            uint64 iterations = 1U;
+            while (true) {
+                const double seconds = timeSample(body, setup, iterations);
+                if (seconds >= minSampleSeconds || iterations >= (1ULL << 40U)) {
+                    break;
+                }
+                //aim a bit over the target so the next round usually ends the calibration
+                const double scale = seconds > 0.0 ? minSampleSeconds * 1.2 / seconds : 10.0;
+                iterations         = std::max(iterations + 1U, static_cast<uint64>(static_cast<double>(iterations) * std::min(scale, 10.0)));
+            }
+
+            std::vector<double> nsPerItem;
+            for (uint32 i = 0; i < sampleCount; i++) {
+                const double seconds = timeSample(body, setup, iterations);
+                nsPerItem.push_back(seconds * 1e9 / static_cast<double>(iterations * itemsPerIteration));
+            }
+            std::sort(nsPerItem.begin(), nsPerItem.end());
+
+            const VuMicroBenchResult result{name, itemsPerIteration, iterations, nsPerItem[nsPerItem.size() / 2U], nsPerItem.front()};
+            std::cout << std::format("{:<44} {:>12} items {:>10.3f} ns/item {:>10.3f} min {:>10.1f} M items/s\n",
+                                     result.name, result.itemsPerIteration, result.medianNsPerItem, result.minNsPerItem,
+                                     1000.0 / result.medianNsPerItem);
+            std::cout.flush();
+            results.push_back(result);
+        }
+
+        void writeJson(const std::filesystem::path& path) const {
+            std::ofstream file(path);
+            if (!file.is_open()) {
+                throw std::runtime_error("failed to open file: " + path.string());
+            }
+            file << "{\"benchmarks\": [\n";
+            for (size_t i = 0; i < results.size(); i++) {
+                const VuMicroBenchResult& r = results[i];
+                file << std::format("  {{\"name\": \"{}\", \"items\": {}, \"iterations\": {}, \"nsPerItem\": {:.6f}, \"minNsPerItem\": {:.6f}}}{}\n",
+                                    r.name, r.itemsPerIteration, r.iterationsPerSample, r.medianNsPerItem, r.minNsPerItem,
+                                    i + 1U < results.size() ? "," : "");
+            }
+            file << "]}\n";
+        }
+
+        //compares against a json written by writeJson, returns the number of benchmarks slower by more than thresholdPercent
+        uint32 compareWithBaseline(const std::filesystem::path& path, double thresholdPercent) const {
+            const std::unordered_map<std::string, double> baseline = readBaseline(path);
+
+            uint32 regressions = 0U;
+            for (const VuMicroBenchResult& r: results) {
+                const auto it = baseline.find(r.name);
+                if (it == baseline.end() || it->second <= 0.0) {
+                    continue;
+                }
+                const double change = (r.medianNsPerItem / it->second - 1.0) * 100.0;
+                if (change > thresholdPercent) {
+                    std::cout << std::format("[WARNING]: {} regressed {:.1f}% ({:.3f} -> {:.3f} ns/item)\n",
+                                             r.name, change, it->second, r.medianNsPerItem);
+                    regressions++;
+                }
+            }
+            return regressions;
+        }
+
+    private:
+        static double timeSample(const std::function<void()>& body, const std::function<void()>& setup, uint64 iterations) {
+            if (setup) {
+                setup();
+            }
+            const auto start = std::chrono::steady_clock::now();
+            for (uint64 i = 0; i < iterations; i++) {
+                body();
+            }
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        //only understands the files writeJson produces, one benchmark per line
+        static std::unordered_map<std::string, double> readBaseline(const std::filesystem::path& path) {
+            std::ifstream file(path);
+            if (!file.is_open()) {
+                throw std::runtime_error("failed to open file: " + path.string());
+            }
+
+            std::unordered_map<std::string, double> baseline;
+            std::string                             line;
+            while (std::getline(file, line)) {
+                const size_t nameKey = line.find("\"name\": \"");
+                const size_t nsKey   = line.find("\"nsPerItem\": ");
+                if (nameKey == std::string::npos || nsKey == std::string::npos) {
+                    continue;
+                }
+                const size_t nameStart = nameKey + 9U;
+                const size_t nameEnd   = line.find('"', nameStart);
+                baseline[line.substr(nameStart, nameEnd - nameStart)] = std::stod(line.substr(nsKey + 13U));
+            }
+            return baseline;
+        }
+    };
+}
@@ -0,0 +1,182 @@
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "Common.h"
+#include "VuBlockCompression.h"
+#include "VuTextureContainer.h"
+
+using namespace Vu;
+
+enum class TextureUsage {
+    Color,
+    ColorAlpha,
+    Normal,
+    Mask,
+    Linear,
+};
+
+static bool parseUsage(const std::string& name, TextureUsage& outUsage) {
+    if (name == "color") {
+        outUsage = TextureUsage::Color;
+    } else if (name == "color_alpha") {
+        outUsage = TextureUsage::ColorAlpha;
+    } else if (name == "normal") {
+        outUsage = TextureUsage::Normal;
+    } else if (name == "mask") {
+        outUsage = TextureUsage::Mask;
+    } else if (name == "linear") {
+        outUsage = TextureUsage::Linear;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static VkFormat selectFormat(TextureUsage usage, bool uncompressed) {
+    const bool srgb = usage == TextureUsage::Color || usage == TextureUsage::ColorAlpha;
+    if (uncompressed) {
+        return srgb ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+    }
+    switch (usage) {
+        case TextureUsage::Color:
+            return VK_FORMAT_BC1_RGB_SRGB_BLOCK;
+        case TextureUsage::ColorAlpha:
+            return VK_FORMAT_BC7_SRGB_BLOCK;
+        case TextureUsage::Normal:
+            return VK_FORMAT_BC5_UNORM_BLOCK;
+        case TextureUsage::Mask:
+            return VK_FORMAT_BC4_UNORM_BLOCK;
+        case TextureUsage::Linear:
+            return VK_FORMAT_BC7_UNORM_BLOCK;
+    }
+    return VK_FORMAT_UNDEFINED;
+}
+
+//box filtering shortens normals, bring every texel back to unit length before encoding
+static void renormalize(std::vector<uint8>& rgba) {
+    for (size_t i = 0U; i < rgba.size(); i += 4U) {
+        float x      = static_cast<float>(rgba[i + 0U]) / 127.5F - 1.0F;
+        float y      = static_cast<float>(rgba[i + 1U]) / 127.5F - 1.0F;
+        float z      = static_cast<float>(rgba[i + 2U]) / 127.5F - 1.0F;
+        float length = std::sqrt(x * x + y * y + z * z);
+        if (length < 1e-6F) {
+            x      = 0.0F;
+            y      = 0.0F;
+            z      = 1.0F;
+            length = 1.0F;
+        }
+        rgba[i + 0U] = static_cast<uint8>(std::clamp((x / length + 1.0F) * 127.5F + 0.5F, 0.0F, 255.0F));
+        rgba[i + 1U] = static_cast<uint8>(std::clamp((y / length + 1.0F) * 127.5F + 0.5F, 0.0F, 255.0F));
+        rgba[i + 2U] = static_cast<uint8>(std::clamp((z / length + 1.0F) * 127.5F + 0.5F, 0.0F, 255.0F));
+    }
+}
+
+static std::vector<uint8> encodeLevel(VkFormat format, std::span<const uint8> rgba, uint32 width, uint32 height) {
+    switch (format) {
+        case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+            return VuBlockCompression::encodeImage(rgba, width, height, 8U, [](const VuBlockCompression::Block& block, uint8* out) {
+                VuBlockCompression::encodeBC1(block, out);
+            });
+        case VK_FORMAT_BC4_UNORM_BLOCK:
+            return VuBlockCompression::encodeImage(rgba, width, height, 8U, [](const VuBlockCompression::Block& block, uint8* out) {
+                VuBlockCompression::encodeBC4(block, 0U, out);
+            });
+        case VK_FORMAT_BC5_UNORM_BLOCK:
+            return VuBlockCompression::encodeImage(rgba, width, height, 16U, [](const VuBlockCompression::Block& block, uint8* out) {
+                VuBlockCompression::encodeBC5(block, out);
+            });
+        case VK_FORMAT_BC7_SRGB_BLOCK:
+        case VK_FORMAT_BC7_UNORM_BLOCK:
+            return VuBlockCompression::encodeImage(rgba, width, height, 16U, [](const VuBlockCompression::Block& block, uint8* out) {
+                VuBlockCompression::encodeBC7(block, out);
+            });
+        default:
+            return {rgba.begin(), rgba.end()};
+    }
+}
+
+static void printUsage() {
+    std::cout << "usage: VuTextureBaker <input image> <output.vutex> [--usage color|color_alpha|normal|mask|linear] [--uncompressed]"
+            << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
+    const std::filesystem::path inputPath    = argv[1];
+    const std::filesystem::path outputPath   = argv[2];
+    TextureUsage                usage        = TextureUsage::Color;
+    bool                        uncompressed = false;
+
+    for (int i = 3; i < argc; i++) {
+        if (std::strcmp(argv[i], "--usage") == 0 && i + 1 < argc) {
+            if (!parseUsage(argv[++i], usage)) {
+                printUsage();
+                return EXIT_FAILURE;
+            }
+        } else if (std::strcmp(argv[i], "--uncompressed") == 0) {
+            uncompressed = true;
+        } else {
+            printUsage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    int      texWidth;
+    int      texHeight;
+    int      texChannels;
+    stbi_uc* pixels = stbi_load(inputPath.string().c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
+    if (pixels == nullptr) {
+        std::cout << "failed to load image: " << inputPath << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    auto               width  = static_cast<uint32>(texWidth);
+    auto               height = static_cast<uint32>(texHeight);
+    std::vector<uint8> level(pixels, pixels + static_cast<size_t>(width) * height * 4U);
+    stbi_image_free(pixels);
+
+    const VkFormat format = selectFormat(usage, uncompressed);
+    const bool     srgb   = usage == TextureUsage::Color || usage == TextureUsage::ColorAlpha;
+
+    try {
+        std::vector<std::vector<uint8>> mipData;
+        uint32                          mipWidth  = width;
+        uint32                          mipHeight = height;
+        while (true) {
+            mipData.push_back(encodeLevel(format, level, mipWidth, mipHeight));
+            if (mipWidth == 1U && mipHeight == 1U) {
+                break;
+            }
+            level = VuTextureContainer::downsampleRGBA8(level, mipWidth, mipHeight, srgb);
+            if (usage == TextureUsage::Normal) {
+                renormalize(level);
+            }
+            mipWidth  = std::max(mipWidth / 2U, 1U);
+            mipHeight = std::max(mipHeight / 2U, 1U);
+        }
+
+        VuTextureContainer::write(outputPath, format, width, height, mipData);
+
+        uint64 totalSize = 0U;
+        for (const std::vector<uint8>& mip: mipData) {
+            totalSize += mip.size();
+        }
+        std::cout << inputPath.string() << " -> " << outputPath.string()
+                << " " << width << "x" << height
+                << " mips: " << mipData.size()
+                << " bytes: " << totalSize
+                << " (rgba8: " << static_cast<uint64>(width) * height * 4U << " base level)" << std::endl;
+    } catch (const std::exception& e) {
+        std::puts(e.what());
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
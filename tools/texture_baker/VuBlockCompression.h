@@ -0,0 +1,339 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include "Common.h"
+
+namespace Vu {
+
+    //4x4 block encoders, every encoder takes 16 RGBA8 texels in row order
+    struct VuBlockCompression {
+        using Block = std::array<uint8, 64>;
+
+        //range fit along the principal axis, always emits the opaque 4 color mode
+        static void encodeBC1(const Block& texels, uint8* out) {
+            std::array<float, 3> axis = principalAxis<3>(texels);
+            std::array<float, 3> mean = channelMean<3>(texels);
+
+            float minProj = MAX_ERROR;
+            float maxProj = -MAX_ERROR;
+            for (uint32 i = 0U; i < 16U; i++) {
+                float proj = 0.0F;
+                for (uint32 c = 0U; c < 3U; c++) {
+                    proj += (static_cast<float>(texels[i * 4U + c]) - mean[c]) * axis[c];
+                }
+                minProj = std::min(minProj, proj);
+                maxProj = std::max(maxProj, proj);
+            }
+
+            std::array<float, 3> maxColor{};
+            std::array<float, 3> minColor{};
+            for (uint32 c = 0U; c < 3U; c++) {
+                maxColor[c] = mean[c] + axis[c] * maxProj;
+                minColor[c] = mean[c] + axis[c] * minProj;
+            }
+
+            uint16 color0 = packRGB565(maxColor);
+            uint16 color1 = packRGB565(minColor);
+            if (color0 < color1) {
+                std::swap(color0, color1);
+            }
+
+            std::array<std::array<float, 3>, 4> palette{};
+            palette[0] = unpackRGB565(color0);
+            palette[1] = unpackRGB565(color1);
+            for (uint32 c = 0U; c < 3U; c++) {
+                palette[2][c] = (2.0F * palette[0][c] + palette[1][c]) / 3.0F;
+                palette[3][c] = (palette[0][c] + 2.0F * palette[1][c]) / 3.0F;
+            }
+
+            uint32 indices = 0U;
+            if (color0 != color1) {
+                for (uint32 i = 0U; i < 16U; i++) {
+                    uint32 best      = 0U;
+                    float  bestError = MAX_ERROR;
+                    for (uint32 p = 0U; p < 4U; p++) {
+                        float error = 0.0F;
+                        for (uint32 c = 0U; c < 3U; c++) {
+                            float d = static_cast<float>(texels[i * 4U + c]) - palette[p][c];
+                            error += d * d;
+                        }
+                        if (error < bestError) {
+                            bestError = error;
+                            best      = p;
+                        }
+                    }
+                    indices |= best << (i * 2U);
+                }
+            }
+
+            std::memcpy(out, &color0, 2);
+            std::memcpy(out + 2, &color1, 2);
+            std::memcpy(out + 4, &indices, 4);
+        }
+
+        //single channel, 8 value interpolation mode
+        static void encodeBC4(const Block& texels, uint32 channel, uint8* out) {
+            uint8 maxValue = 0U;
+            uint8 minValue = 255U;
+            for (uint32 i = 0U; i < 16U; i++) {
+                maxValue = std::max(maxValue, texels[i * 4U + channel]);
+                minValue = std::min(minValue, texels[i * 4U + channel]);
+            }
+
+            out[0] = maxValue;
+            out[1] = minValue;
+
+            uint64 indices = 0U;
+            if (maxValue != minValue) {
+                std::array<float, 8> palette{};
+                palette[0] = maxValue;
+                palette[1] = minValue;
+                for (uint32 p = 1U; p < 7U; p++) {
+                    palette[p + 1U] = (static_cast<float>(7U - p) * maxValue + static_cast<float>(p) * minValue) / 7.0F;
+                }
+
+                for (uint32 i = 0U; i < 16U; i++) {
+                    uint64 best      = 0U;
+                    float  bestError = MAX_ERROR;
+                    for (uint32 p = 0U; p < 8U; p++) {
+                        float error = std::abs(static_cast<float>(texels[i * 4U + channel]) - palette[p]);
+                        if (error < bestError) {
+                            bestError = error;
+                            best      = p;
+                        }
+                    }
+                    indices |= best << (i * 3U);
+                }
+            }
+            for (uint32 b = 0U; b < 6U; b++) {
+                out[2U + b] = static_cast<uint8>(indices >> (b * 8U));
+            }
+        }
+
+        //two BC4 blocks holding the tangent space X and Y, Z is rebuilt in the shader
+        static void encodeBC5(const Block& texels, uint8* out) {
+            encodeBC4(texels, 0U, out);
+            encodeBC4(texels, 1U, out + 8);
+        }
+
+        //mode 6 only: single subset RGBA, 7 bit endpoints with unique p-bits and 4 bit indices
+        static void encodeBC7(const Block& texels, uint8* out) {
+            std::array<float, 4> axis = principalAxis<4>(texels);
+            std::array<float, 4> mean = channelMean<4>(texels);
+
+            float minProj = MAX_ERROR;
+            float maxProj = -MAX_ERROR;
+            for (uint32 i = 0U; i < 16U; i++) {
+                float proj = 0.0F;
+                for (uint32 c = 0U; c < 4U; c++) {
+                    proj += (static_cast<float>(texels[i * 4U + c]) - mean[c]) * axis[c];
+                }
+                minProj = std::min(minProj, proj);
+                maxProj = std::max(maxProj, proj);
+            }
+
+            std::array<std::array<uint8, 4>, 2> endpoints7{};
+            std::array<uint8, 2>                pBits{};
+            for (uint32 e = 0U; e < 2U; e++) {
+                const float           proj = e == 0U ? minProj : maxProj;
+                std::array<float, 4> target{};
+                for (uint32 c = 0U; c < 4U; c++) {
+                    target[c] = std::clamp(mean[c] + axis[c] * proj, 0.0F, 255.0F);
+                }
+
+                float bestError = MAX_ERROR;
+                for (uint8 p = 0U; p < 2U; p++) {
+                    std::array<uint8, 4> candidate{};
+                    float                error = 0.0F;
+                    for (uint32 c = 0U; c < 4U; c++) {
+                        candidate[c] = static_cast<uint8>(std::clamp(std::round((target[c] - p) / 2.0F), 0.0F, 127.0F));
+                        float d      = static_cast<float>((candidate[c] << 1U) | p) - target[c];
+                        error += d * d;
+                    }
+                    if (error < bestError) {
+                        bestError     = error;
+                        endpoints7[e] = candidate;
+                        pBits[e]      = p;
+                    }
+                }
+            }
+
+            std::array<std::array<float, 4>, 16> palette{};
+            for (uint32 p = 0U; p < 16U; p++) {
+                for (uint32 c = 0U; c < 4U; c++) {
+                    const uint32 e0 = (endpoints7[0][c] << 1U) | pBits[0];
+                    const uint32 e1 = (endpoints7[1][c] << 1U) | pBits[1];
+                    palette[p][c]   = static_cast<float>(((64U - BC7_WEIGHTS4[p]) * e0 + BC7_WEIGHTS4[p] * e1 + 32U) >> 6U);
+                }
+            }
+
+            std::array<uint8, 16> indices{};
+            for (uint32 i = 0U; i < 16U; i++) {
+                float bestError = MAX_ERROR;
+                for (uint8 p = 0U; p < 16U; p++) {
+                    float error = 0.0F;
+                    for (uint32 c = 0U; c < 4U; c++) {
+                        float d = static_cast<float>(texels[i * 4U + c]) - palette[p][c];
+                        error += d * d;
+                    }
+                    if (error < bestError) {
+                        bestError  = error;
+                        indices[i] = p;
+                    }
+                }
+            }
+
+            //the anchor index is stored with an implicit zero msb
+            if (indices[0] >= 8U) {
+                std::swap(endpoints7[0], endpoints7[1]);
+                std::swap(pBits[0], pBits[1]);
+                for (uint8& index: indices) {
+                    index = static_cast<uint8>(15U - index);
+                }
+            }
+
+            BitWriter writer{out};
+            std::memset(out, 0, 16);
+            writer.write(1U << 6U, 7U);
+            for (uint32 c = 0U; c < 4U; c++) {
+                writer.write(endpoints7[0][c], 7U);
+                writer.write(endpoints7[1][c], 7U);
+            }
+            writer.write(pBits[0], 1U);
+            writer.write(pBits[1], 1U);
+            writer.write(indices[0], 3U);
+            for (uint32 i = 1U; i < 16U; i++) {
+                writer.write(indices[i], 4U);
+            }
+        }
+
+        //reads the 4x4 block at (bx, by), edge texels are clamped
+        static Block fetchBlock(std::span<const uint8> rgba, uint32 width, uint32 height, uint32 bx, uint32 by) {
+            Block block{};
+            for (uint32 y = 0U; y < 4U; y++) {
+                for (uint32 x = 0U; x < 4U; x++) {
+                    const uint32 sx = std::min(bx * 4U + x, width - 1U);
+                    const uint32 sy = std::min(by * 4U + y, height - 1U);
+                    std::memcpy(&block[(y * 4U + x) * 4U], &rgba[(static_cast<size_t>(sy) * width + sx) * 4U], 4);
+                }
+            }
+            return block;
+        }
+
+        //compresses a whole RGBA8 level, blockSize is 8 for BC1/BC4 and 16 for BC5/BC7
+        template<typename TEncoder>
+        static std::vector<uint8> encodeImage(std::span<const uint8> rgba, uint32 width, uint32 height, uint32 blockSize, TEncoder encoder) {
+            const uint32       blocksX = (width + 3U) / 4U;
+            const uint32       blocksY = (height + 3U) / 4U;
+            std::vector<uint8> result(static_cast<size_t>(blocksX) * blocksY * blockSize);
+            for (uint32 by = 0U; by < blocksY; by++) {
+                for (uint32 bx = 0U; bx < blocksX; bx++) {
+                    encoder(fetchBlock(rgba, width, height, bx, by), &result[(static_cast<size_t>(by) * blocksX + bx) * blockSize]);
+                }
+            }
+            return result;
+        }
+
+    private:
+        static constexpr std::array<uint32, 16> BC7_WEIGHTS4 = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+        static constexpr float                  MAX_ERROR    = std::numeric_limits<float>::max();
+
+        struct BitWriter {
+            uint8* data;
+            uint32 bitOffset = 0U;
+
+            void write(uint32 value, uint32 bitCount) {
+                for (uint32 b = 0U; b < bitCount; b++) {
+                    if ((value >> b) & 1U) {
+                        data[bitOffset >> 3U] |= static_cast<uint8>(1U << (bitOffset & 7U));
+                    }
+                    bitOffset++;
+                }
+            }
+        };
+
+        template<uint32 N>
+        static std::array<float, N> channelMean(const Block& texels) {
+            std::array<float, N> mean{};
+            for (uint32 i = 0U; i < 16U; i++) {
+                for (uint32 c = 0U; c < N; c++) {
+                    mean[c] += static_cast<float>(texels[i * 4U + c]) / 16.0F;
+                }
+            }
+            return mean;
+        }
+
+        //dominant eigenvector of the covariance matrix through power iteration
+        template<uint32 N>
+        static std::array<float, N> principalAxis(const Block& texels) {
+            std::array<float, N> mean = channelMean<N>(texels);
+
+            std::array<std::array<float, N>, N> covariance{};
+            for (uint32 i = 0U; i < 16U; i++) {
+                for (uint32 a = 0U; a < N; a++) {
+                    for (uint32 b = 0U; b < N; b++) {
+                        covariance[a][b] += (static_cast<float>(texels[i * 4U + a]) - mean[a])
+                                * (static_cast<float>(texels[i * 4U + b]) - mean[b]);
+                    }
+                }
+            }
+
+            std::array<float, N> axis{};
+            axis.fill(1.0F);
+            for (uint32 iteration = 0U; iteration < 8U; iteration++) {
+                std::array<float, N> next{};
+                for (uint32 a = 0U; a < N; a++) {
+                    for (uint32 b = 0U; b < N; b++) {
+                        next[a] += covariance[a][b] * axis[b];
+                    }
+                }
+                float length = 0.0F;
+                for (float v: next) {
+                    length += v * v;
+                }
+                length = std::sqrt(length);
+                if (length < 1e-6F) {
+                    break;
+                }
+                for (uint32 a = 0U; a < N; a++) {
+                    axis[a] = next[a] / length;
+                }
+            }
+
+            float length = 0.0F;
+            for (float v: axis) {
+                length += v * v;
+            }
+            length = std::sqrt(length);
+            for (float& v: axis) {
+                v /= length;
+            }
+            return axis;
+        }
+
+        static uint16 packRGB565(const std::array<float, 3>& color) {
+            const auto r = static_cast<uint16>(std::clamp(std::round(color[0] * 31.0F / 255.0F), 0.0F, 31.0F));
+            const auto g = static_cast<uint16>(std::clamp(std::round(color[1] * 63.0F / 255.0F), 0.0F, 63.0F));
+            const auto b = static_cast<uint16>(std::clamp(std::round(color[2] * 31.0F / 255.0F), 0.0F, 31.0F));
+            return static_cast<uint16>((r << 11U) | (g << 5U) | b);
+        }
+
+        static std::array<float, 3> unpackRGB565(uint16 color) {
+            const uint32 r = (color >> 11U) & 31U;
+            const uint32 g = (color >> 5U) & 63U;
+            const uint32 b = color & 31U;
+            return {
+                static_cast<float>((r << 3U) | (r >> 2U)),
+                static_cast<float>((g << 2U) | (g >> 4U)),
+                static_cast<float>((b << 3U) | (b >> 2U))
+            };
+        }
+    };
+}